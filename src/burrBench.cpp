@@ -0,0 +1,662 @@
+/* BurrTools
+ *
+ * BurrTools is the legal property of its developers, whose
+ * names are listed in the COPYRIGHT file, which is included
+ * within the source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+/* benchmarks for the library. Each benchmark is selected by the first
+ * parameter, the remaining parameters depend on the benchmark
+ */
+
+#include "lib/puzzle.h"
+#include "lib/problem.h"
+#include "lib/assembly.h"
+#include "lib/solution.h"
+#include "lib/disassembly.h"
+#include "lib/disassembler_0.h"
+#include "lib/disassembler_1.h"
+#include "lib/disassemblernode.h"
+#include "lib/disassemblerhashes.h"
+#include "lib/movementanalysator.h"
+#include "lib/bt_assert.h"
+#include "tools/xml.h"
+#include "tools/gzstream.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include <queue>
+
+static double now(void) {
+  struct timeval tv;
+  gettimeofday(&tv, 0);
+  return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+static void usage(void) {
+
+  printf("burrBench benchmark [options] [files]\n\n");
+  printf("  disassemble file...\n");
+  printf("    disassemble the saved solutions of all problems of the given puzzle files with\n");
+  printf("    the breadth first (disassembler_0_c) and the A* disassembler (disassembler_1_c)\n");
+  printf("    and compare the number of examined nodes\n");
+  printf("  hash file...\n");
+  printf("    collect the positions reachable from the saved solutions of the given puzzle files\n");
+  printf("    and time the node hashtable against a chained hashtable\n");
+  printf("  node file...\n");
+  printf("    collect the positions like hash does and time the hash calculation and the comparison\n");
+  printf("    of the nodes against the scalar versions and the hashtable with new nodes\n");
+}
+
+/* disassembles all the saved assemblies of the problem with the disassembler and
+ * returns the number of examined nodes, the number of disassemblies found and the
+ * moves of the first separation of each assembly in moves
+ */
+static unsigned long runDisassembler(disassembler_a_c * d, const problem_c * problem,
+    unsigned int * found, std::vector<unsigned int> & moves, double * time) {
+
+  double start = now();
+
+  *found = 0;
+  moves.clear();
+
+  for (unsigned int sol = 0; sol < problem->getNumberOfSavedSolutions(); sol++) {
+
+    const assembly_c * a = problem->getSavedSolution(sol)->getAssembly();
+
+    if (!a) continue;
+
+    separation_c * da = d->disassemble(a);
+
+    if (da) {
+      (*found)++;
+      moves.push_back(da->getMoves());
+      delete da;
+    } else
+      moves.push_back(0);
+  }
+
+  *time = now() - start;
+
+  return d->getNodeCount();
+}
+
+static int benchDisassemble(int argc, char * argv[]) {
+
+  unsigned long total0 = 0, total1 = 0;
+  double time0 = 0, time1 = 0;
+  int differ = 0;
+
+  printf("%-30s %-20s %6s %12s %12s %7s\n", "file", "problem", "assm", "bfs nodes", "A* nodes", "ratio");
+
+  for (int f = 0; f < argc; f++) {
+
+    std::istream * str = openGzFile(argv[f]);
+    xmlParser_c pars(*str);
+    puzzle_c p(pars);
+    delete str;
+
+    const char * name = strrchr(argv[f], '/');
+    name = name ? name+1 : argv[f];
+
+    for (unsigned int pr = 0; pr < p.getNumberOfProblems(); pr++) {
+
+      const problem_c * problem = p.getProblem(pr);
+
+      if (problem->getNumberOfSavedSolutions() == 0)
+        continue;
+
+      unsigned int found0, found1;
+      std::vector<unsigned int> moves0, moves1;
+      double t0, t1;
+      unsigned long n0, n1;
+
+      try {
+
+        disassembler_0_c d0(*problem);
+        n0 = runDisassembler(&d0, problem, &found0, moves0, &t0);
+
+        disassembler_1_c d1(*problem);
+        n1 = runDisassembler(&d1, problem, &found1, moves1, &t1);
+      }
+
+      catch (assert_exception & a) {
+        // some grids have no movement analysis, skip those problems
+        printf("%-30.30s %-20.20s assert %s in %s:%u\n", name, problem->getName().c_str(), a.expr, a.file, a.line);
+        continue;
+      }
+
+      printf("%-30.30s %-20.20s %6u %12lu %12lu %6.1f%%",
+          name, problem->getName().c_str(), (unsigned int)moves0.size(), n0, n1, n0 ? 100.0*n1/n0 : 100.0);
+
+      /* both searches must find separations with the same number of moves, only
+       * the disassemblies of the sub problems may differ, as the two may
+       * have selected different separations
+       */
+      for (unsigned int i = 0; i < moves0.size(); i++)
+        if (moves0[i] && moves1[i] && moves0[i] != moves1[i]) {
+          printf(" first separation differs for assembly %u: %u and %u moves", i+1, moves0[i], moves1[i]);
+          differ++;
+          break;
+        }
+
+      if (found0 != found1)
+        printf(" disassemblies found: %u and %u", found0, found1);
+
+      printf("\n");
+
+      total0 += n0;
+      total1 += n1;
+      time0 += t0;
+      time1 += t1;
+    }
+  }
+
+  printf("\ntotal nodes: bfs %lu in %.2fs, A* %lu in %.2fs (%.1f%%)\n",
+      total0, time0, total1, time1, total0 ? 100.0*total1/total0 : 100.0);
+
+  return differ ? 1 : 0;
+}
+
+/* the chained hashtable the disassembler used before the open addressing
+ * table, it is kept here to compare the two
+ */
+class chainedNodeHash {
+
+  private:
+
+    struct hashNode {
+      disassemblerNode_c * dat;
+      hashNode * next;
+    };
+
+    unsigned long tab_size;
+    unsigned long tab_entries;
+    hashNode ** tab;
+
+  public:
+
+    chainedNodeHash(void) : tab_size(11), tab_entries(0) {
+      tab = new hashNode * [tab_size];
+      memset(tab, 0, tab_size*sizeof(hashNode*));
+    }
+
+    ~chainedNodeHash(void) {
+      for (unsigned long i = 0; i < tab_size; i++)
+        while (tab[i]) {
+          hashNode * hn = tab[i];
+          tab[i] = hn->next;
+          delete hn;
+        }
+      delete [] tab;
+    }
+
+    bool contains(const disassemblerNode_c * n) const {
+      for (hashNode * hn = tab[n->hash() % tab_size]; hn; hn = hn->next)
+        if (*(hn->dat) == *n)
+          return true;
+      return false;
+    }
+
+    bool insert(disassemblerNode_c * n) {
+
+      unsigned long h = n->hash() % tab_size;
+
+      for (hashNode * hn = tab[h]; hn; hn = hn->next)
+        if (*(hn->dat) == *n)
+          return true;
+
+      hashNode * hn = new hashNode;
+      hn->dat = n;
+      hn->next = tab[h];
+      tab[h] = hn;
+      tab_entries++;
+
+      if (tab_entries > tab_size) {
+
+        unsigned long new_size = tab_size * 4 + 1;
+        hashNode ** new_tab = new hashNode * [new_size];
+        memset(new_tab, 0, new_size*sizeof(hashNode*));
+
+        for (unsigned long i = 0; i < tab_size; i++)
+          while (tab[i]) {
+            hashNode * hn = tab[i];
+            tab[i] = hn->next;
+            unsigned long h = hn->dat->hash() % new_size;
+            hn->next = new_tab[h];
+            new_tab[h] = hn;
+          }
+
+        delete [] tab;
+        tab = new_tab;
+        tab_size = new_size;
+      }
+
+      return false;
+    }
+};
+
+/* collects up to limit positions that can be reached from the first saved
+ * assembly of the problem with a breadth first search, the
+ * positions are added to nodes, the caller must free them
+ */
+static void collectNodes(const problem_c * problem, std::vector<disassemblerNode_c *> & nodes, unsigned long limit) {
+
+  const assembly_c * a = 0;
+
+  for (unsigned int sol = 0; sol < problem->getNumberOfSavedSolutions() && !a; sol++)
+    a = problem->getSavedSolution(sol)->getAssembly();
+
+  if (!a) return;
+
+  movementAnalysator_c analyse(*problem);
+
+  disassemblerNode_c * start = disassemblerNode_c::create(a);
+
+  std::vector<unsigned int> pieces;
+  for (unsigned int j = 0; j < a->placementCount(); j++)
+    if (a->isPlaced(j))
+      pieces.push_back(j);
+
+  nodeHash seen;
+  std::queue<disassemblerNode_c *> open;
+
+  seen.insert(start);
+  open.push(start);
+
+  if (start->decRefCount())
+    delete start;
+
+  while (!open.empty() && nodes.size() < limit) {
+
+    analyse.init_find(open.front(), pieces);
+    open.pop();
+
+    disassemblerNode_c * st;
+
+    while ((st = analyse.find())) {
+
+      if (st->is_separation()) {
+
+        /* the search behind a separation can take very long and the
+         * disassembler never does it, so we don't either
+         */
+        if (st->decRefCount())
+          delete st;
+        break;
+      }
+
+      if (seen.insert(st) || nodes.size() >= limit) {
+        if (st->decRefCount())
+          delete st;
+        continue;
+      }
+
+      // the reference of st goes to the nodes vector
+      nodes.push_back(st);
+      open.push(st);
+    }
+  }
+}
+
+/* inserts the first half of the nodes into an empty table and then looks up all
+ * nodes, so half of the lookups find their node, returns the time in seconds
+ */
+template <class T>
+static double timeTable(const std::vector<disassemblerNode_c *> & nodes, unsigned int rounds, unsigned long * found) {
+
+  double start = now();
+
+  *found = 0;
+
+  for (unsigned int r = 0; r < rounds; r++) {
+
+    T tab;
+
+    for (unsigned long i = 0; i < nodes.size()/2; i++)
+      tab.insert(nodes[i]);
+
+    for (unsigned long i = 0; i < nodes.size(); i++)
+      if (tab.contains(nodes[i]))
+        (*found)++;
+  }
+
+  return now() - start;
+}
+
+/* the nodes must not be changed by the table, so the open addressing table
+ * is used directly and not nodeHash, which uses the reference counts
+ */
+class openNodeHash {
+
+  private:
+
+    nodeTable_c tab;
+
+  public:
+
+    bool contains(const disassemblerNode_c * n) const { return tab.find(n) != 0; }
+    bool insert(disassemblerNode_c * n) { return tab.insert(n) != 0; }
+};
+
+static int benchHash(int argc, char * argv[]) {
+
+  static const unsigned long limit = 200000;
+  static const unsigned int rounds = 5;
+
+  printf("%-30s %-20s %8s %12s %12s %7s\n", "file", "problem", "nodes", "chained ns", "open ns", "ratio");
+
+  double totalChained = 0, totalOpen = 0;
+  int differ = 0;
+
+  for (int f = 0; f < argc; f++) {
+
+    std::istream * str = openGzFile(argv[f]);
+    xmlParser_c pars(*str);
+    puzzle_c p(pars);
+    delete str;
+
+    const char * name = strrchr(argv[f], '/');
+    name = name ? name+1 : argv[f];
+
+    for (unsigned int pr = 0; pr < p.getNumberOfProblems(); pr++) {
+
+      const problem_c * problem = p.getProblem(pr);
+
+      if (problem->getNumberOfSavedSolutions() == 0)
+        continue;
+
+      std::vector<disassemblerNode_c *> nodes;
+
+      try {
+        collectNodes(problem, nodes, limit);
+      }
+
+      catch (assert_exception & a) {
+        // some grids have no movement analysis, skip those problems
+        printf("%-30.30s %-20.20s assert %s in %s:%u\n", name, problem->getName().c_str(), a.expr, a.file, a.line);
+        continue;
+      }
+
+      // calculate the hash values before the timing, the nodes keep them
+      for (unsigned long i = 0; i < nodes.size(); i++)
+        nodes[i]->hash();
+
+      unsigned long foundChained, foundOpen;
+
+      double tc = timeTable<chainedNodeHash>(nodes, rounds, &foundChained);
+      double to = timeTable<openNodeHash>(nodes, rounds, &foundOpen);
+
+      // each round does one insert for half of the nodes and one lookup for all nodes
+      double ops = rounds * (nodes.size() + nodes.size()/2);
+
+      if (ops > 0)
+        printf("%-30.30s %-20.20s %8lu %12.1f %12.1f %6.1f%%", name, problem->getName().c_str(),
+            (unsigned long)nodes.size(), 1e9*tc/ops, 1e9*to/ops, tc > 0 ? 100.0*to/tc : 100.0);
+
+      if (foundChained != foundOpen) {
+        printf(" lookups differ: %lu and %lu", foundChained, foundOpen);
+        differ++;
+      }
+
+      if (ops > 0)
+        printf("\n");
+
+      totalChained += tc;
+      totalOpen += to;
+
+      for (unsigned long i = 0; i < nodes.size(); i++)
+        if (nodes[i]->decRefCount())
+          delete nodes[i];
+    }
+  }
+
+  printf("\ntotal time: chained %.3fs, open addressing %.3fs (%.1f%%)\n",
+      totalChained, totalOpen, totalChained > 0 ? 100.0*totalOpen/totalChained : 100.0);
+
+  return differ ? 1 : 0;
+}
+
+/* the hash calculation of the nodes before it worked on the words of the
+ * compact format, it is kept here to compare the two
+ */
+static unsigned int scalarHash(const disassemblerNode_c * n) {
+
+  unsigned int h = 0x17fe3b3c;
+
+  h += n->getTrans(0);
+
+  for (unsigned int i = 1; i < n->getPiecenumber(); i++) {
+    h += n->getX(i) - n->getX(0);
+    h *= 1343;
+    h += n->getY(i) - n->getY(0);
+    h *= 923;
+    h += n->getZ(i) - n->getZ(0);
+    h *= 113;
+    h += n->getTrans(i);
+    h *= 23;
+  }
+
+  if (h == 0) h = 1;
+
+  return h;
+}
+
+/* the comparison of the nodes piece by piece, it is kept here to compare */
+static bool scalarEquals(const disassemblerNode_c * a, const disassemblerNode_c * b) {
+
+  if (a->getTrans(0) != b->getTrans(0)) return false;
+
+  for (unsigned int i = 1; i < a->getPiecenumber(); i++) {
+    if (a->getX(i) - a->getX(0) != b->getX(i) - b->getX(0)) return false;
+    if (a->getY(i) - a->getY(0) != b->getY(i) - b->getY(0)) return false;
+    if (a->getZ(i) - a->getZ(0) != b->getZ(i) - b->getZ(0)) return false;
+    if (a->getTrans(i) != b->getTrans(i)) return false;
+  }
+
+  return true;
+}
+
+/* fresh nodes with the same positions as the given ones, they don't know their hash value, yet */
+static void copyNodes(nodePool_c & pool, const std::vector<disassemblerNode_c *> & nodes, std::vector<disassemblerNode_c *> & copies) {
+
+  copies.clear();
+
+  for (unsigned long i = 0; i < nodes.size(); i++) {
+
+    const disassemblerNode_c * n = nodes[i];
+    unsigned int pn = n->getPiecenumber();
+    std::vector<int16_t> pos(4*pn);
+
+    for (unsigned int j = 0; j < pn; j++) {
+      pos[4*j+0] = n->getX(j);
+      pos[4*j+1] = n->getY(j);
+      pos[4*j+2] = n->getZ(j);
+      pos[4*j+3] = n->getTrans(j);
+    }
+
+    copies.push_back(disassemblerNode_c::create(&pool, pn, const_cast<disassemblerNode_c *>(n->getComefrom()),
+          n->getDirection(), n->getAmount(), &pos[0]));
+  }
+}
+
+static void freeNodes(std::vector<disassemblerNode_c *> & nodes) {
+
+  for (unsigned long i = 0; i < nodes.size(); i++)
+    if (nodes[i]->decRefCount())
+      delete nodes[i];
+
+  nodes.clear();
+}
+
+static int benchNode(int argc, char * argv[]) {
+
+  static const unsigned long limit = 200000;
+  static const unsigned int rounds = 5;
+
+  printf("%-30s %-20s %8s %9s %9s %9s %9s %9s\n", "file", "problem", "nodes",
+      "scalar h", "hash", "scalar ==", "==", "table");
+
+  double totalScalarHash = 0, totalHash = 0, totalScalarEq = 0, totalEq = 0, totalTable = 0;
+  double totalNodes = 0;
+  int differ = 0;
+
+  for (int f = 0; f < argc; f++) {
+
+    std::istream * str = openGzFile(argv[f]);
+    xmlParser_c pars(*str);
+    puzzle_c p(pars);
+    delete str;
+
+    const char * name = strrchr(argv[f], '/');
+    name = name ? name+1 : argv[f];
+
+    for (unsigned int pr = 0; pr < p.getNumberOfProblems(); pr++) {
+
+      const problem_c * problem = p.getProblem(pr);
+
+      if (problem->getNumberOfSavedSolutions() == 0)
+        continue;
+
+      std::vector<disassemblerNode_c *> nodes;
+
+      try {
+        collectNodes(problem, nodes, limit);
+      }
+
+      catch (assert_exception & a) {
+        // some grids have no movement analysis, skip those problems
+        printf("%-30.30s %-20.20s assert %s in %s:%u\n", name, problem->getName().c_str(), a.expr, a.file, a.line);
+        continue;
+      }
+
+      if (nodes.empty())
+        continue;
+
+      nodePool_c pool;
+      std::vector<disassemblerNode_c *> copies;
+
+      double tsh = 0, th = 0, tse = 0, te = 0, tt = 0;
+      unsigned int sum = 0;
+      unsigned long equal = 0, scalarEqual = 0, found = 0;
+
+      for (unsigned int r = 0; r < rounds; r++) {
+
+        copyNodes(pool, nodes, copies);
+
+        double start = now();
+        for (unsigned long i = 0; i < copies.size(); i++)
+          sum += scalarHash(copies[i]);
+        tsh += now() - start;
+
+        start = now();
+        for (unsigned long i = 0; i < copies.size(); i++)
+          sum += copies[i]->hash();
+        th += now() - start;
+
+        // the comparisons of equal nodes have to look at all pieces
+        start = now();
+        for (unsigned long i = 0; i < copies.size(); i++)
+          if (scalarEquals(copies[i], nodes[i]))
+            scalarEqual++;
+        tse += now() - start;
+
+        start = now();
+        for (unsigned long i = 0; i < copies.size(); i++)
+          if (*copies[i] == *nodes[i])
+            equal++;
+        te += now() - start;
+
+        freeNodes(copies);
+
+        // the table with nodes that still need to calculate their hash values, like in the disassembler
+        copyNodes(pool, nodes, copies);
+
+        start = now();
+        {
+          nodeTable_c tab;
+
+          for (unsigned long i = 0; i < copies.size()/2; i++)
+            tab.insert(copies[i]);
+
+          for (unsigned long i = 0; i < copies.size(); i++)
+            if (tab.find(copies[i]))
+              found++;
+        }
+        tt += now() - start;
+
+        freeNodes(copies);
+      }
+
+      double n = (double)rounds * nodes.size();
+      double ops = rounds * (nodes.size() + nodes.size()/2);
+
+      printf("%-30.30s %-20.20s %8lu %9.1f %9.1f %9.1f %9.1f %9.1f", name, problem->getName().c_str(),
+          (unsigned long)nodes.size(), 1e9*tsh/n, 1e9*th/n, 1e9*tse/n, 1e9*te/n, 1e9*tt/ops);
+
+      // half of the nodes are inserted into the table, so half of the lookups find their node
+      if (equal != scalarEqual || equal != n || found != rounds * (nodes.size()/2)) {
+        printf(" comparisons differ: %lu, %lu, %lu", scalarEqual, equal, found);
+        differ++;
+      }
+
+      // keep the compiler from dropping the hash calculations
+      if (sum == 1)
+        printf(" ");
+
+      printf("\n");
+
+      totalScalarHash += tsh;
+      totalHash += th;
+      totalScalarEq += tse;
+      totalEq += te;
+      totalTable += tt;
+      totalNodes += n;
+
+      freeNodes(nodes);
+    }
+  }
+
+  if (totalNodes > 0)
+    printf("\nper node: hash %.1f ns (scalar %.1f ns), comparison %.1f ns (scalar %.1f ns), table total %.3fs\n",
+        1e9*totalHash/totalNodes, 1e9*totalScalarHash/totalNodes,
+        1e9*totalEq/totalNodes, 1e9*totalScalarEq/totalNodes, totalTable);
+
+  return differ ? 1 : 0;
+}
+
+int main(int argc, char * argv[]) {
+
+  if (argc < 2) {
+    usage();
+    return 1;
+  }
+
+  if (strcmp(argv[1], "disassemble") == 0 && argc > 2)
+    return benchDisassemble(argc-2, argv+2);
+
+  if (strcmp(argv[1], "hash") == 0 && argc > 2)
+    return benchHash(argc-2, argv+2);
+
+  if (strcmp(argv[1], "node") == 0 && argc > 2)
+    return benchNode(argc-2, argv+2);
+
+  usage();
+  return 1;
+}
@@ -25,10 +25,15 @@
 #include "lib/assembly.h"
 #include "lib/disassembler.h"
 #include "lib/disassembler_0.h"
+#include "lib/disassembler_2.h"
 #include "lib/disassembly.h"
+#include "lib/disassemblerstats.h"
 #include "lib/print.h"
 #include "lib/voxel.h"
 #include "lib/solution.h"
+#include "lib/solvethread.h"
+#include "lib/solvescheduler.h"
+#include "lib/executor.h"
 #include "tools/xml.h"
 #include "tools/gzstream.h"
 
@@ -44,8 +49,143 @@ bool allProblems;
 bool printDisassemble;
 bool printSolutions;
 bool quiet;
+bool anyDisassembly;
+bool shortestRerun;
 
-disassembler_c * d;
+/* the memory for the fronts of the disassembler in bytes, see -m */
+unsigned long frontMemory;
+
+/* the directory for the movement values kept between runs, see -c */
+const char * cacheDirectory;
+
+/* treat identical pieces as exchangeable in the disassembler, see -i */
+bool canonicalNodes;
+
+/* print the disassembler counters for each problem, see --stats */
+bool printStats;
+
+/* the disassembler counters of the current problem */
+disassemblerStats_c problemStats;
+
+disassembler_a_c * d;
+
+/* the breadth first disassembler that looks for the shortest disassembly, when
+ * d is the depth first one and the user wants the shortest disassemblies
+ */
+disassembler_a_c * shortest;
+
+/* create the disassemblers selected by the options */
+void createDisassemblers(const problem_c & problem) {
+
+  shortest = 0;
+
+  if (anyDisassembly) {
+    d = new disassembler_2_c(problem);
+
+    if (shortestRerun)
+      shortest = new disassembler_0_c(problem);
+
+  } else
+    d = new disassembler_0_c(problem);
+
+  d->setFrontMemory(frontMemory, getenv("TMPDIR"));
+  if (shortest)
+    shortest->setFrontMemory(frontMemory, getenv("TMPDIR"));
+
+  if (canonicalNodes) {
+    d->setCanonicalNodes(true);
+    if (shortest)
+      shortest->setCanonicalNodes(true);
+  }
+
+  if (cacheDirectory) {
+    d->loadMovementCache(cacheDirectory);
+    if (shortest)
+      shortest->loadMovementCache(cacheDirectory);
+  }
+}
+
+/* the disassembly of the assembly, see -f and -F */
+separation_c * disassembleAssembly(const assembly_c * a) {
+
+  separation_c * da = d->disassemble(a);
+  problemStats.add(*d->getStats());
+
+  if (da && shortest) {
+    delete da;
+    da = shortest->disassemble(a);
+    problemStats.add(*shortest->getStats());
+  }
+
+  return da;
+}
+
+/* the disassemblies of many assemblies at once, see -x */
+void disassembleAssemblies(const std::vector<const assembly_c *> & assemblies, std::vector<disassemblyResult> & res) {
+
+  d->disassembleAll(assemblies, res);
+  problemStats.add(*d->getStats());
+
+  if (!shortest) return;
+
+  // the assemblies that come apart are analysed again to find the shortest disassembly
+  std::vector<const assembly_c *> apart;
+  std::vector<unsigned int> index;
+
+  for (unsigned int i = 0; i < res.size(); i++)
+    if (res[i].disassembly) {
+      delete res[i].disassembly;
+      apart.push_back(assemblies[i]);
+      index.push_back(i);
+    }
+
+  std::vector<disassemblyResult> res2;
+
+  shortest->disassembleAll(apart, res2);
+  problemStats.add(*shortest->getStats());
+
+  for (unsigned int i = 0; i < res2.size(); i++) {
+    res[index[i]].disassembly = res2[i].disassembly;
+    res[index[i]].nodes += res2[i].nodes;
+    res[index[i]].time += res2[i].time;
+  }
+}
+
+void deleteDisassemblers(void) {
+
+  /* the breadth first disassembler analyses the same positions
+   * as the depth first one and more, so its values are kept
+   */
+  if (cacheDirectory && d)
+    (shortest ? shortest : d)->saveMovementCache(cacheDirectory);
+
+  delete d;
+  delete shortest;
+  d = shortest = 0;
+}
+
+/* print the disassembler counters, see --stats */
+void printStatistics(const disassemblerStats_c & s) {
+
+  printf("disassembler statistics:\n");
+  printf("  analyses: %llu in %.1f ms\n", (unsigned long long)s.analyses, s.time / 1000.0);
+
+  printf("  nodes: %llu, per level:", (unsigned long long)s.nodes());
+  for (unsigned int i = 0; i < s.levelNodes.size(); i++)
+    printf(" %llu", (unsigned long long)s.levelNodes[i]);
+  printf("\n");
+
+  printf("  biggest front: %llu nodes, most nodes stored: %llu\n",
+      (unsigned long long)s.maxFront, (unsigned long long)s.maxStored);
+  printf("  node hashes: %llu insertions, %.2f probes per insertion, longest probe %llu, load %.2f\n",
+      (unsigned long long)s.hashInserts, s.hashInserts ? (double)s.hashProbes / s.hashInserts : 0,
+      (unsigned long long)s.hashMaxProbe, s.hashLoad());
+  printf("  movement cache: %llu lookups, %.1f%% hits, %llu values calculated in %.1f ms\n",
+      (unsigned long long)s.cacheLookups, 100 * s.cacheHitRate(),
+      (unsigned long long)s.cacheMisses, s.cacheTime / 1000.0);
+  printf("  closures: %llu calculated, %llu kept\n",
+      (unsigned long long)s.closures, (unsigned long long)s.closuresKept);
+}
 
 class asm_cb : public assembler_cb {
 
@@ -65,7 +205,7 @@ public:
 
     if (disassemble) {
 
-      separation_c * da = d->disassemble(a);
+      separation_c * da = disassembleAssembly(a);
 
       if (da) {
         Solutions++;
@@ -99,6 +239,16 @@ void usage(void) {
   cout << "burrTxt [options] file [options]\n\n";
   cout << "  file: puzzle file with the puzzle definition to solve\n\n";
   cout << "  -d    try to disassemble and only print solutions that do disassemble\n";
+  cout << "  -c d  keep the movement values for the disassembler in directory d, so that\n";
+  cout << "        later runs with the same shapes don't need to calculate them again\n";
+  cout << "  -f    with -d: any disassembly will do, this is faster, but the disassemblies\n";
+  cout << "        and levels are usually not the shortest ones\n";
+  cout << "  -F    like -f, but search the shortest disassembly for the solutions found\n";
+  cout << "  -m n  with -d: use at most about n MB for the disassembler, bigger searches are\n";
+  cout << "        continued with temporary files in $TMPDIR\n";
+  cout << "  -i    with -d: positions where identical pieces only exchanged their places are\n";
+  cout << "        the same position for the disassembler, this is faster for puzzles with\n";
+  cout << "        identical pieces, but another one of them may be moved\n";
   cout << "  -p    print the disassembly plan\n";
   cout << "  -r    reduce the placements bevore starting to solve the puzzle\n";
   cout << "  -s    print the assemby\n";
@@ -106,13 +256,97 @@ void usage(void) {
   cout << "  -n    don't print a newline at the end of the line\n";
   cout << "  -o n  select the problem to solve\n";
   cout << "  -o all solves all problems in file\n";
+  cout << "  -j n  solve up to n problems at the same time, when solving all problems,\n";
+  cout << "        with -x analyse up to n solutions at the same time (default: all processors)\n";
   cout << "  -x    only redisassemble the given solutions\n";
+  cout << "  --stats print counters of the disassembler for each problem\n";
   cout << "  -a    ask for information about the current puzzle, the next letters must be:\n";
   cout << "     s0 print solutions with the only the used pieces\n";
   cout << "     s1 print solutions including the assemblies\n";
   cout << "     c  print comment\n";
 }
 
+/* solve all problems of the puzzle using several threads. The problems
+ * get solved in any order, so the output is collected within the problems
+ * and printed once everything is finished
+ */
+int solveParallel(puzzle_c & p, unsigned int jobs, bool reduce, bool newline) {
+
+  int par = 0;
+
+  if (reduce) par |= solveThread_c::PAR_REDUCE;
+  if (disassemble) par |= solveThread_c::PAR_DISASSM;
+  if (anyDisassembly) par |= solveThread_c::PAR_ANY_DISASSM;
+  if (shortestRerun) par |= solveThread_c::PAR_SHORTEST_RERUN;
+  if (canonicalNodes) par |= solveThread_c::PAR_CANONICAL_NODES;
+  // all problems are solved here, so the levels of the disassemblies get printed even when quiet
+  if (!printSolutions && !printDisassemble && !disassemble && quiet) par |= solveThread_c::PAR_JUST_COUNT;
+
+  // the worker pool of the library is sized so that all requested problems can run at the same time
+  executor_c::setSize(jobs);
+
+  solveScheduler_c sched(p, par, jobs);
+  sched.setSolutionLimits(0);
+  sched.setSortMethod(solveThread_c::SRT_UNSORT);
+  sched.setFrontMemory(frontMemory, getenv("TMPDIR"));
+  if (cacheDirectory)
+    sched.setMovementCacheDirectory(cacheDirectory);
+
+  for (unsigned int pr = 0; pr < p.getNumberOfProblems(); pr++) {
+    p.getProblem(pr)->removeAllSolutions();
+    sched.addProblem(pr);
+  }
+
+  sched.run();
+
+  for (unsigned int j = 0; j < sched.getNumberOfJobs(); j++) {
+
+    problem_c * problem = p.getProblem(sched.getProblem(j));
+
+    cout << "problem: " << problem->getName() << endl;
+
+    switch (sched.getFinalAction(j)) {
+      case solveThread_c::ACT_FINISHED:
+        break;
+      case solveThread_c::ACT_ERROR:
+        printf("Error %i (parameter %i) while preparing the problem\n", sched.getErrorState(j), sched.getErrorParam(j));
+        continue;
+      default:
+        printf("Oops internal error\n");
+        continue;
+    }
+
+    for (unsigned int sol = 0; sol < problem->getNumberOfSavedSolutions(); sol++) {
+
+      const solution_c * s = problem->getSavedSolution(sol);
+
+      if (printSolutions)
+        print(s->getAssembly(), problem);
+
+      if (s->getDisassembly()) {
+        char lev[200];
+        s->getDisassembly()->movesText(lev, 200);
+        printf("level: %s\n", lev);
+
+        if (printDisassemble)
+          print(s->getDisassembly(), s->getAssembly(), problem);
+      }
+    }
+
+    cout << problem->getNumAssemblies() << " assemblies and "
+         << (disassemble ? problem->getNumSolutions() : 0) << " solutions found with "
+         << problem->getAssembler()->getIterations() << " iterations ";
+
+    if (newline)
+      cout << endl;
+
+    if (printStats)
+      printStatistics(sched.getDisassemblerStats(j));
+  }
+
+  return 0;
+}
+
 int main(int argv, char* args[]) {
 
   if (argv < 1) {
@@ -126,6 +360,12 @@ int main(int argv, char* args[]) {
   printDisassemble = false;
   printSolutions = false;
   quiet = false;
+  anyDisassembly = false;
+  shortestRerun = false;
+  frontMemory = 0;
+  cacheDirectory = 0;
+  printStats = false;
+  canonicalNodes = false;
   bool assemble = true;
   unsigned int problem = 0;
   unsigned int firstProblem = 0;
@@ -134,6 +374,8 @@ int main(int argv, char* args[]) {
   bool reduce = false;
   bool newline = true;
   bool ask = false;
+  unsigned int jobs = 1;
+  bool jobsGiven = false;
   enum {
     W_NUM_SOLUTIONS,
     W_SOLUTION_PIECES,
@@ -149,6 +391,12 @@ int main(int argv, char* args[]) {
 
       if (strcmp(args[i], "-d") == 0)
         disassemble = true;
+      else if (strcmp(args[i], "-f") == 0)
+        anyDisassembly = true;
+      else if (strcmp(args[i], "-F") == 0)
+        anyDisassembly = shortestRerun = true;
+      else if (strcmp(args[i], "-i") == 0)
+        canonicalNodes = true;
       else if (strcmp(args[i], "-p") == 0)
         printDisassemble = true;
       else if (strcmp(args[i], "-s") == 0)
@@ -159,6 +407,21 @@ int main(int argv, char* args[]) {
         newline = false;
       else if (strcmp(args[i], "-x") == 0)
         assemble = false;
+      else if (strcmp(args[i], "--stats") == 0)
+        printStats = true;
+      else if (strcmp(args[i], "-c") == 0) {
+        cacheDirectory = args[i+1];
+        i++;
+      }
+      else if (strcmp(args[i], "-m") == 0) {
+        frontMemory = strtoul(args[i+1], 0, 10) * 1024 * 1024;
+        i++;
+      }
+      else if (strcmp(args[i], "-j") == 0) {
+        jobs = atoi(args[i+1]);
+        jobsGiven = true;
+        i++;
+      }
       else if (strcmp(args[i], "-o") == 0) {
         if (strcmp(args[i+1],"all")==0)
           allProblems = true;
@@ -272,6 +535,9 @@ int main(int argv, char* args[]) {
 
 
 
+    if (allProblems && jobs != 1)
+      return solveParallel(p, jobs, reduce, newline);
+
     for (unsigned int pr = firstProblem ; pr < lastProblem ; pr++) {
 
       problem_c * problem = p.getProblem(pr);
@@ -315,8 +581,10 @@ int main(int argv, char* args[]) {
       asm_cb a(problem);
 
       d = 0;
+      shortest = 0;
+      problemStats.reset();
       if (disassemble)
-        d = new disassembler_0_c(*problem);
+        createDisassemblers(*problem);
 
       assm->assemble(&a);
 
@@ -325,40 +593,58 @@ int main(int argv, char* args[]) {
       if (newline)
         cout << endl;
 
+      if (printStats && disassemble)
+        printStatistics(problemStats);
+
       delete assm;
-      delete d;
-      d = 0;
+      deleteDisassemblers();
       assm = 0;
     }
   } else {
 
+    // the solutions of each problem are analysed in parallel, by default on all processors
+    if (jobsGiven)
+      executor_c::setSize(jobs);
+
     for (unsigned int pr = firstProblem ; pr < lastProblem; pr ++) {
 
       problem_c * problem = p.getProblem(pr);
 
-      d = new disassembler_0_c(*problem);
+      createDisassemblers(*problem);
+      problemStats.reset();
 
-      for (unsigned int sol = 0; sol < problem->getNumberOfSavedSolutions(); sol++) {
+      // all the solutions are analysed together, in parallel with -j
+      std::vector<const assembly_c *> assemblies;
 
-        if (problem->getSavedSolution(sol)->getAssembly()) {
+      for (unsigned int sol = 0; sol < problem->getNumberOfSavedSolutions(); sol++)
+        if (problem->getSavedSolution(sol)->getAssembly())
+          assemblies.push_back(problem->getSavedSolution(sol)->getAssembly());
 
-          separation_c * da = d->disassemble(problem->getSavedSolution(sol)->getAssembly());
+      std::vector<disassemblyResult> res;
 
-          if (da) {
-            if (printSolutions)
-              print(problem->getSavedSolution(sol)->getAssembly(), problem);
+      disassembleAssemblies(assemblies, res);
 
-            if (!quiet)
-              printf("level: %i\n", da->getMoves());
+      for (unsigned int i = 0; i < assemblies.size(); i++) {
 
-            if (printDisassemble)
-              print(da, problem->getSavedSolution(sol)->getAssembly(),problem);
-            delete da;
-          }
+        separation_c * da = res[i].disassembly;
+
+        if (da) {
+          if (printSolutions)
+            print(assemblies[i], problem);
+
+          if (!quiet)
+            printf("level: %i\n", da->getMoves());
+
+          if (printDisassemble)
+            print(da, assemblies[i], problem);
+          delete da;
         }
       }
 
-      delete d;
+      if (printStats)
+        printStatistics(problemStats);
+
+      deleteDisassemblers();
     }
   }
 
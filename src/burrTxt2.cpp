@@ -51,6 +51,10 @@ void usage(void) {
   cout << "  -r    keep rotated solutions\n";
   cout << "  -p    drop disassemblies and replace by information about disassembly\n";
   cout << "  -b    selecte problem, else 0\n";
+  cout << "  -I n  stop after n iterations of the assembler\n";
+  cout << "  -T n  stop after n seconds\n";
+  cout << "  -M n  stop when the disassembler needs more than n MB for its nodes\n";
+  cout << "  when stopped because of one of the limits the state is saved and can be continued\n";
 }
 
 
@@ -83,6 +87,9 @@ int main(int argv, char* args[]) {
   int filenumber = 0;
   int firstProblem = 0;
   int lastProblem = 1;
+  unsigned long maxIterations = 0;
+  unsigned long maxTime = 0;
+  unsigned long maxMemory = 0;
 
   for(int i = 1; i < argv; i++) {
 
@@ -103,6 +110,18 @@ int main(int argv, char* args[]) {
       lastProblem = firstProblem + 1;
       i++;
     }
+    else if (strcmp(args[i], "-I") == 0) {
+      maxIterations = strtoul(args[i+1], 0, 10);
+      i++;
+    }
+    else if (strcmp(args[i], "-T") == 0) {
+      maxTime = strtoul(args[i+1], 0, 10);
+      i++;
+    }
+    else if (strcmp(args[i], "-M") == 0) {
+      maxMemory = strtoul(args[i+1], 0, 10) * 1024 * 1024;
+      i++;
+    }
     else
       filenumber = i;
   }
@@ -140,14 +159,30 @@ int main(int argv, char* args[]) {
 
     solveThread_c assmThread(*p.getProblem(pr), par);
 
+    assmThread.getBudget().setIterationLimit(maxIterations);
+    assmThread.getBudget().setTimeLimit(maxTime);
+    assmThread.getBudget().setMemoryLimit(maxMemory);
+
     if (!assmThread.start(false)) {
       cout << "Could not start Solver\n";
       continue;
     }
 
+    // the rates are calculated over at least one second
+    solveMetrics_c::snapshot last, now;
+    solveMetrics_c::rates rates;
+    assmThread.getMetrics().getSnapshot(last);
+    rates.iterations = rates.assemblies = rates.disassemblies = rates.nodes = 0;
+
     while (assmThread.currentAction() != solveThread_c::ACT_FINISHED &&
         assmThread.currentAction() != solveThread_c::ACT_ERROR) {
 
+      // the thread pauses on its own, when it runs out of budget
+      if (assmThread.currentAction() == solveThread_c::ACT_PAUSING && !assmThread.isRunning()) {
+        cout << "\rstopped: " << solveBudget_c::reasonText(assmThread.getStopReason()) << "\n";
+        break;
+      }
+
       if (checkInput()) {
         cout << "abborting \n";
         assmThread.stop();
@@ -174,9 +209,14 @@ int main(int argv, char* args[]) {
       }
 
 
-      float finished = (p.getProblem(pr)->getAssembler())
-        ? p.getProblem(pr)->getAssembler()->getFinished()
-        : 0;
+      assmThread.getMetrics().getSnapshot(now);
+
+      if (now.time >= last.time + 1000000) {
+        solveMetrics_c::getRates(last, now, rates);
+        last = now;
+      }
+
+      float finished = now.finished / 1000000.0;
 
       switch (assmThread.currentAction()) {
         case solveThread_c::ACT_PREPARATION:
@@ -186,10 +226,16 @@ int main(int argv, char* args[]) {
           cout << "\rreducing piece " << assmThread.currentActionParameter()+1;
           break;
         case solveThread_c::ACT_ASSEMBLING:
-          cout << "\rassembling " << finished*100 << "% done";
+          cout << "\rassembling " << finished*100 << "% done, "
+               << (unsigned long)rates.iterations << " iterations/s, "
+               << (unsigned long)rates.assemblies << " assemblies/s   ";
           break;
         case solveThread_c::ACT_DISASSEMBLING:
-          cout << "\rdisassembling " << finished*100 << "% done";
+          cout << "\rdisassembling " << finished*100 << "% done, "
+               << (unsigned long)rates.disassemblies << " disassemblies/s, "
+               << now.interlocked << " of " << now.disassemblies << " interlocked, "
+               << (unsigned long)rates.nodes << " nodes/s, "
+               << now.queueDepth << " nodes queued   ";
           break;
         case solveThread_c::ACT_WAIT_TO_STOP:
           cout << "\rwaitin";
@@ -172,12 +172,16 @@ bool gridEditor_c::setLayer(unsigned int z) {
 
   bool changed = false;
 
-  // loop over the area and set all voxels
-  for (int x = x1; x <= x2; x++)
-    for (int y = y1; y <= y2; y++)
-      if ((x >= 0) && (y >= 0) && (x < (int)space->getX()) && (y < (int)space->getY()))
-        // depending on the state we either do the current active task, or clear
-        changed |= setRecursive(activeTools, x, y, z);
+  {
+    voxelEdit_c edit(*space);
+
+    // loop over the area and set all voxels
+    for (int x = x1; x <= x2; x++)
+      for (int y = y1; y <= y2; y++)
+        if ((x >= 0) && (y >= 0) && (x < (int)space->getX()) && (y < (int)space->getY()))
+          // depending on the state we either do the current active task, or clear
+          changed |= setRecursive(activeTools, x, y, z);
+  }
 
   if (changed)
     space->initHotspot();
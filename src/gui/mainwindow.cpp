@@ -69,6 +69,7 @@
 #include "../lib/millable.h"
 #include "../lib/voxeltable.h"
 #include "../lib/solution.h"
+#include "../lib/executor.h"
 
 #include "../tools/gzstream.h"
 #include "../tools/xml.h"
@@ -1222,7 +1223,7 @@ void mainWindow_c::cb_AddAllDisasm(bool all) {
 
   changed = true;
 
-  disassembler_c * dis = new disassembler_0_c(*pr);
+  disassembler_a_c * dis = new disassembler_0_c(*pr);
 
   Fl_Double_Window * w = new Fl_Double_Window(20, 20, 300, 30);
   Fl_Box * b = new Fl_Box(0, 0, 300, 30);
@@ -1232,20 +1233,39 @@ void mainWindow_c::cb_AddAllDisasm(bool all) {
   char txt[100];
   w->show();
 
-  for (unsigned int sol = 0; sol < pr->getNumberOfSavedSolutions(); sol++) {
+  /* the solutions are disassembled in groups, the solutions of a group
+   * in parallel, the progress is shown after each group
+   */
+  unsigned int group = 4*executor_c::instance().size();
+  unsigned int sol = 0;
+
+  while (sol < pr->getNumberOfSavedSolutions()) {
 
     snprintf(txt, 100, "solved %i of %i disassemblies\n", sol, pr->getNumberOfSavedSolutions());
     b->label(txt);
 
     Fl::wait(0);
 
-    if (all || !pr->getSavedSolution(sol)->getDisassembly()) {
+    std::vector<const assembly_c *> assemblies;
+    std::vector<solution_c *> solutions;
 
-      separation_c * d = dis->disassemble(pr->getSavedSolution(sol)->getAssembly());
+    while (sol < pr->getNumberOfSavedSolutions() && assemblies.size() < group) {
+
+      if (all || !pr->getSavedSolution(sol)->getDisassembly()) {
+        assemblies.push_back(pr->getSavedSolution(sol)->getAssembly());
+        solutions.push_back(pr->getSavedSolution(sol));
+      }
 
-      if (d)
-        pr->getSavedSolution(sol)->setDisassembly(d);
+      sol++;
     }
+
+    std::vector<disassemblyResult> res;
+
+    dis->disassembleAll(assemblies, res);
+
+    for (unsigned int i = 0; i < res.size(); i++)
+      if (res[i].disassembly)
+        solutions[i]->setDisassembly(res[i].disassembly);
   }
 
   delete dis;
@@ -2448,10 +2468,21 @@ void mainWindow_c::updateInterface(void) {
 
   } else {
 
-    float finished = ((prob < puzzle->getNumberOfProblems()) &&
-        puzzle->getProblem(prob)->getAssembler())
-          ? puzzle->getProblem(prob)->getAssembler()->getFinished()
-          : 0;
+    float finished = 0;
+
+    if (prob < puzzle->getNumberOfProblems()) {
+
+      if (assmThread && (&(assmThread->getProblem()) == puzzle->getProblem(prob))) {
+
+        // the problem is currently solved, so use the published progress, the
+        // assembler itself belongs to the solving thread
+        solveMetrics_c::snapshot s;
+        assmThread->getMetrics().getSnapshot(s);
+        finished = s.finished / 1000000.0;
+
+      } else if (puzzle->getProblem(prob)->getAssembler())
+        finished = puzzle->getProblem(prob)->getAssembler()->getFinished();
+    }
 
     if (prob < puzzle->getNumberOfProblems()) {
 
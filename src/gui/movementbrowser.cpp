@@ -322,7 +322,7 @@ void movementBrowser_c::cb_AddMovement(void) {
     z = -z;
   }
 
-  disassemblerNode_c * n = new disassemblerNode_c(s->pieces.size(), s->node, 0, 0);
+  disassemblerNode_c * n = disassemblerNode_c::create(s->pieces.size(), s->node, 0, 0);
 
   for (unsigned int i = 0; i < s->pieces.size(); i++)
     if (dlg.pieceSelected(i))
@@ -347,7 +347,7 @@ void movementBrowser_c::addSpecificMovement(unsigned int piece, int x, int y, in
   nodeData_s * s = (nodeData_s *)(nd->user_data());
   if (!s) return;
 
-  disassemblerNode_c * n = new disassemblerNode_c(s->pieces.size(), s->node, 0, 0);
+  disassemblerNode_c * n = disassemblerNode_c::create(s->pieces.size(), s->node, 0, 0);
 
   for (unsigned int i = 0; i < s->pieces.size(); i++)
     if (piece == i)
@@ -509,7 +509,7 @@ movementBrowser_c::movementBrowser_c(problem_c * puzzle, unsigned int solNum) :
 
   assembly_c * assembly = puz->getSavedSolution(solNum)->getAssembly();
 
-  dat->node = new disassemblerNode_c(assembly);
+  dat->node = disassemblerNode_c::create(assembly);
   dat->node->incRefCount();
 
   /* create pieces field. This field contains the
@@ -19,6 +19,8 @@
  * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
  */
 #include "assembler.h"
+#include "metrics.h"
+#include "budget.h"
 
 #include "../tools/xml.h"
 
@@ -38,3 +40,17 @@ void assembler_c::save(xmlWriter_c & xml) const
   xml.endTag("assembler");
 }
 
+
+void assembler_c::publishProgress(void)
+{
+  if (metrics)
+    metrics->setAssemblerProgress(getIterations(), getFinished());
+}
+
+void assembler_c::periodic(void)
+{
+  publishProgress();
+
+  if (budget && budget->checkAssembler(getIterations()))
+    stop();
+}
@@ -29,6 +29,8 @@ class voxel_c;
 class assembly_c;
 class problem_c;
 class xmlWriter_c;
+class solveMetrics_c;
+class solveBudget_c;
 
 /**
  * The callback class used to return found assemblies to the caller
@@ -78,7 +80,7 @@ public:
   /**
    * initialisation, only the things that can be done quickly are done here
    */
-  assembler_c(void) {}
+  assembler_c(void) : metrics(0), budget(0) {}
 
   virtual ~assembler_c(void) { }
 
@@ -192,8 +194,38 @@ public:
    */
   virtual assembly_c * getAssembly(void) = 0;
 
+  /**
+   * set the metrics to publish the progress into, 0 to publish nothing.
+   * The assemblers publish every few thousand iterations and when they stop
+   */
+  void setMetrics(solveMetrics_c * m) { metrics = m; }
+
+  /**
+   * set the limits for this run, 0 for no limits. The budget is checked
+   * at the same time the metrics are published, once it is exceeded the
+   * assembler stops like with stop, so it can be continued later on
+   */
+  void setBudget(solveBudget_c * b) { budget = b; }
+
+protected:
+
+  /** publish iterations and the finished value into the metrics, if there are some */
+  void publishProgress(void);
+
+  /** the assemblers call this with their iteration counter in the main loop */
+  void checkPeriodic(unsigned long iterations) {
+    if ((metrics || budget) && ((iterations & 0xFFF) == 0))
+      periodic();
+  }
+
 private:
 
+  /** publish the progress and check the budget */
+  void periodic(void);
+
+  solveMetrics_c * metrics;
+  solveBudget_c * budget;
+
     // no copying and assigning
     assembler_c(const assembler_c&);
     void operator=(const assembler_c&);
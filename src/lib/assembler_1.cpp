@@ -26,6 +26,7 @@
 #include "voxel.h"
 #include "assembly.h"
 #include "gridtype.h"
+#include "shapecache.h"
 
 #include "../tools/xml.h"
 
@@ -278,15 +279,13 @@ assembler_1_c::~assembler_1_c() {
 }
 
 /* add a piece to the cache, but only if it is not already there. If it is added return the
- * piece pointer otherwise return null
+ * piece pointer otherwise return null. The pieces belong to the shape cache of the puzzle
  */
-static voxel_c * addToCache(voxel_c * cache[], unsigned int * fill, voxel_c * piece) {
+static const voxel_c * addToCache(const voxel_c * cache[], unsigned int * fill, const voxel_c * piece) {
 
   for (unsigned int i = 0; i < *fill; i++)
-    if (cache[i]->identicalInBB(piece)) {
-      delete piece;
+    if (cache[i]->identicalInBB(piece))
       return 0;
-    }
 
   cache[*fill] = piece;
   (*fill)++;
@@ -300,18 +299,20 @@ bool assembler_1_c::canPlace(const voxel_c * piece, int x, int y, int z) const {
 
   const voxel_c * result = getResultShape(problem);
 
+  // the piece can not be placed if the result is empty and the piece is filled at a given voxel,
+  // this is checked on the bit planes of the 2 shapes
+  if (!piece->fitsInto(result, x, y, z, false))
+    return false;
+
+  // without colours there are no colour constraints
+  if (problem.getPuzzle().colorNumber() == 0)
+    return true;
+
+  // the piece can also not be placed when the colour constraints don't fit
   for (unsigned int pz = piece->boundZ1(); pz <= piece->boundZ2(); pz++)
     for (unsigned int py = piece->boundY1(); py <= piece->boundY2(); py++)
       for (unsigned int px = piece->boundX1(); px <= piece->boundX2(); px++)
-        if (
-            // the piece can not be place if the result is empty and the piece is filled at a given voxel
-            ((piece->getState(px, py, pz) == voxel_c::VX_FILLED) &&
-             (result->getState(x+px, y+py, z+pz) == voxel_c::VX_EMPTY)) ||
-
-            // the piece can also not be placed when the colour constraints don't fit
-            !problem.placementAllowed(piece->getColor(px, py, pz), result->getColor(x+px, y+py, z+pz))
-
-           )
+        if (!problem.placementAllowed(piece->getColor(px, py, pz), result->getColor(x+px, y+py, z+pz)))
           return false;
 
   return true;
@@ -402,7 +403,6 @@ int assembler_1_c::prepare(bool hasRange, unsigned int rangeMin, unsigned int ra
    * that are present in the piece
    */
   symmetries_t resultSym = result->selfSymmetries();
-  const gridType_c * gt = problem.getPuzzle().getGridType();
   const symmetries_c * sym = problem.getPuzzle().getGridType()->getSymmetries();
   unsigned int symBreakerShape = 0xFFFFFFFF;
 
@@ -565,7 +565,9 @@ int assembler_1_c::prepare(bool hasRange, unsigned int rangeMin, unsigned int ra
    * these voxels are only used once
    */
 
-  voxel_c ** cache = new voxel_c *[sym->getNumTransformationsMirror()];
+  const voxel_c ** cache = new const voxel_c *[sym->getNumTransformationsMirror()];
+
+  shapeCache_c & shapes = problem.getPuzzle().getShapeCache();
 
   /* now we insert one shape after another */
   for (unsigned int pc = 0; pc < problem.getNumberOfParts(); pc++) {
@@ -590,11 +592,9 @@ int assembler_1_c::prepare(bool hasRange, unsigned int rangeMin, unsigned int ra
      */
     for (unsigned int rot = 0; rot < sym->getNumTransformations(); rot++) {
 
-      voxel_c * rotation = gt->getVoxel(problem.getPartShape(pc));
-      if (!rotation->transform(rot)) {
-        delete rotation;
+      const voxel_c * rotation = shapes.getShape(problem.getShapeIdOfPart(pc), rot);
+      if (!rotation)
         continue;
-      }
 
       rotation = addToCache(cache, &cachefill, rotation);
 
@@ -625,20 +625,18 @@ int assembler_1_c::prepare(bool hasRange, unsigned int rangeMin, unsigned int ra
           for (unsigned int r = 1; r < sym->getNumTransformations(); r++)
             if (sym->symmetrieContainsTransformation(resultSym, r)) {
 
-              voxel_c * vx = gt->getVoxel(problem.getPartShape(pc));
+              unsigned char t = sym->transAdd(rot, r);
 
-              if (!vx->transform(rot) || !vx->transform(r)) {
-                delete vx;
-                continue;
-              }
+              if (t != TND) {
+                const voxel_c * vx = shapes.getShape(problem.getShapeIdOfPart(pc), t);
 
-              addToCache(cache, &cachefill, vx);
+                if (vx)
+                  addToCache(cache, &cachefill, vx);
+              }
             }
       }
     }
 
-    for (unsigned int i = 0; i < cachefill; i++)  delete cache[i];
-
     /* check, if the current piece has at least one placement */
     if (placements == 0 && problem.getPartMinimum(pc) > 0)
     {
@@ -1473,6 +1471,7 @@ void assembler_1_c::iterative(void) {
   while (task_stack.size() > 0) {
 
     iterations++;
+    checkPeriodic(iterations);
 
     // wan can only restore the states 1, 2 and 5. Internal states will alway
     // be one of those, but the last state might differ, so continue looping
@@ -1820,6 +1819,8 @@ void assembler_1_c::assemble(assembler_cb * callback) {
   }
 
   running = false;
+
+  publishProgress();
 }
 
 float assembler_1_c::getFinished(void) const {
@@ -24,6 +24,7 @@
 #include "puzzle.h"
 #include "bt_assert.h"
 #include "voxel.h"
+#include "shapecache.h"
 
 #include "../tools/xml.h"
 
@@ -224,8 +225,11 @@ bool assembly_c::transform(unsigned char trans, const problem_c & puz, const mir
   // if we want to mirror, we need mirroring information for the involved shapes
   bt_assert((trans < sym->getNumTransformations()) || mir);
 
+  // the hotspots and bounding boxes of the transformed shapes come from the cache of the puzzle
+  shapeCache_c & shapes = puz.getPuzzle().getShapeCache();
+
   int rx, ry, rz;
-  if (!getResultShape(puz)->getHotspot(trans, &rx, &ry, &rz)) return false;
+  if (!shapes.getHotspot(puz.getResultId(), trans, &rx, &ry, &rz)) return false;
 
   /* the hole idea behind this is:
    *
@@ -276,8 +280,8 @@ bool assembly_c::transform(unsigned char trans, const problem_c & puz, const mir
 
     int cx, cy, cz, dx, dy, dz;
 
-    if (!getResultShape(puz)->getBoundingBox(trans, &cx, &cy, &cz)) return false;
-    if (!getResultShape(puz)->getBoundingBox(0, &dx, &dy, &dz)) return false;
+    if (!shapes.getBoundingBox(puz.getResultId(), trans, &cx, &cy, &cz)) return false;
+    if (!shapes.getBoundingBox(puz.getResultId(), 0, &dx, &dy, &dz)) return false;
 
     rx += dx - cx;
     ry += dy - cy;
@@ -319,11 +323,11 @@ bool assembly_c::transform(unsigned char trans, const problem_c & puz, const mir
          * this is the easiest solution but by far the slowest
          */
         int ax, ay, az, bx, by, bz, cx, cy, cz, dx, dy, dz;
-        puz.getPartShape(i)->getHotspot(placements[p].transformation, &ax, &ay, &az);
-        puz.getPartShape(i)->getHotspot(tr, &bx, &by, &bz);
+        shapes.getHotspot(puz.getShapeIdOfPart(i), placements[p].transformation, &ax, &ay, &az);
+        shapes.getHotspot(puz.getShapeIdOfPart(i), tr, &bx, &by, &bz);
 
-        puz.getPartShape(i)->getBoundingBox(placements[p].transformation, &cx, &cy, &cz);
-        puz.getPartShape(i)->getBoundingBox(tr, &dx, &dy, &dz);
+        shapes.getBoundingBox(puz.getShapeIdOfPart(i), placements[p].transformation, &cx, &cy, &cz);
+        shapes.getBoundingBox(puz.getShapeIdOfPart(i), tr, &dx, &dy, &dz);
 
         placements[p].xpos += bx-ax + cx-dx;
         placements[p].ypos += by-ay + cy-dy;
@@ -434,20 +438,20 @@ bool assembly_c::transform(unsigned char trans, const problem_c & puz, const mir
              * have the same shape at the orientation
              */
 
-            puz.getPartShape(i)->getHotspot(p1t, &hx, &hy, &hz);
+            shapes.getHotspot(puz.getShapeIdOfPart(i), p1t, &hx, &hy, &hz);
             p1x -= hx;
             p1y -= hy;
             p1z -= hz;
-            puz.getPartShape(i)->getBoundingBox(p1t, &hx, &hy, &hz);
+            shapes.getBoundingBox(puz.getShapeIdOfPart(i), p1t, &hx, &hy, &hz);
             p1x += hx;
             p1y += hy;
             p1z += hz;
 
-            puz.getPartShape(i2)->getHotspot(p2t, &hx, &hy, &hz);
+            shapes.getHotspot(puz.getShapeIdOfPart(i2), p2t, &hx, &hy, &hz);
             p2x -= hx;
             p2y -= hy;
             p2z -= hz;
-            puz.getPartShape(i2)->getBoundingBox(p2t, &hx, &hy, &hz);
+            shapes.getBoundingBox(puz.getShapeIdOfPart(i2), p2t, &hx, &hy, &hz);
             p2x += hx;
             p2y += hy;
             p2z += hz;
@@ -467,20 +471,20 @@ bool assembly_c::transform(unsigned char trans, const problem_c & puz, const mir
 
             /* now go back from the origin of the bounding box to the hotspot anchor point */
 
-            puz.getPartShape(i2)->getHotspot(p1t, &hx, &hy, &hz);
+            shapes.getHotspot(puz.getShapeIdOfPart(i2), p1t, &hx, &hy, &hz);
             p1x += hx;
             p1y += hy;
             p1z += hz;
-            puz.getPartShape(i2)->getBoundingBox(p1t, &hx, &hy, &hz);
+            shapes.getBoundingBox(puz.getShapeIdOfPart(i2), p1t, &hx, &hy, &hz);
             p1x -= hx;
             p1y -= hy;
             p1z -= hz;
 
-            puz.getPartShape(i)->getHotspot(p2t, &hx, &hy, &hz);
+            shapes.getHotspot(puz.getShapeIdOfPart(i), p2t, &hx, &hy, &hz);
             p2x += hx;
             p2y += hy;
             p2z += hz;
-            puz.getPartShape(i)->getBoundingBox(p2t, &hx, &hy, &hz);
+            shapes.getBoundingBox(puz.getShapeIdOfPart(i), p2t, &hx, &hy, &hz);
             p2x -= hx;
             p2y -= hy;
             p2z -= hz;
@@ -514,11 +518,11 @@ bool assembly_c::transform(unsigned char trans, const problem_c & puz, const mir
              * have the same shape at the orientation
              */
 
-            puz.getPartShape(i)->getHotspot(p1t, &hx, &hy, &hz);
+            shapes.getHotspot(puz.getShapeIdOfPart(i), p1t, &hx, &hy, &hz);
             p1x -= hx;
             p1y -= hy;
             p1z -= hz;
-            puz.getPartShape(i)->getBoundingBox(p1t, &hx, &hy, &hz);
+            shapes.getBoundingBox(puz.getShapeIdOfPart(i), p1t, &hx, &hy, &hz);
             p1x += hx;
             p1y += hy;
             p1z += hz;
@@ -537,11 +541,11 @@ bool assembly_c::transform(unsigned char trans, const problem_c & puz, const mir
 
             /* now go back from the origin of the bounding box to the hotspot anchor point */
 
-            puz.getPartShape(i2)->getHotspot(p1t, &hx, &hy, &hz);
+            shapes.getHotspot(puz.getShapeIdOfPart(i2), p1t, &hx, &hy, &hz);
             p1x += hx;
             p1y += hy;
             p1z += hz;
-            puz.getPartShape(i2)->getBoundingBox(p1t, &hx, &hy, &hz);
+            shapes.getBoundingBox(puz.getShapeIdOfPart(i2), p1t, &hx, &hy, &hz);
             p1x -= hx;
             p1y -= hy;
             p1z -= hz;
@@ -670,28 +674,17 @@ bool assembly_c::smallerRotationExists(const problem_c & puz, unsigned int pivot
           {
             if (assm->onGrid(x, y, z))
             {
-              bool fits = true;
-
-              for (int pz = (int)assm->boundZ1(); pz <= (int)assm->boundZ2(); pz++)
-                for (int py = (int)assm->boundY1(); py <= (int)assm->boundY2(); py++)
-                  for (int px = (int)assm->boundX1(); px <= (int)assm->boundX2(); px++)
-                  {
-                    if (
-                        // the piece can not be place if the result is empty and the piece is filled at a given voxel
-                        ((assm->getState(px, py, pz) == voxel_c::VX_FILLED) &&
-                         (res->getState2(x+px, y+py, z+pz) == voxel_c::VX_EMPTY)) ||
-
-                        // the placement is also invalid, when not all "must be filled" voxels are filled
-                        ((assm->getState(px, py, pz) == voxel_c::VX_EMPTY) &&
-                         (res->getState2(x+px, y+py, z+pz) == voxel_c::VX_FILLED)) ||
-
-
-                        // the piece can also not be placed when the colour constraints don't fit
-                        !puz.placementAllowed(assm->getColor(px, py, pz), res->getColor2(x+px, y+py, z+pz))
-
-                       )
-                      fits = false;
-                  }
+              // the piece can not be place if the result is empty and the piece is filled at a given voxel
+              // the placement is also invalid, when not all "must be filled" voxels are filled
+              bool fits = assm->fitsInto(res, x, y, z, true);
+
+              // the piece can also not be placed when the colour constraints don't fit
+              if (fits && puz.getPuzzle().colorNumber() > 0)
+                for (int pz = (int)assm->boundZ1(); pz <= (int)assm->boundZ2(); pz++)
+                  for (int py = (int)assm->boundY1(); py <= (int)assm->boundY2(); py++)
+                    for (int px = (int)assm->boundX1(); px <= (int)assm->boundX2(); px++)
+                      if (!puz.placementAllowed(assm->getColor(px, py, pz), res->getColor2(x+px, y+py, z+pz)))
+                        fits = false;
 
               if (fits)
               {
@@ -793,7 +786,7 @@ int assembly_c::comparePieces(const assembly_c * b) const {
 
 voxel_c * assembly_c::createSpace(const problem_c & puz) const {
 
-  std::vector<voxel_c *>pieces;
+  std::vector<const voxel_c *>pieces;
   pieces.resize(placements.size());
 
   int maxX = 1;
@@ -807,9 +800,9 @@ voxel_c * assembly_c::createSpace(const problem_c & puz) const {
 
       unsigned int j = puz.getPartIdToPieceId(i);
 
-      voxel_c * pc = puz.getPuzzle().getGridType()->getVoxel(puz.getPartShape(j));
+      const voxel_c * pc = puz.getPuzzle().getShapeCache().getShape(puz.getShapeIdOfPart(j), placements[i].transformation);
 
-      bt_assert(pc->transform(placements[i].transformation));
+      bt_assert(pc);
 
       int dx = (int)placements[i].xpos - (int)pc->getHx();
       int dy = (int)placements[i].ypos - (int)pc->getHy();
@@ -824,29 +817,29 @@ voxel_c * assembly_c::createSpace(const problem_c & puz) const {
 
   // create a shape identical in size with the result shape of the problem
   voxel_c * res = puz.getPuzzle().getGridType()->getVoxel(maxX, maxY, maxZ, 0);
-  res->skipRecalcBoundingBox(true);
 
-  // now iterate over all shapes in the assembly and place them into the result
-  for (unsigned int i = 0; i < placements.size(); i++)
-    if (placements[i].transformation != UNPLACED_TRANS) {
+  {
+    voxelEdit_c edit(*res);
 
-      voxel_c * pc = pieces[i];
+    // now iterate over all shapes in the assembly and place them into the result
+    for (unsigned int i = 0; i < placements.size(); i++)
+      if (placements[i].transformation != UNPLACED_TRANS) {
 
-      int dx = (int)placements[i].xpos - (int)pc->getHx();
-      int dy = (int)placements[i].ypos - (int)pc->getHy();
-      int dz = (int)placements[i].zpos - (int)pc->getHz();
+        const voxel_c * pc = pieces[i];
 
-      for (unsigned int x = 0; x < pc->getX(); x++)
-        for (unsigned int y = 0; y < pc->getY(); y++)
-          for (unsigned int z = 0; z < pc->getZ(); z++) {
-            if (pc->getState(x, y, z) != voxel_c::VX_EMPTY)
-              res->set(x+dx, y+dy, z+dz, pc->get(x, y, z));
-          }
+        int dx = (int)placements[i].xpos - (int)pc->getHx();
+        int dy = (int)placements[i].ypos - (int)pc->getHy();
+        int dz = (int)placements[i].zpos - (int)pc->getHz();
 
-      delete pc;
-    }
+        for (unsigned int x = 0; x < pc->getX(); x++)
+          for (unsigned int y = 0; y < pc->getY(); y++)
+            for (unsigned int z = 0; z < pc->getZ(); z++) {
+              if (pc->getState(x, y, z) != voxel_c::VX_EMPTY)
+                res->set(x+dx, y+dy, z+dz, pc->get(x, y, z));
+            }
+      }
+  }
 
-  res->skipRecalcBoundingBox(false);
   res->initHotspot();
   return res;
 }
@@ -0,0 +1,84 @@
+/* BurrTools
+ *
+ * BurrTools is the legal property of its developers, whose
+ * names are listed in the COPYRIGHT file, which is included
+ * within the source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+#include "budget.h"
+
+void solveBudget_c::start(unsigned long iterations) {
+  startIterations = iterations;
+  startTime = time(0);
+  reason = BR_NONE;
+}
+
+bool solveBudget_c::stop(unsigned int r) {
+
+#ifndef NO_THREADING
+  // when several threads cross limits at the same time, the first reason stays
+  unsigned int none = BR_NONE;
+  reason.compare_exchange_strong(none, r);
+#else
+  if (reason == BR_NONE)
+    reason = r;
+#endif
+
+  return true;
+}
+
+bool solveBudget_c::timeUp(void) {
+
+  if (maxTime && (unsigned long)(time(0) - startTime) >= maxTime)
+    return stop(BR_TIME);
+
+  return false;
+}
+
+bool solveBudget_c::checkAssembler(unsigned long iterations) {
+
+  if (reason != BR_NONE)
+    return true;
+
+  if (maxIterations && iterations - startIterations >= maxIterations)
+    return stop(BR_ITERATIONS);
+
+  return timeUp();
+}
+
+bool solveBudget_c::checkDisassembler(unsigned long memory) {
+
+  if (reason != BR_NONE)
+    return true;
+
+  if (maxMemory && memory >= maxMemory)
+    return stop(BR_MEMORY);
+
+  return timeUp();
+}
+
+const char * solveBudget_c::reasonText(unsigned int reason) {
+
+  switch (reason) {
+    case BR_NONE: return "no limit reached";
+    case BR_ITERATIONS: return "iteration limit reached";
+    case BR_TIME: return "time limit reached";
+    case BR_MEMORY: return "memory limit reached";
+    case BR_FILES: return "front files failed";
+  }
+
+  return "unknown";
+}
@@ -0,0 +1,113 @@
+/* BurrTools
+ *
+ * BurrTools is the legal property of its developers, whose
+ * names are listed in the COPYRIGHT file, which is included
+ * within the source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+#ifndef __BUDGET_H__
+#define __BUDGET_H__
+
+#include <time.h>
+
+#ifndef NO_THREADING
+#include <boost/atomic.hpp>
+#endif
+
+/**
+ * Limits for one run of a solver.
+ *
+ * The assemblers check the budget every few thousand iterations, the
+ * disassembler every few hundred nodes. Once a limit is crossed the reason is
+ * remembered and the engines stop at the next position they can resume from.
+ *
+ * All limits are 0 by default, meaning no limit.
+ *
+ * The disassemblers that analyse parts of a problem in parallel all check
+ * the same budget, so the checks may be called from several threads. The
+ * limits must be set and start called before the threads begin.
+ */
+class solveBudget_c {
+
+  public:
+
+    /** the reasons for stopping */
+    enum {
+      BR_NONE,       ///< no limit has been reached
+      BR_ITERATIONS, ///< the assembler has done the allowed number of iterations
+      BR_TIME,       ///< the time is up
+      BR_MEMORY,     ///< the disassembler node tables grew too big
+      BR_FILES       ///< the disassembler could not write or read the files of its fronts
+    };
+
+    solveBudget_c(void) : maxIterations(0), maxTime(0), maxMemory(0),
+      startIterations(0), startTime(0), reason(BR_NONE) {}
+
+    /** number of assembler iterations allowed in one run */
+    void setIterationLimit(unsigned long it) { maxIterations = it; }
+    /** seconds allowed for one run */
+    void setTimeLimit(unsigned long seconds) { maxTime = seconds; }
+    /** bytes the disassembler may use for its nodes */
+    void setMemoryLimit(unsigned long bytes) { maxMemory = bytes; }
+
+    bool limited(void) const { return maxIterations || maxTime || maxMemory; }
+
+    /** start a new run, iterations is the current iteration counter of the assembler */
+    void start(unsigned long iterations);
+
+    /** called by the assemblers, returns true, when they should stop */
+    bool checkAssembler(unsigned long iterations);
+
+    /** called by the disassemblers with the memory used for nodes, returns true, when they should stop */
+    bool checkDisassembler(unsigned long memory);
+
+    /**
+     * called by the disassemblers, when the files of their fronts fail, they
+     * give up the analysis like for a crossed limit, returns true
+     */
+    bool filesFailed(void) { return stop(BR_FILES); }
+
+    /** returns true, once a limit has been crossed */
+    bool exceeded(void) const { return reason != BR_NONE; }
+
+    /** the limit that has been crossed, BR_NONE if none */
+    unsigned int getReason(void) const { return reason; }
+
+    /** a short text for the reason */
+    static const char * reasonText(unsigned int reason);
+
+  private:
+
+    unsigned long maxIterations;
+    unsigned long maxTime;
+    unsigned long maxMemory;
+
+    unsigned long startIterations;
+    time_t startTime;
+
+#ifndef NO_THREADING
+    boost::atomic<unsigned int> reason;
+#else
+    unsigned int reason;
+#endif
+
+    /** remember r as the reason, when there is none yet, returns true */
+    bool stop(unsigned int r);
+
+    bool timeUp(void);
+};
+
+#endif
@@ -128,6 +128,9 @@ void burrGrower_c::grow(std::vector<puzzleSol_c*> currentSet) {
 
     // copy the pieces, here we make all variable shapes empty
     for (unsigned int p = 0; p < n->probShapeNumber(problem); p++) {
+
+      voxelEdit_c edit(*n->probGetShapeShape(problem, p));
+
       for (unsigned int ii = 0; ii < n->probGetShapeShape(problem, p)->getXYZ(); ii++)
         if (n->probGetShapeShape(problem, p)->getState(ii) == voxel_c::VX_VARIABLE)
           n->probGetShapeShape(problem, p)->setState(ii, voxel_c::VX_EMPTY);
@@ -228,9 +231,13 @@ void burrGrower_c::grow(std::vector<puzzleSol_c*> currentSet) {
 
     puzzle_c * ps = new puzzle_c(newSet[pos]->getPuzzle());
 
-    for (unsigned int ii = 0; ii < base->probGetShapeShape(problem, piece)->getXYZ(); ii++)
-      if (base->probGetShapeShape(problem, piece)->getState(ii) == voxel_c::VX_VARIABLE)
-        ps->probGetShapeShape(problem, piece)->setState(ii, voxel_c::VX_EMPTY);
+    {
+      voxelEdit_c edit(*ps->probGetShapeShape(problem, piece));
+
+      for (unsigned int ii = 0; ii < base->probGetShapeShape(problem, piece)->getXYZ(); ii++)
+        if (base->probGetShapeShape(problem, piece)->getState(ii) == voxel_c::VX_VARIABLE)
+          ps->probGetShapeShape(problem, piece)->setState(ii, voxel_c::VX_EMPTY);
+    }
 
     newSet.push_back(new puzzleSol_c(ps, problem));
 
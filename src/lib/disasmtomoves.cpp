@@ -152,17 +152,17 @@ int disasmToMoves_c::doRecursive(const separation_c * tree, int step, float * ar
      * take the last state, in this state the removed pieces have a
      * distance grater 1000
      */
-    const state_c * s = tree->getState(tree->getMoves());
+    const state_c s = tree->getState(tree->getMoves());
 
     /* find one of the removed pieces and one of the left pieces */
     unsigned int pc, pc2;
 
     for (pc = 0; pc < tree->getPieceNumber(); pc++)
-      if (s->pieceRemoved(pc))
+      if (s.pieceRemoved(pc))
         break;
 
     for (pc2 = 0; pc2 < tree->getPieceNumber(); pc2++)
-      if (!s->pieceRemoved(pc2))
+      if (!s.pieceRemoved(pc2))
         break;
 
     /* find out the direction the piece is removed */
@@ -170,12 +170,12 @@ int disasmToMoves_c::doRecursive(const separation_c * tree, int step, float * ar
 
     dx = dy = dz = 0;
 
-    if (s->getX(pc) >  10000) dx = size;
-    if (s->getX(pc) < -10000) dx = - size;
-    if (s->getY(pc) >  10000) dy = size;
-    if (s->getY(pc) < -10000) dy = - size;
-    if (s->getZ(pc) >  10000) dz = size;
-    if (s->getZ(pc) < -10000) dz = - size;
+    if (s.getX(pc) >  10000) dx = size;
+    if (s.getX(pc) < -10000) dx = - size;
+    if (s.getY(pc) >  10000) dy = size;
+    if (s.getY(pc) < -10000) dy = - size;
+    if (s.getZ(pc) >  10000) dz = size;
+    if (s.getZ(pc) < -10000) dz = - size;
 
     int steps, steps2;
 
@@ -187,25 +187,27 @@ int disasmToMoves_c::doRecursive(const separation_c * tree, int step, float * ar
        *
        * otherwise we place the removed part somewhere out of the way
        */
-      if (center_active)
+      if (center_active) {
+        const state_c s2 = tree->getState(tree->getMoves()-1);
+        const state_c r0 = tree->getRemoved()->getState(0);
         steps = doRecursive(tree->getRemoved(), step - (int)tree->getMoves(), array, center_active,
-            tree->getState(tree->getMoves()-1)->getX(pc) + cx - tree->getRemoved()->getState(0)->getX(0),
-            tree->getState(tree->getMoves()-1)->getY(pc) + cy - tree->getRemoved()->getState(0)->getY(0),
-            tree->getState(tree->getMoves()-1)->getZ(pc) + cz - tree->getRemoved()->getState(0)->getZ(0));
-      else
+            s2.getX(pc) + cx - r0.getX(0),
+            s2.getY(pc) + cy - r0.getY(0),
+            s2.getZ(pc) + cz - r0.getZ(0));
+      } else
         steps = doRecursive(tree->getRemoved(), step - (int)tree->getMoves(), array, center_active, cx+dx, cy+dy, cz+dz);
 
     } else {
 
-      const state_c * s2 = tree->getState(tree->getMoves()-1);
+      const state_c s2 = tree->getState(tree->getMoves()-1);
 
       /* if there is no removed tree, the pieces need to vanish */
       if (array)
         for (unsigned int p = 0; p < tree->getPieceNumber(); p++)
-          if (s->pieceRemoved(p)) {
-            array[4*tree->getPieceName(p)+0] += dx+cx+((mabs(s->getX(p))<10000)?(s->getX(p)):(s2->getX(p)));
-            array[4*tree->getPieceName(p)+1] += dy+cy+((mabs(s->getY(p))<10000)?(s->getY(p)):(s2->getY(p)));
-            array[4*tree->getPieceName(p)+2] += dz+cz+((mabs(s->getZ(p))<10000)?(s->getZ(p)):(s2->getZ(p)));
+          if (s.pieceRemoved(p)) {
+            array[4*tree->getPieceName(p)+0] += dx+cx+((mabs(s.getX(p))<10000)?(s.getX(p)):(s2.getX(p)));
+            array[4*tree->getPieceName(p)+1] += dy+cy+((mabs(s.getY(p))<10000)?(s.getY(p)):(s2.getY(p)));
+            array[4*tree->getPieceName(p)+2] += dz+cz+((mabs(s.getZ(p))<10000)?(s.getZ(p)):(s2.getZ(p)));
             array[4*tree->getPieceName(p)+3] += 0;
           }
 
@@ -232,7 +234,7 @@ int disasmToMoves_c::doRecursive(const separation_c * tree, int step, float * ar
        */
       if (array && center_active && (step - (int)tree->getMoves() < steps) && (tree->getRemoved())) {
         for (unsigned int p = 0; p < tree->getPieceNumber(); p++)
-          if (!s->pieceRemoved(p)) {
+          if (!s.pieceRemoved(p)) {
             array[4*tree->getPieceName(p)+3] = 0;
           }
       }
@@ -241,10 +243,10 @@ int disasmToMoves_c::doRecursive(const separation_c * tree, int step, float * ar
 
       if (array)
         for (unsigned int p = 0; p < tree->getPieceNumber(); p++)
-          if (!s->pieceRemoved(p)) {
-            array[4*tree->getPieceName(p)+0] += cx+s->getX(p);
-            array[4*tree->getPieceName(p)+1] += cy+s->getY(p);
-            array[4*tree->getPieceName(p)+2] += cz+s->getZ(p);
+          if (!s.pieceRemoved(p)) {
+            array[4*tree->getPieceName(p)+0] += cx+s.getX(p);
+            array[4*tree->getPieceName(p)+1] += cy+s.getY(p);
+            array[4*tree->getPieceName(p)+2] += cz+s.getZ(p);
             array[4*tree->getPieceName(p)+3] += 0;
           }
 
@@ -260,13 +262,13 @@ int disasmToMoves_c::doRecursive(const separation_c * tree, int step, float * ar
    * we also have to place the pieces at their initial position, when we are
    * before the current node
    */
-  const state_c * s = tree->getState(mmax(step, 0));
+  const state_c s = tree->getState(mmax(step, 0));
 
   if (array)
     for (unsigned int i = 0; i < tree->getPieceNumber(); i++) {
-      array[4*tree->getPieceName(i)+0] += cx+s->getX(i);
-      array[4*tree->getPieceName(i)+1] += cy+s->getY(i);
-      array[4*tree->getPieceName(i)+2] += cz+s->getZ(i);
+      array[4*tree->getPieceName(i)+0] += cx+s.getX(i);
+      array[4*tree->getPieceName(i)+1] += cy+s.getY(i);
+      array[4*tree->getPieceName(i)+2] += cz+s.getZ(i);
       array[4*tree->getPieceName(i)+3] += 1;
     }
 
@@ -23,6 +23,9 @@
 
 class separation_c;
 class assembly_c;
+class solveMetrics_c;
+class solveBudget_c;
+class disassemblerStats_c;
 
 /**
  * Base class for a disassembler.
@@ -53,6 +56,49 @@ public:
    */
   virtual separation_c * disassemble(const assembly_c * /*assembly*/) { return 0; }
 
+  /** set the metrics to publish the progress into, 0 to publish nothing */
+  virtual void setMetrics(solveMetrics_c * /*m*/) {}
+
+  /**
+   * set the limits, 0 for no limits. When a limit is crossed the disassembler
+   * gives up the analysis and returns 0, the caller must check the budget to
+   * find out whether the assembly really can not be disassembled
+   */
+  virtual void setBudget(solveBudget_c * /*b*/) {}
+
+  /**
+   * limit the memory used for the fronts of a breadth first search to about
+   * the given number of bytes, when the fronts get bigger they are moved into
+   * temporary files in directory (the system default place, when it is empty).
+   * 0 keeps everything in memory. Disassemblers that don't keep fronts ignore this
+   */
+  virtual void setFrontMemory(unsigned long /*memory*/, const char * /*directory*/) {}
+
+  /**
+   * load the movement values saved by an earlier run for the same shapes from
+   * directory, so that they don't need to be calculated again. Returns false,
+   * when nothing was loaded. This must be called before the first disassembly
+   */
+  virtual bool loadMovementCache(const char * /*directory*/) { return false; }
+
+  /** save the movement values calculated so far into directory for later runs */
+  virtual bool saveMovementCache(const char * /*directory*/) { return false; }
+
+  /**
+   * when on, positions that only differ by identical pieces having exchanged their
+   * places are treated as the same position. This makes the search a lot smaller
+   * for puzzles with several identical pieces, but the disassembly may then move
+   * another one of the identical pieces than without. Disassemblers that don't
+   * support this ignore it
+   */
+  virtual void setCanonicalNodes(bool /*on*/) {}
+
+  /**
+   * the counters collected during the last disassembly, 0 for disassemblers
+   * that don't collect any
+   */
+  virtual const disassemblerStats_c * getStats(void) const { return 0; }
+
 private:
 
   // no copying and assigning
@@ -24,7 +24,14 @@
 
 #include "disassemblernode.h"
 #include "disassemblerhashes.h"
-
+#include "disassembly.h"
+#include "movementanalysator.h"
+#include "executor.h"
+#include "frontfile.h"
+#include "problem.h"
+#include "puzzle.h"
+
+#include <algorithm>
 #include <queue>
 #include <vector>
 
@@ -77,8 +84,26 @@ separation_c * disassembler_0_c::disassemble_rec(const std::vector<unsigned int>
   // The current front will become the old front, the new front the current front and we
   // open up a new empty new front. The new built up open list will be used to get
   // the new nodes to analyse and an other open list will be started.
+  //
+  // With canonical nodes the fronts treat positions, where identical pieces have
+  // exchanged their places, as the same position. The nodes kept still contain the
+  // real pieces, each node is made from its come-from node, so the ways
+  // to the nodes stay valid. The fronts in files (see externalSearch) compare
+  // the nodes normally
+  std::vector<uint16_t> classes;
+  bool canonical = pieceClasses(pieces, classes);
+
   nodeHash closed[3];
 
+  for (unsigned int i = 0; i < 3; i++) {
+    closed[i].setStats(&stats);
+    if (canonical)
+      closed[i].setClasses(&classes[0]);
+  }
+
+  // the distance of the current front from the start node
+  unsigned int level = 0;
+
   // setup the fronts and the open List indices
   int curListFront = 0;
   int newListFront = 1;
@@ -89,67 +114,143 @@ separation_c * disassembler_0_c::disassemble_rec(const std::vector<unsigned int>
   // insert the start node
   closed[curFront].insert(start);
   openlist[curListFront].push(start);
+  stats.addFront(1, 1);
 
   /* while there are nodes left we should look at */
   while (!openlist[curListFront].empty()) {
 
-    /* remove the node from the open list and start examining */
-    disassemblerNode_c * node = openlist[curListFront].front();
-    openlist[curListFront].pop();
+    if (expandParallel(openlist[curListFront].size())) {
 
-    // Initialise a movement analysis for the current node
-    init_find(node, pieces);
+      /* big front: find the neighbours of all nodes of the current front
+       * in parallel, then do exactly what the serial search below does
+       * in the same order, so that we end up with the same result
+       */
+      std::vector<disassemblerNode_c *> front;
 
-    disassemblerNode_c * st;
+      while (!openlist[curListFront].empty()) {
+        front.push_back(openlist[curListFront].front());
+        openlist[curListFront].pop();
+      }
 
-    while ((st = find())) {
+      std::vector<std::vector<disassemblerNode_c *> > children(front.size());
 
-      /* check the different fronts and also try to insert into the new
-       * front, if it is known in either front, ...
-       */
-      if (closed[oldFront].contains(st) || closed[curFront].contains(st) || closed[newFront].insert(st)) {
+      expandFront(front, pieces, closed[oldFront], closed[curFront], children);
 
-        /* the new node is already here. We have found a new longer or equal long way to that
-         * node, so we can safely delete the new node and continue to the next
-         *
-         * we use the reference count mechanism of the node class, so if the node
-         * isn't use anywhere else, we can delete it here
-         */
-        if (st->decRefCount())
-          delete st;
+      disassemblerNode_c * sep = 0;
+      bool stop = false;
 
-        continue;
+      // the nodes the serial search would have examined, the others are only freed
+      unsigned int examined = 0;
+
+      for (unsigned int i = 0; i < front.size(); i++) {
+
+        if (!sep && !stop &&
+            ((countNode() &&
+              checkProgress(openlist[newListFront].size() + front.size() - i,
+                            closed[0].size() + closed[1].size() + closed[2].size(),
+                            pieces.size())) ||
+             cancelled()))
+          stop = true;
+
+        if (!sep && !stop)
+          examined++;
+
+        for (unsigned int j = 0; j < children[i].size(); j++) {
+
+          disassemblerNode_c * st = children[i][j];
+
+          /* known nodes in the old and current front have already been removed,
+           * once we have found a separation the remaining nodes are not needed
+           */
+          if (sep || stop || closed[newFront].insert(st)) {
+            if (st->decRefCount())
+              delete st;
+            continue;
+          }
+
+          if (!st->is_separation()) {
+            openlist[newListFront].push(st);
+            if (st->decRefCount())
+              delete st;
+            continue;
+          }
+
+          sep = st;
+        }
+      }
+
+      stats.addNodes(level, examined);
+
+      if (stop) {
+        if (sep && sep->decRefCount())
+          delete sep;
+        return 0;
       }
 
-      // when we get here the new found node was not known before
+      if (sep)
+        return separate(sep, pieces);
+
+    } else {
 
-      if (!st->is_separation()) {
+      /* remove the node from the open list and start examining */
+      disassemblerNode_c * node = openlist[curListFront].front();
+      openlist[curListFront].pop();
 
-        /* the new node is no solution so insert the node into
-         * the open list for later examination and go on to the next node
+      if ((countNode() &&
+           checkProgress(openlist[0].size() + openlist[1].size(),
+                         closed[0].size() + closed[1].size() + closed[2].size(),
+                         pieces.size())) ||
+          cancelled())
+        return 0;
+
+      // Initialise a movement analysis for the current node
+      init_find(node, pieces);
+      stats.addNodes(level, 1);
+
+      disassemblerNode_c * st;
+
+      while ((st = find())) {
+
+        /* check the different fronts and also try to insert into the new
+         * front, if it is known in either front, ...
          */
-        openlist[newListFront].push(st);
+        if (closed[oldFront].contains(st) || closed[curFront].contains(st) || closed[newFront].insert(st)) {
 
-        // we need to dec-ref-count because we will overwrite st in the next step
-        // and st hold one count of the node, once we get to use boost smart
-        // pointers this here will become simpler
-        if (st->decRefCount())
-          delete st;
+          /* the new node is already here. We have found a new longer or equal long way to that
+           * node, so we can safely delete the new node and continue to the next
+           *
+           * we use the reference count mechanism of the node class, so if the node
+           * isn't use anywhere else, we can delete it here
+           */
+          if (st->decRefCount())
+            delete st;
 
-        continue;
-      }
+          continue;
+        }
 
-      /* when we get here the new found node is a solution */
+        // when we get here the new found node was not known before
 
-      /* check the possible sub problems, this function call disassemble_rec recursively */
-      separation_c * res = checkSubproblems(st, pieces);
+        if (!st->is_separation()) {
 
-      if (st->decRefCount())
-        delete st;
+          /* the new node is no solution so insert the node into
+           * the open list for later examination and go on to the next node
+           */
+          openlist[newListFront].push(st);
 
-      return res;
+          // we need to dec-ref-count because we will overwrite st in the next step
+          // and st hold one count of the node, once we get to use boost smart
+          // pointers this here will become simpler
+          if (st->decRefCount())
+            delete st;
 
-      /* nodes inside the closed hashtables are freed automagically */
+          continue;
+        }
+
+        /* when we get here the new found node is a solution */
+        return separate(st, pieces);
+
+        /* nodes inside the closed hashtables are freed automagically */
+      }
     }
 
     // if the current front is completely checked, open up the new front
@@ -166,6 +267,65 @@ separation_c * disassembler_0_c::disassemble_rec(const std::vector<unsigned int>
       oldFront = curFront;
       curFront = newFront;
       newFront = (newFront + 1) % 3;
+
+      level++;
+      stats.addFront(openlist[curListFront].size(), closed[oldFront].size() + closed[curFront].size());
+
+      /* when the fronts get too big continue with the fronts in files, the
+       * old and the current front are written completely, the fronts before
+       * only contain the nodes that are on the way to the current front
+       */
+      if (frontMemory && !openlist[curListFront].empty() &&
+          (closed[oldFront].size() + closed[curFront].size()) * nodeMemory(pieces.size()) > frontMemory) {
+
+        std::vector<std::vector<disassemblerNode_c *> > levels(1);
+
+        closed[curFront].collect(levels[0]);
+
+        std::vector<disassemblerNode_c *> nodes;
+        closed[oldFront].collect(nodes);
+
+        while (!nodes.empty()) {
+
+          levels.push_back(nodes);
+          nodes.clear();
+
+          for (unsigned int i = 0; i < levels.back().size(); i++)
+            if (levels.back()[i]->getComefrom())
+              nodes.push_back(const_cast<disassemblerNode_c *>(levels.back()[i]->getComefrom()));
+
+          std::sort(nodes.begin(), nodes.end());
+          nodes.erase(std::unique(nodes.begin(), nodes.end()), nodes.end());
+        }
+
+        std::vector<frontFile_c *> fronts;
+
+        for (unsigned int l = levels.size(); l > 0; l--) {
+
+          frontBuilder_c builder(pieces.size(), frontMemory, frontDirectory);
+
+          for (unsigned int i = 0; i < levels[l-1].size(); i++)
+            builder.add(levels[l-1][i]);
+
+          frontFile_c * f = builder.finish(0, 0);
+
+          if (!f) {
+            for (unsigned int i = 0; i < fronts.size(); i++)
+              delete fronts[i];
+            filesFailed();
+            return 0;
+          }
+
+          fronts.push_back(f);
+        }
+
+        levels.clear();
+
+        for (unsigned int i = 0; i < 3; i++)
+          closed[i].clear();
+
+        return externalSearch(pieces, start, fronts);
+      }
     }
   }
 
@@ -175,3 +335,345 @@ separation_c * disassembler_0_c::disassemble_rec(const std::vector<unsigned int>
   // the nodes inside the hashtables are freed automatically
 }
 
+
+separation_c * disassembler_0_c::separate(disassemblerNode_c * st, const std::vector<unsigned int> & pieces) {
+
+  /* check the possible sub problems, this function call disassemble_rec recursively */
+  separation_c * res = checkSubproblems(st, pieces);
+
+  if (st->decRefCount())
+    delete st;
+
+  // when a sub problem ran out of budget, we don't know anything
+  if (res && budgetExceeded()) {
+    delete res;
+    res = 0;
+  }
+
+  return res;
+}
+
+separation_c * disassembler_0_c::externalSearch(const std::vector<unsigned int> & pieces, disassemblerNode_c * start,
+                                                std::vector<frontFile_c *> & fronts) {
+
+  unsigned int pn = pieces.size();
+  std::vector<int16_t> rec(frontFile_c::recordSize(pn));
+
+  separation_c * res = 0;
+  bool done = false;
+
+  while (!done) {
+
+    frontFile_c * cur = fronts.back();
+    frontFile_c * old = fronts.size() > 1 ? fronts[fronts.size()-2] : 0;
+
+    // the first front is the one with the start node
+    unsigned int level = fronts.size() - 1;
+
+    frontBuilder_c builder(pn, frontMemory, frontDirectory);
+
+    stats.addFront(cur->size(), cur->size() + (old ? old->size() : 0));
+
+    cur->rewind();
+
+    /* the nodes of the front are analysed in the order of the file, when there
+     * is a separation, the way to it is rebuilt from the fronts
+     */
+    while (!done && cur->read(&rec[0])) {
+
+      if ((countNode() && checkProgress(cur->size(), builder.inMemory(), pn)) || cancelled()) {
+        done = true;
+        break;
+      }
+
+      disassemblerNode_c * node = disassemblerNode_c::create(pn);
+
+      for (unsigned int i = 0; i < pn; i++)
+        node->set(i, rec[4*i+0], rec[4*i+1], rec[4*i+2], (uint16_t)rec[4*i+3]);
+
+      init_find(node, pieces);
+      stats.addNodes(level, 1);
+
+      disassemblerNode_c * st;
+
+      while ((st = find())) {
+
+        if (st->is_separation()) {
+          res = separateExternal(st, &rec[0], pieces, start, fronts);
+          done = true;
+          break;
+        }
+
+        builder.add(st);
+
+        if (st->decRefCount())
+          delete st;
+      }
+
+      if (node->decRefCount())
+        delete node;
+    }
+
+    if (!done) {
+
+      frontFile_c * next = cur->ok() ? builder.finish(cur, old) : 0;
+
+      if (!next) {
+        filesFailed();
+        done = true;
+      }
+
+      // when there are no new nodes, the puzzle can not be disassembled
+      else if (next->size() == 0) {
+        delete next;
+        done = true;
+      } else
+        fronts.push_back(next);
+    }
+  }
+
+  for (unsigned int i = 0; i < fronts.size(); i++)
+    delete fronts[i];
+  fronts.clear();
+
+  return res;
+}
+
+separation_c * disassembler_0_c::separateExternal(disassemblerNode_c * st, const int16_t * rec,
+                                                  const std::vector<unsigned int> & pieces, disassemblerNode_c * start,
+                                                  std::vector<frontFile_c *> & fronts) {
+
+  unsigned int pn = pieces.size();
+  unsigned int rs = frontFile_c::recordSize(pn);
+
+  /* the records of the way to the separation, all in the coordinates of the last
+   * record. The record found in a front may be moved against the come-from
+   * positions of the following record because the fronts only contain the positions
+   * relative to piece 0
+   */
+  std::vector<std::vector<int16_t> > way(fronts.size(), std::vector<int16_t>(rs));
+
+  std::copy(rec, rec+rs, way.back().begin());
+
+  for (unsigned int l = fronts.size()-1; l > 0; l--) {
+
+    const int16_t * from = &way[l][4*pn];
+
+    if (!fronts[l-1]->find(from, &way[l-1][0])) {
+
+      // the way must be there, unless the file can not be read
+      bt_assert2(!fronts[l-1]->ok());
+
+      if (st->decRefCount())
+        delete st;
+
+      filesFailed();
+      return 0;
+    }
+
+    for (unsigned int j = 0; j < 3; j++) {
+
+      int off = way[l-1][j] - from[j];
+
+      for (unsigned int i = 0; i < 2*pn; i++)
+        way[l-1][4*i+j] -= off;
+    }
+  }
+
+  // now move everything so that the first record is the start node
+  int d[3];
+  d[0] = way[0][0] - start->getX(0);
+  d[1] = way[0][1] - start->getY(0);
+  d[2] = way[0][2] - start->getZ(0);
+
+  disassemblerNode_c * node = start;
+
+  for (unsigned int l = 1; l < way.size(); l++) {
+
+    disassemblerNode_c * n = disassemblerNode_c::create(pn, node, 0, 0);
+
+    for (unsigned int i = 0; i < pn; i++)
+      n->set(i, way[l][4*i+0]-d[0], way[l][4*i+1]-d[1], way[l][4*i+2]-d[2], (uint16_t)way[l][4*i+3]);
+
+    if (node != start && node->decRefCount())
+      delete node;
+
+    node = n;
+  }
+
+  // the separating node itself, the removed pieces contain the direction they are removed in
+  disassemblerNode_c * s = disassemblerNode_c::create(pn, node, st->getDirection(), st->getAmount());
+
+  for (unsigned int i = 0; i < pn; i++)
+    if (st->is_piece_removed(i))
+      s->setRemove(i, st->getX(i), st->getY(i), st->getZ(i));
+    else
+      s->set(i, st->getX(i)-d[0], st->getY(i)-d[1], st->getZ(i)-d[2], st->getTrans(i));
+
+  if (node != start && node->decRefCount())
+    delete node;
+
+  if (st->decRefCount())
+    delete st;
+
+  return separate(s, pieces);
+}
+
+/* fronts smaller than this are not worth the overhead of the parallel expansion */
+static const unsigned long parallelFrontSize = 32;
+
+/* each task gets at least this many nodes */
+static const unsigned long nodesPerTask = 16;
+
+bool disassembler_0_c::expandParallel(unsigned long frontSize) {
+
+  return (frontSize >= parallelFrontSize) && (executor_c::instance().size() > 1);
+}
+
+/* expands every n-th node of a front, the tasks only read the old and
+ * the current front, those are not changed while the tasks run
+ */
+class frontExpansion_c : public task_c {
+
+  private:
+
+    movementAnalysator_c * analyse;
+    const std::vector<disassemblerNode_c *> & front;
+    const std::vector<unsigned int> & pieces;
+    const nodeHash & oldFront;
+    const nodeHash & curFront;
+    std::vector<std::vector<disassemblerNode_c *> > & children;
+    unsigned int first, step;
+
+  public:
+
+    /** an assert within the task is passed on to the thread waiting for it */
+    bool asserted;
+    assert_exception ae;
+
+    frontExpansion_c(movementAnalysator_c * a, const std::vector<disassemblerNode_c *> & f,
+        const std::vector<unsigned int> & p, const nodeHash & o, const nodeHash & c,
+        std::vector<std::vector<disassemblerNode_c *> > & ch, unsigned int fi, unsigned int st) :
+      analyse(a), front(f), pieces(p), oldFront(o), curFront(c), children(ch), first(fi), step(st), asserted(false) {}
+
+  protected:
+
+    void run(void) {
+
+      try {
+
+        for (unsigned int i = first; i < front.size(); i += step) {
+
+          analyse->init_find(front[i], pieces);
+
+          disassemblerNode_c * st;
+
+          while ((st = analyse->find())) {
+
+            if (oldFront.contains(st) || curFront.contains(st)) {
+              if (st->decRefCount())
+                delete st;
+              continue;
+            }
+
+            children[i].push_back(st);
+
+            /* the serial search stops at the first separation, so the rest of the
+             * neighbours are never needed and searching on can take very long
+             */
+            if (st->is_separation())
+              break;
+          }
+        }
+      }
+
+      catch (assert_exception & a) {
+        ae = a;
+        asserted = true;
+      }
+    }
+};
+
+void disassembler_0_c::expandFront(const std::vector<disassemblerNode_c *> & front, const std::vector<unsigned int> & pieces,
+                                   const nodeHash & oldFront, const nodeHash & curFront,
+                                   std::vector<std::vector<disassemblerNode_c *> > & children) {
+
+  unsigned int tasks = executor_c::instance().size();
+
+  if (tasks > front.size() / nodesPerTask)
+    tasks = front.size() / nodesPerTask;
+  if (tasks < 1)
+    tasks = 1;
+
+  if (helpers.size() < tasks) {
+
+    /* the analysators of the tasks read the shapes of the puzzle at the
+     * same time, so the lazily calculated values of the shapes must be there
+     */
+    getProblem().getPuzzle().prepareSharedCaches();
+
+    while (helpers.size() < tasks) {
+      helperStats.push_back(new disassemblerStats_c);
+      helpers.push_back(new movementAnalysator_c(getProblem(), true, sharedCache()));
+      helpers.back()->setStats(helperStats.back());
+    }
+  }
+
+  // the nodes are distributed round robin, neighbouring nodes often need similar work
+  std::vector<frontExpansion_c *> t;
+
+  for (unsigned int i = 0; i < tasks; i++) {
+    t.push_back(new frontExpansion_c(helpers[i], front, pieces, oldFront, curFront, children, i, tasks));
+    executor_c::instance().submit(t[i]);
+  }
+
+  bool asserted = false;
+  assert_exception ae;
+
+  for (unsigned int i = 0; i < tasks; i++) {
+
+    executor_c::instance().wait(t[i]);
+
+    if (t[i]->asserted && !asserted) {
+      asserted = true;
+      ae = t[i]->ae;
+    }
+
+    delete t[i];
+
+    stats.add(*helperStats[i]);
+    helperStats[i]->reset();
+  }
+
+  if (asserted) {
+
+    for (unsigned int i = 0; i < children.size(); i++) {
+      for (unsigned int j = 0; j < children[i].size(); j++)
+        if (children[i][j]->decRefCount())
+          delete children[i][j];
+      children[i].clear();
+    }
+
+    throw ae;
+  }
+}
+
+disassembler_0_c::~disassembler_0_c(void) {
+
+  for (unsigned int i = 0; i < helpers.size(); i++) {
+    delete helpers[i];
+    delete helperStats[i];
+  }
+}
+
+void disassembler_0_c::setFrontMemory(unsigned long memory, const char * directory) {
+  frontMemory = memory;
+  frontDirectory = directory ? directory : "";
+}
+
+disassembler_a_c * disassembler_0_c::newSibling(void) const {
+  disassembler_0_c * d = new disassembler_0_c(getProblem());
+  d->frontMemory = frontMemory;
+  d->frontDirectory = frontDirectory;
+  return d;
+}
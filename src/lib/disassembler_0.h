@@ -23,9 +23,16 @@
 
 #include "disassembler_a.h"
 
+#include <stdint.h>
+
+#include <string>
+
 class separation_c;
 
 class disassemblerNode_c;
+class movementAnalysator_c;
+class nodeHash;
+class frontFile_c;
 
 /**
  * This class is a disassembler especially tuned for simple analysis
@@ -33,6 +40,17 @@ class disassemblerNode_c;
  * All involved steps are of size one. This enables us to use a simple
  * tree search instead of A* which would normally be required for
  * a graph search
+ *
+ * Big fronts of the search are expanded in parallel on the executor, each
+ * task with its own movement analysator. The found nodes are merged in the
+ * same order the serial search would find them, so the result is always
+ * the same, regardless of the number of threads
+ *
+ * When the fronts of the search need more memory than allowed by setFrontMemory
+ * the search continues with the fronts in files. Duplicate nodes are then
+ * only removed once a complete front is known by sorting and merging
+ * the front (delayed duplicate detection). When the files can not be written
+ * or read the analysis is given up through the budget (solveBudget_c::BR_FILES)
  */
 class disassembler_0_c : public disassembler_a_c {
 
@@ -51,10 +69,60 @@ private:
    */
   separation_c * disassemble_rec(const std::vector<unsigned int> & pieces, disassemblerNode_c * start);
 
+  /** analyse the sub problems of a separating node found by disassemble_rec */
+  separation_c * separate(disassemblerNode_c * st, const std::vector<unsigned int> & pieces);
+
+  /**
+   * the movement analysators for the parallel front expansion, one
+   * for each task, they are created when they are needed first
+   */
+  std::vector<movementAnalysator_c *> helpers;
+
+  /** the counters of the helpers, they are added to ours after each parallel expansion */
+  std::vector<disassemblerStats_c *> helperStats;
+
+  /** returns true, when a front of the given size should be expanded in parallel */
+  bool expandParallel(unsigned long frontSize);
+
+  /**
+   * find all neighbours of the nodes in front that are neither in oldFront nor in
+   * curFront. The neighbours of front[i] are returned in children[i] in the
+   * order the movement analysator finds them. An assert within one of the tasks
+   * is thrown again once all tasks are finished, children is empty then
+   */
+  void expandFront(const std::vector<disassemblerNode_c *> & front, const std::vector<unsigned int> & pieces,
+                   const nodeHash & oldFront, const nodeHash & curFront,
+                   std::vector<std::vector<disassemblerNode_c *> > & children);
+
+  /** the memory allowed for the fronts in bytes, 0 for no limit */
+  unsigned long frontMemory;
+
+  /** where to place the files for the fronts */
+  std::string frontDirectory;
+
+  /**
+   * continue the search with the fronts in files, fronts contains all fronts
+   * of the search so far starting with the front with the start node, the
+   * last front is the one to analyse next. The fronts are freed
+   */
+  separation_c * externalSearch(const std::vector<unsigned int> & pieces, disassemblerNode_c * start,
+                                std::vector<frontFile_c *> & fronts);
+
+  /**
+   * rebuild the way from start to the separating node st that was found for the
+   * node stored in rec of the last front and analyse the sub problems
+   */
+  separation_c * separateExternal(disassemblerNode_c * st, const int16_t * rec, const std::vector<unsigned int> & pieces,
+                                  disassemblerNode_c * start, std::vector<frontFile_c *> & fronts);
+
+  disassembler_a_c * newSibling(void) const;
+
 public:
 
-  disassembler_0_c(const problem_c & puz) : disassembler_a_c(puz) { }
-  ~disassembler_0_c() { }
+  disassembler_0_c(const problem_c & puz) : disassembler_a_c(puz), frontMemory(0) { }
+  ~disassembler_0_c();
+
+  void setFrontMemory(unsigned long memory, const char * directory);
 
 private:
 
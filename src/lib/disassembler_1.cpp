@@ -0,0 +1,255 @@
+/* BurrTools
+ *
+ * BurrTools is the legal property of its developers, whose
+ * names are listed in the COPYRIGHT file, which is included
+ * within the source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+#include "disassembler_1.h"
+
+#include "bt_assert.h"
+#include "disassemblernode.h"
+#include "disassemblerhashes.h"
+#include "disassembly.h"
+#include "voxel.h"
+#include "problem.h"
+#include "puzzle.h"
+
+#include <queue>
+#include <vector>
+
+/* an entry of the open list. The priority queue returns the node with
+ * the smallest clearance first, nodes with the same clearance in the order
+ * they were found
+ */
+struct openNode {
+
+  disassemblerNode_c * node;
+  int clearance;
+  unsigned long order;
+
+  bool operator < (const openNode & b) const {
+    if (clearance != b.clearance)
+      return clearance > b.clearance;
+    return order > b.order;
+  }
+};
+
+/* calculates for each piece of the node and each axis, how far the piece needs to
+ * move along that axis until it is outside of the bounding box of all other pieces,
+ * taking the shorter of the two directions, and returns the sum. The boxes contain
+ * for each piece the bounding box relative to its position.
+ *
+ * To avoid comparing all pairs of pieces, the biggest and second biggest upper
+ * and the smallest and second smallest lower bounds of the boxes are used, the
+ * bound of all pieces except i is the second one, when piece i has the first
+ */
+static int clearance(const disassemblerNode_c * nd, const std::vector<int> & boxes) {
+
+  unsigned int pn = nd->getPiecenumber();
+
+  bt_assert(pn >= 2);
+  bt_assert(boxes.size() == 6*pn);
+
+  int sum = 0;
+
+  for (unsigned int axis = 0; axis < 3; axis++) {
+
+    int hi1 = 0, hi2 = 0, lo1 = 0, lo2 = 0;
+    unsigned int hiIdx = 0, loIdx = 0;
+
+    for (unsigned int i = 0; i < pn; i++) {
+
+      int pos = (axis == 0) ? nd->getX(i) : ((axis == 1) ? nd->getY(i) : nd->getZ(i));
+      int lo = pos + boxes[6*i+axis];
+      int hi = pos + boxes[6*i+3+axis];
+
+      if (i == 0 || hi > hi1) {
+        hi2 = hi1;
+        hi1 = hi;
+        hiIdx = i;
+      } else if (i == 1 || hi > hi2)
+        hi2 = hi;
+
+      if (i == 0 || lo < lo1) {
+        lo2 = lo1;
+        lo1 = lo;
+        loIdx = i;
+      } else if (i == 1 || lo < lo2)
+        lo2 = lo;
+    }
+
+    for (unsigned int i = 0; i < pn; i++) {
+
+      int pos = (axis == 0) ? nd->getX(i) : ((axis == 1) ? nd->getY(i) : nd->getZ(i));
+      int lo = pos + boxes[6*i+axis];
+      int hi = pos + boxes[6*i+3+axis];
+
+      int othersHi = (i == hiIdx) ? hi2 : hi1;
+      int othersLo = (i == loIdx) ? lo2 : lo1;
+
+      // the distances for the positive and the negative direction
+      int dp = othersHi - lo + 1;
+      int dn = hi - othersLo + 1;
+
+      if (dp < 0) dp = 0;
+      if (dn < 0) dn = 0;
+
+      sum += (dp < dn) ? dp : dn;
+    }
+  }
+
+  return sum;
+}
+
+/* this is an A* search, see the class description for the details. The structure
+ * is the same as in disassembler_0_c, the nodes are stored in 3 fronts and
+ * dropped, once they are no longer needed to detect moves back. Only the open lists
+ * are priority queues instead of simple queues
+ */
+separation_c * disassembler_1_c::disassemble_rec(const std::vector<unsigned int> &pieces, disassemblerNode_c * start) {
+
+  /* the bounding boxes of the pieces, the orientation of the pieces
+   * doesn't change, so they can be calculated once from the start node
+   */
+  std::vector<int> boxes(6*pieces.size());
+
+  for (unsigned int i = 0; i < pieces.size(); i++) {
+
+    const voxel_c * shape = getPieceShape(pieces[i]);
+    int hx, hy, hz;
+
+    bt_assert2(shape->getHotspot(start->getTrans(i), &hx, &hy, &hz));
+    bt_assert2(shape->getBoundingBox(start->getTrans(i),
+          &boxes[6*i+0], &boxes[6*i+1], &boxes[6*i+2],
+          &boxes[6*i+3], &boxes[6*i+4], &boxes[6*i+5]));
+
+    boxes[6*i+0] -= hx; boxes[6*i+3] -= hx;
+    boxes[6*i+1] -= hy; boxes[6*i+4] -= hy;
+    boxes[6*i+2] -= hz; boxes[6*i+5] -= hz;
+  }
+
+  std::priority_queue<openNode> openlist[2];
+  nodeHash closed[3];
+
+  // setup the fronts and the open List indices
+  int curListFront = 0;
+  int newListFront = 1;
+  int oldFront = 0;
+  int curFront = 1;
+  int newFront = 2;
+
+  // the number of nodes pushed into the open lists, keeps the order of equal nodes stable
+  unsigned long order = 0;
+
+  // insert the start node
+  closed[curFront].insert(start);
+
+  openNode o;
+  o.node = start;
+  o.clearance = clearance(start, boxes);
+  o.order = order++;
+  openlist[curListFront].push(o);
+
+  /* while there are nodes left we should look at */
+  while (!openlist[curListFront].empty()) {
+
+    /* remove the most promising node from the open list and start examining */
+    disassemblerNode_c * node = openlist[curListFront].top().node;
+    openlist[curListFront].pop();
+
+    if ((countNode() &&
+         checkProgress(openlist[0].size() + openlist[1].size(),
+                       closed[0].size() + closed[1].size() + closed[2].size(),
+                       pieces.size())) ||
+        cancelled())
+      return 0;
+
+    init_find(node, pieces);
+
+    disassemblerNode_c * st;
+
+    while ((st = find())) {
+
+      /* known nodes are dropped, just like in disassembler_0_c */
+      if (closed[oldFront].contains(st) || closed[curFront].contains(st) || closed[newFront].insert(st)) {
+
+        if (st->decRefCount())
+          delete st;
+
+        continue;
+      }
+
+      if (!st->is_separation()) {
+
+        o.node = st;
+        o.clearance = clearance(st, boxes);
+        o.order = order++;
+        openlist[newListFront].push(o);
+
+        if (st->decRefCount())
+          delete st;
+
+        continue;
+      }
+
+      /* the node is a solution, check the sub problems */
+      separation_c * res = checkSubproblems(st, pieces);
+
+      if (st->decRefCount())
+        delete st;
+
+      // when a sub problem ran out of budget, we don't know anything
+      if (res && budgetExceeded()) {
+        delete res;
+        res = 0;
+      }
+
+      return res;
+    }
+
+    // if the current front is completely checked, open up the new front
+    if (openlist[curListFront].empty()) {
+
+      // toggle the 2 lists of the fronts
+      curListFront = 1 - curListFront;
+      newListFront = 1 - newListFront;
+
+      // free the oldFront nodes
+      closed[oldFront].clear();
+
+      // circle the fronts
+      oldFront = curFront;
+      curFront = newFront;
+      newFront = (newFront + 1) % 3;
+    }
+  }
+
+  // we have not found a node that separated the problem, so return 0
+  return 0;
+}
+
+disassembler_1_c::disassembler_1_c(const problem_c & puz) : disassembler_a_c(puz) {
+
+  /* the bounding boxes and hotspots of the shapes are calculated on demand,
+   * make sure they are there before the sub problems are analysed in parallel
+   */
+  puz.getPuzzle().prepareSharedCaches();
+}
+
+disassembler_a_c * disassembler_1_c::newSibling(void) const {
+  return new disassembler_1_c(getProblem());
+}
@@ -0,0 +1,72 @@
+/* BurrTools
+ *
+ * BurrTools is the legal property of its developers, whose
+ * names are listed in the COPYRIGHT file, which is included
+ * within the source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+#ifndef __DISASSEMBLER_1_H__
+#define __DISASSEMBLER_1_H__
+
+#include "disassembler_a.h"
+
+class separation_c;
+
+class disassemblerNode_c;
+
+/**
+ * This disassembler uses an A* search instead of the breadth first search of disassembler_0_c.
+ *
+ * Each move costs one step, regardless of how far the pieces are moved. So
+ * the only admissible estimate for the remaining way of a position that does
+ * not fall apart is one step, all positions of a front have the same estimate
+ * and A* examines the positions front by front, just like the breadth first
+ * search. The result is a shortest disassembly, too.
+ *
+ * But within a front the positions are examined in the order of a second
+ * estimate: how far the pieces would need to travel along the axes to leave the
+ * bounding box of the other pieces, summed up over all pieces. Positions where
+ * pieces are nearly out are examined first, so the separating move is often found
+ * after a part of the last front only, while the breadth first search examines
+ * that front in the order the nodes were found.
+ *
+ * The disassembly found may differ from the one found by disassembler_0_c, the
+ * number of moves to the first separation is always the same though.
+ */
+class disassembler_1_c : public disassembler_a_c {
+
+private:
+
+  /**
+   * the real disassembler function.
+   */
+  separation_c * disassemble_rec(const std::vector<unsigned int> & pieces, disassemblerNode_c * start);
+
+  disassembler_a_c * newSibling(void) const;
+
+public:
+
+  disassembler_1_c(const problem_c & puz);
+  ~disassembler_1_c() { }
+
+private:
+
+  // no copying and assigning
+  disassembler_1_c(const disassembler_1_c&);
+  void operator=(const disassembler_1_c&);
+};
+
+#endif
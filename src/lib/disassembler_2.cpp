@@ -0,0 +1,178 @@
+/* BurrTools
+ *
+ * BurrTools is the legal property of its developers, whose
+ * names are listed in the COPYRIGHT file, which is included
+ * within the source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+#include "disassembler_2.h"
+
+#include "bt_assert.h"
+#include "disassemblernode.h"
+#include "disassemblerhashes.h"
+#include "disassembly.h"
+
+#include <vector>
+
+/* the depth limit of the first round of the search, this is more than the
+ * level of nearly all puzzles, the deeper rounds are only there for the
+ * rare puzzles with very long ways
+ */
+static const unsigned int firstLimit = 256;
+
+/* frees all nodes in the vector */
+static void release(std::vector<disassemblerNode_c *> & nodes) {
+
+  for (unsigned int i = 0; i < nodes.size(); i++)
+    if (nodes[i]->decRefCount())
+      delete nodes[i];
+
+  nodes.clear();
+}
+
+separation_c * disassembler_2_c::disassemble_rec(const std::vector<unsigned int> &pieces, disassemblerNode_c * start) {
+
+  for (unsigned int limit = firstLimit; ; limit *= 2) {
+
+    bool cut = false;
+
+    separation_c * res = search(pieces, start, limit, &cut);
+
+    if (!cut || budgetExceeded() || cancelled())
+      return res;
+  }
+}
+
+separation_c * disassembler_2_c::search(const std::vector<unsigned int> &pieces, disassemblerNode_c * start,
+                                        unsigned int limit, bool * cut) {
+
+  /* all positions found in this round, with canonical nodes positions that only
+   * differ by exchanged identical pieces are found once
+   */
+  std::vector<uint16_t> classes;
+  nodeTable_c visited;
+
+  if (pieceClasses(pieces, classes))
+    visited.setClasses(&classes[0]);
+
+  /* the positions that still need to be examined, the last one is the next, so the
+   * neighbours of the newest position are examined first. Each entry holds one
+   * reference to its node
+   */
+  std::vector<disassemblerNode_c *> stack;
+
+  std::vector<disassemblerNode_c *> found;
+
+  separation_c * res = 0;
+
+  visited.insert(start);
+  start->incRefCount();
+
+  start->incRefCount();
+  stack.push_back(start);
+
+  while (!stack.empty()) {
+
+    disassemblerNode_c * node = stack.back();
+    stack.pop_back();
+
+    if ((countNode() && checkProgress(stack.size(), visited.size(), pieces.size())) || cancelled()) {
+      if (node->decRefCount())
+        delete node;
+      break;
+    }
+
+    if (node->getWaylength() - start->getWaylength() >= limit) {
+
+      *cut = true;
+
+      if (node->decRefCount())
+        delete node;
+      continue;
+    }
+
+    init_find(node, pieces);
+
+    // the levels are the depths of the search and the front is the stack
+    stats.addNodes(node->getWaylength() - start->getWaylength(), 1);
+    stats.addFront(stack.size() + 1, visited.size());
+
+    disassemblerNode_c * st;
+    disassemblerNode_c * sep = 0;
+
+    while ((st = find())) {
+
+      /* greedy: the first separation is taken, no matter how far from start */
+      if (st->is_separation()) {
+        sep = st;
+        break;
+      }
+
+      /* positions that were reached before are dropped, even when the
+       * new way is shorter. When that cuts off positions at the limit, the next
+       * round will find them
+       */
+      if (visited.insert(st)) {
+        if (st->decRefCount())
+          delete st;
+        continue;
+      }
+
+      st->incRefCount();
+      found.push_back(st);
+    }
+
+    if (node->decRefCount())
+      delete node;
+
+    /* just like in the breadth first search the first separation decides,
+     * when its sub problems can not be disassembled, the assembly can't either
+     */
+    if (sep) {
+
+      res = checkSubproblems(sep, pieces);
+
+      if (sep->decRefCount())
+        delete sep;
+
+      // when a sub problem ran out of budget, we don't know anything
+      if (res && budgetExceeded()) {
+        delete res;
+        res = 0;
+      }
+
+      *cut = false;
+      break;
+    }
+
+    // the first found neighbour is examined first
+    for (unsigned int i = found.size(); i > 0; i--)
+      stack.push_back(found[i-1]);
+
+    found.clear();
+  }
+
+  release(found);
+  release(stack);
+  visited.addStats(stats);
+  visited.release();
+
+  return res;
+}
+
+disassembler_a_c * disassembler_2_c::newSibling(void) const {
+  return new disassembler_2_c(getProblem());
+}
@@ -0,0 +1,82 @@
+/* BurrTools
+ *
+ * BurrTools is the legal property of its developers, whose
+ * names are listed in the COPYRIGHT file, which is included
+ * within the source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+#ifndef __DISASSEMBLER_2_H__
+#define __DISASSEMBLER_2_H__
+
+#include "disassembler_a.h"
+
+class separation_c;
+
+class disassemblerNode_c;
+
+/**
+ * This disassembler only wants to know, whether an assembly comes apart.
+ *
+ * It uses a depth first search instead of the breadth first search of
+ * disassembler_0_c. The first separating move that is found is taken,
+ * regardless of how many moves were needed to get there. The search
+ * is limited in depth, when a search was cut off at the limit without
+ * finding a separation, it is repeated with twice the limit (iterative deepening).
+ * All positions found within one round are kept in a table, so each position
+ * is examined once per round. When a round wasn't cut off anywhere, all positions
+ * that can be reached have been examined.
+ *
+ * Just like in the breadth first search the first separation found decides,
+ * when its sub problems can not be disassembled, the assembly is rejected. As
+ * the two searches may find different separations first, they may come to different
+ * results for the same assembly.
+ *
+ * The disassemblies found are usually not the shortest ones, so the level
+ * of a puzzle can not be calculated from them, analyse the assembly again with
+ * disassembler_0_c for that.
+ */
+class disassembler_2_c : public disassembler_a_c {
+
+private:
+
+  /**
+   * the real disassembler function.
+   */
+  separation_c * disassemble_rec(const std::vector<unsigned int> & pieces, disassemblerNode_c * start);
+
+  /**
+   * one round of the depth first search up to limit moves away from start.
+   * cut is set, when no separation was found and there were positions at
+   * the limit that were not examined, only then another round makes sense
+   */
+  separation_c * search(const std::vector<unsigned int> & pieces, disassemblerNode_c * start,
+                        unsigned int limit, bool * cut);
+
+  disassembler_a_c * newSibling(void) const;
+
+public:
+
+  disassembler_2_c(const problem_c & puz) : disassembler_a_c(puz) { }
+  ~disassembler_2_c() { }
+
+private:
+
+  // no copying and assigning
+  disassembler_2_c(const disassembler_2_c&);
+  void operator=(const disassembler_2_c&);
+};
+
+#endif
@@ -24,12 +24,18 @@
 #include "problem.h"
 #include "grouping.h"
 #include "disassemblernode.h"
+#include "disassemblerhashes.h"
 #include "movementanalysator.h"
+#include "movementcache.h"
 #include "assembly.h"
 #include "disassembly.h"
+#include "metrics.h"
+#include "budget.h"
+#include "executor.h"
+#include "puzzle.h"
 
 disassembler_a_c::disassembler_a_c(const problem_c & puz) :
-  disassembler_c(), puzzle(puz) {
+  disassembler_c(), puzzle(puz), metrics(0), budget(0), nodeCount(0), interlockedCount(0), canonicalNodes(false) {
 
   /* Initialise the grouping class */
   groups = new grouping_c();
@@ -46,22 +52,78 @@ disassembler_a_c::disassembler_a_c(const problem_c & puz) :
     for (unsigned int j = 0; j < puz.getPartMaximum(i); j++)
       piece2shape[p++] = i;
 
-  analyse = new movementAnalysator_c(puzzle);
+  analyse = new movementAnalysator_c(puzzle, true);
+  analyse->setStats(&stats);
 }
 
 disassembler_a_c::~disassembler_a_c() {
   delete groups;
   delete [] piece2shape;
 
+  // the spares might use the movement cache of our analyser
+  for (unsigned int i = 0; i < spares.size(); i++)
+    delete spares[i];
+
   delete analyse;
 }
 
+bool disassembler_a_c::loadMovementCache(const char * directory) {
+  return analyse->getCache()->load(directory ? directory : "");
+}
+
+bool disassembler_a_c::saveMovementCache(const char * directory) {
+  return analyse->getCache()->save(directory ? directory : "");
+}
+
+disassembler_a_c * disassembler_a_c::getSibling(void) {
+
+  disassembler_a_c * sibling;
+
+  if (!spares.empty()) {
+    sibling = spares.back();
+    spares.pop_back();
+    sibling->stats.reset();
+  } else {
+
+    sibling = newSibling();
+    sibling->canonicalNodes = canonicalNodes;
+
+    // the sibling can use our movement cache instead of calculating everything again
+    if (sharedCache()) {
+      delete sibling->analyse;
+      sibling->analyse = new movementAnalysator_c(puzzle, true, sharedCache());
+      sibling->analyse->setStats(&sibling->stats);
+    }
+  }
+
+  sibling->budget = budget;
+  sibling->nodeCount = 0;
+  sibling->interlockedCount = 0;
+
+  return sibling;
+}
+
+void disassembler_a_c::putSibling(disassembler_a_c * sibling) {
+
+  stats.add(sibling->stats);
+  nodeCount += sibling->nodeCount;
+
+  if (metrics && sibling->interlockedCount)
+    metrics->addInterlocked(sibling->interlockedCount);
+
+  spares.push_back(sibling);
+}
+
+movementCache_c * disassembler_a_c::sharedCache(void) {
+  return analyse->getCache()->isShared() ? analyse->getCache() : 0;
+}
+
 /* create all the necessary parameters for one of the two possible subproblems
  * our current problems divides into
  */
 static void create_new_params(const disassemblerNode_c * st, disassemblerNode_c ** n, std::vector<unsigned int> & pn, const std::vector<unsigned int> & pieces, int part, bool cond) {
 
-  *n = new disassemblerNode_c(part);
+  *n = disassemblerNode_c::create(part);
 
   int num = 0;
 
@@ -106,6 +168,85 @@ separation_c * disassembler_a_c::checkSubproblem(int pieceCount, const std::vect
   return res;
 }
 
+/* analyses one of the 2 sub problems of a separation in a sibling disassembler.
+ * When the sub problem can not be disassembled the token is cancelled, so
+ * that the analysis of the other sub problem can be given up
+ */
+class subproblemTask_c : public task_c {
+
+  private:
+
+    disassembler_a_c * dis;
+    int pieceCount;
+    const std::vector<unsigned int> & pieces;
+    const disassemblerNode_c * st;
+    bool left;
+    cancelToken_c & failed;
+
+  public:
+
+    separation_c * res;
+    bool ok;
+
+    /** an assert within the task is passed on to the thread waiting for it */
+    bool asserted;
+    assert_exception ae;
+
+    subproblemTask_c(disassembler_a_c * d, int pc, const std::vector<unsigned int> & p,
+        const disassemblerNode_c * s, bool l, cancelToken_c & f) :
+      dis(d), pieceCount(pc), pieces(p), st(s), left(l), failed(f), res(0), ok(false), asserted(false) {}
+
+  protected:
+
+    void run(void) {
+
+      try {
+        res = dis->checkSubproblem(pieceCount, pieces, st, left, &ok);
+      }
+
+      catch (assert_exception & a) {
+        ae = a;
+        asserted = true;
+        ok = false;
+      }
+
+      if (!ok)
+        failed.cancel();
+    }
+};
+
+const voxel_c * disassembler_a_c::getPieceShape(unsigned int piece) const {
+  return puzzle.getPartShape(piece2shape[piece]);
+}
+
+bool disassembler_a_c::pieceClasses(const std::vector<unsigned int> & pieces, std::vector<uint16_t> & classes) const {
+
+  if (!canonicalNodes) return false;
+
+  classes.resize(pieces.size());
+
+  bool identical = false;
+
+  for (unsigned int i = 0; i < pieces.size(); i++) {
+    classes[i] = piece2shape[pieces[i]];
+
+    // the pieces of one part are next to each other
+    if (i > 0 && classes[i] == classes[i-1])
+      identical = true;
+  }
+
+  return identical;
+}
+
+bool disassembler_a_c::cancelled(void) const {
+
+  for (unsigned int i = 0; i < cancelTokens.size(); i++)
+    if (cancelTokens[i]->isCancelled())
+      return true;
+
+  return false;
+}
+
 separation_c * disassembler_a_c::checkSubproblems(const disassemblerNode_c * st, const std::vector<unsigned int> &pieces) {
 
   /* if we get here we have found a node that separated the puzzle into
@@ -140,11 +281,68 @@ separation_c * disassembler_a_c::checkSubproblems(const disassemblerNode_c * st,
    * else try to disassemble, if that fails, try to
    * group the involved pieces into an identical group
    */
-  remove = checkSubproblem(part1, pieces, st, false, &remove_ok);
+  if ((part1 > 1) && (part2 > 1) && !groups->hasGroups() && (executor_c::instance().size() > 1)) {
+
+    /* both sub problems need to be analysed, they are independent, so
+     * the removed part is analysed in a sibling disassembler while we
+     * do the left over part. When one part fails, the other is cancelled.
+     *
+     * Groups make the analysis depend on the order the sub problems are
+     * checked in, so puzzles with groups are always analysed in sequence
+     */
+    cancelToken_c failed;
+
+    disassembler_a_c * sibling = getSibling();
+
+    sibling->cancelTokens = cancelTokens;
+    sibling->cancelTokens.push_back(&failed);
+
+    subproblemTask_c task(sibling, part1, pieces, st, false, failed);
+    task.setCancelToken(&failed);
+    executor_c::instance().submit(&task);
+
+    cancelTokens.push_back(&failed);
+
+    try {
+      left = checkSubproblem(part2, pieces, st, true, &left_ok);
+    }
+
+    catch (assert_exception &) {
+      // the task uses our data, so it must be finished before we leave
+      cancelTokens.pop_back();
+      failed.cancel();
+      executor_c::instance().wait(&task);
+      delete task.res;
+      putSibling(sibling);
+      throw;
+    }
+
+    cancelTokens.pop_back();
+
+    if (!left_ok)
+      failed.cancel();
+
+    executor_c::instance().wait(&task);
+
+    putSibling(sibling);
+
+    if (task.asserted) {
+      delete left;
+      delete task.res;
+      throw task.ae;
+    }
+
+    remove = task.res;
+    remove_ok = task.ok;
 
-  /* only check the left over part, when the removed part is OK */
-  if (remove_ok)
-    left = checkSubproblem(part2, pieces, st, true, &left_ok);
+  } else {
+
+    remove = checkSubproblem(part1, pieces, st, false, &remove_ok);
+
+    /* only check the left over part, when the removed part is OK */
+    if (remove_ok)
+      left = checkSubproblem(part2, pieces, st, true, &left_ok);
+  }
 
   /* if both subproblems are either trivial or solvable, return the
    * result, otherwise return 0
@@ -154,10 +352,17 @@ separation_c * disassembler_a_c::checkSubproblems(const disassemblerNode_c * st,
     /* both subproblems are solvable -> construct tree */
     erg = new separation_c(left, remove, pieces);
 
-    const disassemblerNode_c * st2 = st;
+    /* the states are found backwards, starting at the separation, but
+     * they are added to the separation forwards
+     */
+    std::vector<const disassemblerNode_c *> path;
+
+    for (const disassemblerNode_c * st2 = st; st2; st2 = st2->getComefrom())
+      path.push_back(st2);
 
-    do {
-      state_c *s = new state_c(pieces.size());
+    for (unsigned int n = path.size(); n > 0; n--) {
+      const disassemblerNode_c * st2 = path[n-1];
+      state_c s(pieces.size());
 
       for (unsigned int i = 0; i < pieces.size(); i++) {
 
@@ -167,17 +372,15 @@ separation_c * disassembler_a_c::checkSubproblems(const disassemblerNode_c * st,
            */
           bt_assert(st2->getComefrom());
 
-          s->set(i, st2->getComefrom()->getX(i) + 20000*st2->getX(i),
+          s.set(i, st2->getComefrom()->getX(i) + 20000*st2->getX(i),
               st2->getComefrom()->getY(i) + 20000*st2->getY(i),
               st2->getComefrom()->getZ(i) + 20000*st2->getZ(i));
 
         } else
-          s->set(i, st2->getX(i), st2->getY(i), st2->getZ(i));
+          s.set(i, st2->getX(i), st2->getY(i), st2->getZ(i));
       }
       erg->addstate(s);
-
-      st2 = st2->getComefrom();
-    } while (st2);
+    }
 
   } else {
 
@@ -228,12 +431,52 @@ bool disassembler_a_c::subProbGrouping(const std::vector<unsigned int> & pn) {
   return true;
 }
 
+bool disassembler_a_c::checkProgress(unsigned long queue, unsigned long stored, unsigned int pieces) {
+
+  unsigned long memory = stored * nodeMemory(pieces);
+
+  if (metrics)
+    metrics->setDisassemblerProgress(nodeCount, queue, memory);
+
+  return budget && budget->checkDisassembler(memory);
+}
+
+unsigned long disassembler_a_c::nodeMemory(unsigned int pieces) {
+  // the tables are at most half full, so each node has at least 2 slots
+  return disassemblerNode_c::memory(pieces) + 2*nodeTable_c::slotSize();
+}
+
+bool disassembler_a_c::budgetExceeded(void) const {
+  return budget && budget->exceeded();
+}
+
+bool disassembler_a_c::filesFailed(void) {
+  bt_assert2(budget);
+  return budget->filesFailed();
+}
+
 separation_c * disassembler_a_c::disassemble(const assembly_c * assembly) {
 
+  stats.reset();
+
+  /* when parts of the analysis run in parallel, the analysers share our
+   * movement cache, prepare it for that
+   */
+  if (executor_c::instance().size() > 1)
+    analyse->getCache()->precompute(assembly);
+
+  return analyseAssembly(assembly);
+}
+
+separation_c * disassembler_a_c::analyseAssembly(const assembly_c * assembly) {
+
   bt_assert(puzzle.getNumberOfPieces() == assembly->placementCount());
   groups->reSet();
 
-  disassemblerNode_c * start = new disassemblerNode_c(assembly);
+  uint64_t startTime = disassemblerStats_c::now();
+  stats.analyses++;
+
+  disassemblerNode_c * start = disassemblerNode_c::create(assembly);
 
   if (start->getPiecenumber() < 2) {
     delete start;
@@ -250,11 +493,164 @@ separation_c * disassembler_a_c::disassemble(const assembly_c * assembly) {
     if (assembly->isPlaced(j))
       pieces.push_back(j);
 
+  /* most assemblies of many puzzles are completely interlocked, nothing
+   * can move at all. That can be seen in the movement matrices of the start
+   * node, so there is no need to set up the whole search for them
+   */
+  if (analyse->interlocked(start, pieces)) {
+
+    interlockedCount++;
+
+    if (metrics)
+      metrics->addInterlocked();
+
+    if (start->decRefCount())
+      delete start;
+
+    stats.time += disassemblerStats_c::now() - startTime;
+
+    return 0;
+  }
+
   separation_c * s = disassemble_rec(pieces, start);
 
   if (start->decRefCount())
     delete start;
 
+  stats.time += disassemblerStats_c::now() - startTime;
+
   return s;
 }
 
+
+/* disassembles every step-th assembly of a batch starting with first */
+class batchTask_c : public task_c {
+
+  private:
+
+    disassembler_a_c * dis;
+    const std::vector<const assembly_c *> & assemblies;
+    std::vector<disassemblyResult> & results;
+    unsigned int first, step;
+
+  public:
+
+    /** an assert within the task is passed on to the thread waiting for it */
+    bool asserted;
+    assert_exception ae;
+
+    batchTask_c(disassembler_a_c * d, const std::vector<const assembly_c *> & a,
+        std::vector<disassemblyResult> & r, unsigned int f, unsigned int s) :
+      dis(d), assemblies(a), results(r), first(f), step(s), asserted(false) {}
+
+  protected:
+
+    void run(void) {
+
+      try {
+
+        for (unsigned int i = first; i < assemblies.size(); i += step) {
+
+          unsigned long nodes = dis->getNodeCount();
+          uint64_t start = disassemblerStats_c::now();
+
+          results[i].disassembly = dis->analyseAssembly(assemblies[i]);
+          results[i].nodes = dis->getNodeCount() - nodes;
+          results[i].time = disassemblerStats_c::now() - start;
+        }
+      }
+
+      catch (assert_exception & a) {
+        ae = a;
+        asserted = true;
+      }
+    }
+};
+
+void disassembler_a_c::disassembleAll(const std::vector<const assembly_c *> & assemblies, std::vector<disassemblyResult> & results) {
+
+  results.resize(assemblies.size());
+
+  for (unsigned int i = 0; i < results.size(); i++) {
+    results[i].disassembly = 0;
+    results[i].nodes = 0;
+    results[i].time = 0;
+  }
+
+  unsigned int tasks = executor_c::instance().size();
+
+  if (tasks > assemblies.size())
+    tasks = assemblies.size();
+
+  if (tasks <= 1) {
+
+    disassemblerStats_c sum;
+
+    for (unsigned int i = 0; i < assemblies.size(); i++) {
+
+      unsigned long nodes = nodeCount;
+      uint64_t start = disassemblerStats_c::now();
+
+      results[i].disassembly = disassemble(assemblies[i]);
+      results[i].nodes = nodeCount - nodes;
+      results[i].time = disassemblerStats_c::now() - start;
+
+      sum.add(stats);
+    }
+
+    stats = sum;
+
+    return;
+  }
+
+  stats.reset();
+
+  /* the movement values of all assembled positions are calculated first,
+   * then the cache is shared by all the disassemblers of the tasks and must
+   * not be prepared again until they are finished. The lazily calculated values of
+   * the shapes are needed by the analysers of all tasks, so they must be there, too
+   */
+  for (unsigned int i = 0; i < assemblies.size(); i++)
+    analyse->getCache()->precompute(assemblies[i]);
+
+  puzzle.getPuzzle().prepareSharedCaches();
+
+  // the assemblies are distributed round robin, neighbouring solutions often need similar work
+  std::vector<disassembler_a_c *> siblings;
+  std::vector<batchTask_c *> t;
+
+  for (unsigned int i = 0; i < tasks; i++) {
+    siblings.push_back(getSibling());
+    t.push_back(new batchTask_c(siblings[i], assemblies, results, i, tasks));
+    executor_c::instance().submit(t[i]);
+  }
+
+  bool asserted = false;
+  assert_exception ae;
+
+  for (unsigned int i = 0; i < tasks; i++) {
+
+    executor_c::instance().wait(t[i]);
+
+    if (t[i]->asserted && !asserted) {
+      asserted = true;
+      ae = t[i]->ae;
+    }
+
+    putSibling(siblings[i]);
+    delete t[i];
+  }
+
+  if (metrics)
+    metrics->setDisassemblerProgress(nodeCount, 0, 0);
+
+  if (asserted) {
+
+    for (unsigned int i = 0; i < results.size(); i++) {
+      delete results[i].disassembly;
+      results[i].disassembly = 0;
+    }
+
+    throw ae;
+  }
+}
@@ -23,6 +23,9 @@
 
 #include "disassembler.h"
 #include "movementanalysator.h"
+#include "disassemblerstats.h"
+
+#include <stdint.h>
 
 #include <vector>
 
@@ -30,6 +33,16 @@ class grouping_c;
 class problem_c;
 class disassemblerNode_c;
 class assembly_c;
+class cancelToken_c;
+class voxel_c;
+class movementCache_c;
+
+/** the result for one assembly of disassembler_a_c::disassembleAll */
+struct disassemblyResult {
+  separation_c * disassembly; ///< the disassembly, 0 when the assembly can not be disassembled, the caller frees it
+  unsigned long nodes;        ///< number of nodes examined for the assembly
+  uint64_t time;              ///< microseconds the analysis took
+};
 
 /**
  * this class is a base-class for disassemblers.
@@ -46,6 +59,9 @@ class assembly_c;
  */
 class disassembler_a_c : public disassembler_c {
 
+  friend class subproblemTask_c;
+  friend class batchTask_c;
+
   private:
 
     /**
@@ -77,8 +93,125 @@ class disassembler_a_c : public disassembler_c {
 
     separation_c * checkSubproblem(int pieceCount, const std::vector<unsigned int> & pieces, const disassemblerNode_c * st, bool left, bool * ok);
 
+    /** where to publish the progress, may be 0 */
+    solveMetrics_c * metrics;
+
+    /** the limits, may be 0 */
+    solveBudget_c * budget;
+
+    /** number of nodes examined since the metrics were set */
+    unsigned long nodeCount;
+
+    /** number of analyses that ended at once because nothing could move, counted for the siblings */
+    unsigned long interlockedCount;
+
+    /** compare the nodes in the canonical form, see setCanonicalNodes */
+    bool canonicalNodes;
+
+    /**
+     * Disassemblers for the sub problems that are analysed in parallel.
+     *
+     * Each task needs its own disassembler, they are kept here while they
+     * are not in use so that they don't need to be created again. They
+     * share the movement cache of this disassembler
+     */
+    std::vector<disassembler_a_c *> spares;
+
+    /**
+     * when one of these tokens is cancelled, the result of the current analysis
+     * is no longer needed. The last entry belongs to the innermost parallel
+     * sub problem analysis
+     */
+    std::vector<const cancelToken_c *> cancelTokens;
+
+    /**
+     * get a disassembler for a parallel analysis, either one of the spares or
+     * a new one, that shares the movement cache, when it is shared. It checks our
+     * budget, but the metrics must only be written by our thread, so its counts
+     * are passed on by putSibling. Put it back with putSibling when it is no longer needed
+     */
+    disassembler_a_c * getSibling(void);
+
+    /** add the counters of the sibling to ours and put it back into spares */
+    void putSibling(disassembler_a_c * sibling);
+
+    /** disassemble, but without preparing the movement cache */
+    separation_c * analyseAssembly(const assembly_c * assembly);
+
   protected:
 
+    /**
+     * the counters for getStats, the disassemblers add the nodes they expand,
+     * the fronts and their node hashes
+     */
+    disassemblerStats_c stats;
+
+    /**
+     * the disassemblers call this for each node they examine, when
+     * true is returned, they should call checkProgress
+     */
+    bool countNode(void) {
+      nodeCount++;
+      return (metrics || budget) && ((nodeCount & 0x3FF) == 0);
+    }
+
+    /**
+     * publish the disassembler progress and check the budget, queue is the number of
+     * nodes waiting to be examined, stored the number of nodes kept, and pieces the
+     * number of pieces within the nodes.
+     * Returns true, when the budget is exceeded and the analysis must be given up
+     */
+    bool checkProgress(unsigned long queue, unsigned long stored, unsigned int pieces);
+
+    /**
+     * the memory used for one node with the given number of pieces that is
+     * stored in the node hashes of the search
+     */
+    static unsigned long nodeMemory(unsigned int pieces);
+
+    /** returns true, when the analysis has to be given up because of the budget */
+    bool budgetExceeded(void) const;
+
+    /**
+     * the files of the search could not be written or read, the analysis is given
+     * up like for an exceeded budget and true is returned. Without a budget there
+     * is nobody to tell, so it is an assert then
+     */
+    bool filesFailed(void);
+
+    /**
+     * returns true, when the analysis running in this disassembler is no longer
+     * needed because a parallel analysed sub problem was not disassembable.
+     * disassemble_rec should return 0 as soon as possible then
+     */
+    bool cancelled(void) const;
+
+    /**
+     * create a new disassembler of the same kind for the same problem, it is used
+     * to analyse sub problems in parallel
+     */
+    virtual disassembler_a_c * newSibling(void) const = 0;
+
+    /** the problem that is analysed */
+    const problem_c & getProblem(void) const { return puzzle; }
+
+    /**
+     * the movement cache, when it can be used by other analysers running in
+     * parallel, 0 otherwise
+     */
+    movementCache_c * sharedCache(void);
+
+    /** the shape of the given piece of the problem */
+    const voxel_c * getPieceShape(unsigned int piece) const;
+
+    /**
+     * fill classes with the classes of the given pieces for the canonical
+     * comparison of the nodes, the pieces of one part get the same class.
+     * Returns false, when the nodes should be compared normally because
+     * the canonical nodes are switched off or there are no identical pieces
+     */
+    bool pieceClasses(const std::vector<unsigned int> & pieces, std::vector<uint16_t> & classes) const;
+
     /** start analysing the position given in the disassemblerNode */
     void init_find(disassemblerNode_c * nd, const std::vector<unsigned int> & pieces) {
       analyse->init_find(nd, pieces);
@@ -119,6 +252,30 @@ class disassembler_a_c : public disassembler_c {
      */
     separation_c * disassemble(const assembly_c * assembly);
 
+    /**
+     * Disassemble many assemblies of the puzzle.
+     *
+     * The assemblies are analysed in parallel on the executor by disassemblers
+     * of the same kind that share the movement cache of this one. results gets one
+     * entry for each assembly in the same order as the assemblies. The budget is
+     * checked by all of them, the metrics get their nodes once they are finished.
+     * getStats returns the sum of the counters of all assemblies afterwards
+     */
+    void disassembleAll(const std::vector<const assembly_c *> & assemblies, std::vector<disassemblyResult> & results);
+
+    void setMetrics(solveMetrics_c * m) { metrics = m; nodeCount = 0; }
+
+    /** number of nodes examined since the disassembler was created or the metrics were set */
+    unsigned long getNodeCount(void) const { return nodeCount; }
+    void setBudget(solveBudget_c * b) { budget = b; }
+
+    bool loadMovementCache(const char * directory);
+    bool saveMovementCache(const char * directory);
+
+    const disassemblerStats_c * getStats(void) const { return &stats; }
+
+    void setCanonicalNodes(bool on) { canonicalNodes = on; }
+
   private:
 
     // no copying and assigning
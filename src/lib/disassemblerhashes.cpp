@@ -21,225 +21,281 @@
 #include "disassemblerhashes.h"
 
 #include "disassemblernode.h"
+#include "disassemblerstats.h"
 
-nodeHash::nodeHash(void) {
+#include <string.h>
 
-  tab_size = 11;
-  tab_entries = 0;
+/* the initial size of the tables */
+static const unsigned long initialSize = 16;
 
-  tab = new disassemblerNode_c* [tab_size];
+/* number of entries of the old table that are moved with each insertion,
+ * the old table is completely moved long before the new one needs to grow
+ */
+static const unsigned long moveStep = 4;
+
+/* disassemblerNode_c::hash only does the body of murmur3 for each piece and
+ * canonicalHash adds up the values of the pieces, neither mixes the bits of the
+ * last steps into the low bits that select the entry. So this is the finaliser
+ * of murmur3, it is done here once for the tables instead of in the hash functions
+ */
+static unsigned long slot(unsigned int h, unsigned long size) {
 
-  memset(tab, 0, tab_size*sizeof(disassemblerNode_c*));
+  h ^= h >> 16;
+  h *= 0x85ebca6b;
+  h ^= h >> 13;
+  h *= 0xc2b2ae35;
+  h ^= h >> 16;
+
+  return h & (size-1);
 }
 
-nodeHash::~nodeHash(void) {
-  clear();
+nodeTable_c::nodeTable_c(void) : tab_size(initialSize), old(0), old_size(0), moved(0), entries(0),
+  inserts(0), probes(0), maxProbe(0), classes(0) {
+
+  tab = new entry[tab_size];
+  memset(tab, 0, tab_size*sizeof(entry));
+}
+
+nodeTable_c::~nodeTable_c(void) {
 
   delete [] tab;
+  delete [] old;
 }
 
-void nodeHash::clear(void)
-{
-  for (unsigned int i = 0; i < tab_size; i++) {
-    while (tab[i]) {
-      disassemblerNode_c * n = tab[i];
-      tab[i] = n->next;
-
-      if (n->decRefCount())
-        delete n;
-    }
+unsigned int nodeTable_c::hashOf(const disassemblerNode_c * n) const {
+  return classes ? n->canonicalHash(classes) : n->hash();
+}
+
+nodeTable_c::entry * nodeTable_c::probe(entry * t, unsigned long size, unsigned int h, const disassemblerNode_c * n, unsigned long & len) const {
+
+  unsigned long i = slot(h, size);
+
+  len++;
+
+  while (t[i].node) {
+
+    if (t[i].hash == h && (classes ? t[i].node->canonicalEquals(*n, classes) : *(t[i].node) == *n))
+      break;
+
+    i = (i+1) & (size-1);
+    len++;
   }
 
-  tab_entries = 0;
+  return t+i;
 }
 
-const disassemblerNode_c * nodeHash::insert(disassemblerNode_c * n) {
+disassemblerNode_c * nodeTable_c::find(const disassemblerNode_c * n) const {
 
-  unsigned long h = n->hash() % tab_size;
+  unsigned int h = hashOf(n);
 
-  disassemblerNode_c * hn = tab[h];
+  // find is used by several threads at the same time, so it is not counted
+  unsigned long len = 0;
 
-  while (hn) {
-    if (*hn == *n) {
+  entry * e = probe(tab, tab_size, h, n, len);
 
-      // let's see, a node for this state already exists, if the found way to this
-      // node is longer than the current way, we replace it with the data of the current
-      // node
-      if (hn->getWaylength() > n->getWaylength())
-        hn->replaceNode(n);
+  /* the entries of the old table stay in place while they are moved,
+   * so it can be searched just like before
+   */
+  if (!e->node && old)
+    e = probe(old, old_size, h, n, len);
 
-      return hn;
-    }
+  return e->node;
+}
+
+disassemblerNode_c * nodeTable_c::insert(disassemblerNode_c * n) {
+
+  unsigned int h = hashOf(n);
+  unsigned long len = 0;
+
+  inserts++;
+
+  entry * e = probe(tab, tab_size, h, n, len);
 
-    hn = hn->next;
+  if (!e->node && old) {
+    entry * o = probe(old, old_size, h, n, len);
+    if (o->node) e = o;
   }
 
-  /* node not in table, insert */
-  n->incRefCount();
+  probes += len;
+  if (len > maxProbe) maxProbe = len;
+
+  if (e->node) return e->node;
+
+  // e is the empty entry where the probing stopped
+  e->hash = h;
+  e->node = n;
+  entries++;
 
-  n->next = tab[h];
-  tab[h] = n;
+  if (old) {
 
-  tab_entries++;
-  if (tab_entries > tab_size) {
-    // rehash
+    moveEntries();
 
-    unsigned long new_size = tab_size * 4 + 1;
+  } else if (2*entries > tab_size) {
 
-    disassemblerNode_c ** new_tab = new disassemblerNode_c* [new_size];
-    memset(new_tab, 0, new_size*sizeof(disassemblerNode_c*));
+    // start a new table, the entries are moved over with the next insertions
+    old = tab;
+    old_size = tab_size;
+    moved = 0;
 
-    for (unsigned int i = 0; i < tab_size; i++) {
-      while (tab[i]) {
-        disassemblerNode_c * n = tab[i];
-        tab[i] = n->next;
-        unsigned long h = n->hash() % new_size;
-        n->next = new_tab[h];
-        new_tab[h] = n;
-      }
-    }
+    tab_size *= 2;
+    tab = new entry[tab_size];
+    memset(tab, 0, tab_size*sizeof(entry));
 
-    delete[] tab;
-    tab = new_tab;
-    tab_size = new_size;
+    moveEntries();
   }
 
   return 0;
 }
 
-bool nodeHash::contains(const disassemblerNode_c * n) const {
-  unsigned long h = n->hash() % tab_size;
+void nodeTable_c::moveEntries(void) {
+
+  for (unsigned long i = 0; i < moveStep && moved < old_size; i++, moved++) {
+
+    if (!old[moved].node) continue;
 
-  disassemblerNode_c * hn = tab[h];
+    unsigned long j = slot(old[moved].hash, tab_size);
 
-  while (hn) {
-    if (*hn == *n)
-      return true;
+    while (tab[j].node)
+      j = (j+1) & (tab_size-1);
 
-    hn = hn->next;
+    tab[j] = old[moved];
   }
 
-  return false;
+  if (moved == old_size) {
+    delete [] old;
+    old = 0;
+  }
 }
 
+void nodeTable_c::release(void) {
 
+  for (unsigned long i = 0; i < tab_size; i++)
+    if (tab[i].node && tab[i].node->decRefCount())
+      delete tab[i].node;
 
-countingNodeHash::countingNodeHash(void) {
+  // the entries of the old table below moved are also in the current table
+  if (old)
+    for (unsigned long i = moved; i < old_size; i++)
+      if (old[i].node && old[i].node->decRefCount())
+        delete old[i].node;
 
-  tab_size = 100;
-  tab_entries = 0;
+  reset();
+}
 
-  tab = new hashNode * [tab_size];
+void nodeTable_c::reset(void) {
 
-  memset(tab, 0, tab_size*sizeof(hashNode*));
+  memset(tab, 0, tab_size*sizeof(entry));
 
-  scanPtr = 0;
-  scanActive = false;
+  delete [] old;
+  old = 0;
 
-  linkStart = 0;
+  entries = 0;
 }
 
-countingNodeHash::~countingNodeHash(void)
-{
-  clear();
-  delete [] tab;
-}
+void nodeTable_c::addStats(disassemblerStats_c & stats) {
 
-/* delete all nodes and empty table for new usage */
-void countingNodeHash::clear(void)
-{
-  hashNode * hn = linkStart;
+  stats.hashInserts += inserts;
+  stats.hashProbes += probes;
+  if (maxProbe > stats.hashMaxProbe) stats.hashMaxProbe = maxProbe;
 
-  while (hn) {
-    hashNode * hn2 = hn->link;
+  if (entries) {
+    stats.hashEntries += entries;
+    stats.hashSlots += tab_size;
+  }
 
-    if (hn->dat->decRefCount())
-      delete hn->dat;
+  inserts = probes = maxProbe = 0;
+}
 
-    delete hn;
+void nodeTable_c::collect(std::vector<disassemblerNode_c *> & nodes) const {
 
-    hn = hn2;
-  }
+  for (unsigned long i = 0; i < tab_size; i++)
+    if (tab[i].node)
+      nodes.push_back(tab[i].node);
 
-  memset(tab, 0, tab_size*sizeof(hashNode*));
-  tab_entries = 0;
-  linkStart = 0;
+  // the entries of the old table below moved are also in the current table
+  if (old)
+    for (unsigned long i = moved; i < old_size; i++)
+      if (old[i].node)
+        nodes.push_back(old[i].node);
 }
 
-bool countingNodeHash::insert(disassemblerNode_c * n) {
+nodeHash::~nodeHash(void) {
+  clear();
+}
 
-  unsigned long h = n->hash() % tab_size;
+void nodeHash::clear(void)
+{
+  if (stats)
+    tab.addStats(*stats);
 
-  hashNode * hn = tab[h];
+  tab.release();
+}
+
+const disassemblerNode_c * nodeHash::insert(disassemblerNode_c * n) {
 
-  while (hn) {
-    if (*(hn->dat) == *n)
-      return true;
+  disassemblerNode_c * hn = tab.insert(n);
 
-    hn = hn->next;
+  if (hn) {
+    // let's see, a node for this state already exists, if the found way to this
+    // node is longer than the current way, we replace it with the data of the current
+    // node, in the canonical form the nodes may have identical pieces exchanged, those
+    // are left as they are, breadth first searches never find a shorter way later on anyway
+    if (hn->getWaylength() > n->getWaylength() && !tab.isCanonical())
+      hn->replaceNode(n);
+    return hn;
   }
 
-  /* node not in table, insert */
+  /* node not in table, it was inserted */
   n->incRefCount();
 
-  hn = new hashNode;
-  hn->dat = n;
+  return 0;
+}
 
-  hn->next = tab[h];
-  tab[h] = hn;
+countingNodeHash::~countingNodeHash(void)
+{
+  clear();
+}
 
-  hn->link = linkStart;
-  linkStart = hn;
+/* delete all nodes and empty table for new usage */
+void countingNodeHash::clear(void)
+{
+  for (unsigned long i = added.size(); i > 0; i--)
+    if (added[i-1]->decRefCount())
+      delete added[i-1];
 
-  tab_entries++;
-  if (tab_entries > tab_size) {
+  added.clear();
+  tab.reset();
 
-    unsigned long new_size = tab_size * 4 + 1;
+  // a search may have been given up in the middle of a scan
+  scanActive = false;
+}
 
-    hashNode ** new_tab = new hashNode* [new_size];
-    memset(new_tab, 0, new_size*sizeof(hashNode*));
+bool countingNodeHash::insert(disassemblerNode_c * n) {
 
-    for (unsigned int i = 0; i < tab_size; i++) {
-      while (tab[i]) {
-        hashNode * hn = tab[i];
-        tab[i] = hn->next;
-        unsigned long h = hn->dat->hash() % new_size;
-        hn->next = new_tab[h];
-        new_tab[h] = hn;
-      }
-    }
+  if (tab.insert(n))
+    return true;
 
-    delete[] tab;
-    tab = new_tab;
-    tab_size = new_size;
-  }
+  /* node not in table, it was inserted */
+  n->incRefCount();
+  added.push_back(n);
 
   return false;
 }
 
 void countingNodeHash::initScan(void) {
-
   bt_assert(!scanActive);
-
-  scanPtr = linkStart;
+  scanPos = added.size();
   scanActive = true;
 }
 
 const disassemblerNode_c * countingNodeHash::nextScan(void) {
-
   bt_assert(scanActive);
 
-  if (!scanPtr) {
+  if (!scanPos) {
     scanActive = false;
     return 0;
-
   } else {
-
-    disassemblerNode_c * res = scanPtr->dat;
-    scanPtr = scanPtr->link;
-
-    return res;
+    scanPos--;
+    return added[scanPos];
   }
 }
-
-
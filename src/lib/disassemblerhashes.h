@@ -21,8 +21,133 @@
 #ifndef __DISASSEMBLER_HASHES_H__
 #define __DISASSEMBLER_HASHES_H__
 
+#include "bt_assert.h"
+
+#include <vector>
+
+#include <stdint.h>
+
 class disassemblerNode_c;
+class disassemblerStats_c;
+
+/**
+ * The table behind the two node hashtables below.
+ *
+ * It is an open addressing table with linear probing. Each entry contains
+ * the hash value of the node next to the node pointer, so when probing only
+ * the nodes with the same hash value need to be compared and the nodes
+ * themselves are rarely touched.
+ *
+ * When the table gets too full a table twice the size is started and with
+ * each insertion a few entries of the old table are moved over. Until all
+ * are moved both tables are searched. That way there is never a pause to
+ * rehash the complete table.
+ *
+ * The table doesn't do anything with the nodes, it just stores the pointers
+ *
+ * The nodes are normally compared with their operator ==. When the table
+ * gets the classes of the pieces the nodes are compared in the canonical
+ * form instead, so nodes where identical pieces have exchanged places
+ * are the same node for the table.
+ */
+class nodeTable_c {
+
+  private:
+
+    struct entry {
+      /** the hash value of the node */
+      unsigned int hash;
+      /** the node, 0 for empty entries */
+      disassemblerNode_c * node;
+    };
+
+    /** the current table, the size is a power of 2 */
+    entry * tab;
+    unsigned long tab_size;
+
+    /** the table that is moved into the current table, or 0 */
+    entry * old;
+    unsigned long old_size;
+
+    /** the entries of the old table below this index are moved */
+    unsigned long moved;
+
+    /** number of nodes in the tables */
+    unsigned long entries;
+
+    /** counters for the statistics of the insertions */
+    unsigned long inserts, probes, maxProbe;
+
+    /** the classes of the pieces for the canonical comparison, 0 for the normal comparison */
+    const uint16_t * classes;
+
+    /** the hash value of n used by the table */
+    unsigned int hashOf(const disassemblerNode_c * n) const;
+
+    /**
+     * find the entry for node n with hash h in table t, this is either the entry with the node or an empty entry,
+     * the number of entries looked at is added to len
+     */
+    entry * probe(entry * t, unsigned long size, unsigned int h, const disassemblerNode_c * n, unsigned long & len) const;
+
+    /** move some entries from the old table into the current table */
+    void moveEntries(void);
+
+  public:
+
+    nodeTable_c(void);
+    ~nodeTable_c(void);
+
+    /** return the node that is equal to n, or 0 */
+    disassemblerNode_c * find(const disassemblerNode_c * n) const;
+
+    /**
+     * return the node that is equal to n, if there is none
+     * n is added to the table and 0 is returned
+     */
+    disassemblerNode_c * insert(disassemblerNode_c * n);
 
+    /**
+     * call decRefCount for all nodes and delete the ones that are
+     * no longer used, then empty the table
+     */
+    void release(void);
+
+    /** empty the table without doing anything with the nodes */
+    void reset(void);
+
+    /** append all nodes of the table to nodes */
+    void collect(std::vector<disassemblerNode_c *> & nodes) const;
+
+    /** number of nodes inside the table */
+    unsigned long size(void) const { return entries; }
+
+    /** the size of one slot, the table is grown before more than half of its slots are used */
+    static size_t slotSize(void) { return sizeof(entry); }
+
+    /**
+     * compare the nodes in the canonical form with the given classes of
+     * the pieces (see disassemblerNode_c::canonicalHash), 0 goes back to the
+     * normal comparison. The classes are not copied. This must only be
+     * changed while the table is empty
+     */
+    void setClasses(const uint16_t * c) { bt_assert(entries == 0); classes = c; }
+
+    /** are the nodes compared in the canonical form */
+    bool isCanonical(void) const { return classes != 0; }
+
+    /**
+     * add the insertion counters and the current load of the table to stats
+     * and start counting anew
+     */
+    void addStats(disassemblerStats_c & stats);
+
+  private:
+
+    // no copying and assigning
+    nodeTable_c(const nodeTable_c&);
+    void operator=(const nodeTable_c&);
+};
 
 /**
  * This is a hashtable that stores disassemblerNode_c pointer
@@ -34,24 +159,25 @@ class nodeHash {
 
   private:
 
-    /** current table size */
-    unsigned long tab_size;
-
-    /** current number of entries */
-    unsigned long tab_entries;
+    nodeTable_c tab;
 
-    /** the hashtable */
-    disassemblerNode_c ** tab;
+    /** where the counters of the table go, when it is emptied, may be 0 */
+    disassemblerStats_c * stats;
 
   public:
 
-    nodeHash(void);
-
+    nodeHash(void) : stats(0) {}
     ~nodeHash(void);
 
     /** delete all nodes and empty table for new usage */
     void clear(void);
 
+    /** collect the statistics of the table into s each time it is emptied */
+    void setStats(disassemblerStats_c * s) { stats = s; }
+
+    /** compare the nodes in the canonical form, see nodeTable_c::setClasses */
+    void setClasses(const uint16_t * c) { tab.setClasses(c); }
+
     /**
      * add a new node.
      *
@@ -61,7 +187,13 @@ class nodeHash {
     const disassemblerNode_c * insert(disassemblerNode_c * n);
 
     /** check, if a node is in the hashtable */
-    bool contains(const disassemblerNode_c * n) const;
+    bool contains(const disassemblerNode_c * n) const { return tab.find(n) != 0; }
+
+    /** append all nodes of the hashtable to nodes, the reference counts are not changed */
+    void collect(std::vector<disassemblerNode_c *> & nodes) const { tab.collect(nodes); }
+
+    /** number of nodes inside the table */
+    unsigned long size(void) const { return tab.size(); }
 
   private:
 
@@ -70,8 +202,6 @@ class nodeHash {
     void operator=(const nodeHash&);
 };
 
-
-
 /**
  * Hashtable like nodeHash with the additional feature
  * of scanning through all elements
@@ -86,43 +216,20 @@ class countingNodeHash {
 
   private:
 
-    /** current table size */
-    unsigned long tab_size;
-    /** current number of entries */
-    unsigned long tab_entries;
+    nodeTable_c tab;
 
-    /**
-     * hash node data structure
-     *
-     * this hash table is non intrusive, it stores a pointer
-     * to the disassembler node.
-     *
-     * This is more suitable here because the nodes normally live only
-     * a short time inside this table, while they stay for a very long
-     * time in the other table
-     */
-    struct hashNode {
-      /** the data of the node */
-      disassemblerNode_c * dat;
-      /** next entry in the bucket list */
-      hashNode * next;
-      /** the next entry of the all element link list */
-      hashNode * link;
-    };
+    /** all nodes in the order they were added */
+    std::vector<disassemblerNode_c *> added;
 
-    /** the hash table */
-    hashNode ** tab;
-    /** pointer to the inverse linked list of all added elements */
-    hashNode * linkStart;
+    /** current scan position, the next node returned is the one before this index */
+    unsigned long scanPos;
 
-    /** current scan position */
-    hashNode * scanPtr;
     /** is there a scan active? */
     bool scanActive;
 
   public:
 
-    countingNodeHash(void);
+    countingNodeHash(void) : scanPos(0), scanActive(false) {}
     ~countingNodeHash(void);
 
     /** delete all nodes and empty table for new usage */
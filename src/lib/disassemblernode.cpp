@@ -22,33 +22,189 @@
 
 #include "assembly.h"
 
-disassemblerNode_c::disassemblerNode_c(unsigned int pn, disassemblerNode_c * comf, int _dir, int _amount, int step) :
-    comefrom(comf), piecenumber(pn), dat(new int16_t[4*piecenumber]),
-    refcount(1), dir(_dir), amount(_amount), hashValue(0)
+#include <string.h>
+
+#include <algorithm>
+
+/* each block starts with a pointer to the free list it belongs to, or 0 for
+ * blocks from the heap, the node follows behind this pointer
+ */
+static const size_t blockHeader = 8;
+
+/* a new slab is requested, when the current one is used up, it contains at
+ * least this many bytes
+ */
+static const size_t slabSize = 64*1024;
+
+nodePool_c::~nodePool_c(void) {
+
+  for (unsigned int i = 0; i < slabs.size(); i++)
+    delete [] slabs[i];
+
+  for (unsigned int i = 0; i < lists.size(); i++)
+    delete lists[i];
+}
+
+void * nodePool_c::allocate(nodePool_c * pool, size_t size) {
+
+  char * block;
+
+  if (!pool) {
+
+    block = static_cast<char *>(::operator new(size + blockHeader));
+    *reinterpret_cast<freeList_c **>(block) = 0;
+
+  } else {
+
+    size_t idx = (size + 7) / 8;
+
+    if (idx >= pool->lists.size())
+      pool->lists.resize(idx+1, 0);
+
+    freeList_c * l = pool->lists[idx];
+
+    if (!l) {
+      l = new freeList_c;
+      l->first = 0;
+      l->blockSize = 8*idx + blockHeader;
+      l->cur = l->end = 0;
+      pool->lists[idx] = l;
+    }
+
+    if (l->first) {
+
+      block = static_cast<char *>(l->first);
+      l->first = *reinterpret_cast<void **>(block + blockHeader);
+
+    } else {
+
+      if (l->cur + l->blockSize > l->end) {
+
+        size_t s = slabSize;
+        if (s < 16*l->blockSize)
+          s = 16*l->blockSize;
+
+        l->cur = new char[s];
+        l->end = l->cur + s;
+        pool->slabs.push_back(l->cur);
+      }
+
+      block = l->cur;
+      l->cur += l->blockSize;
+    }
+
+    *reinterpret_cast<freeList_c **>(block) = l;
+  }
+
+  return block + blockHeader;
+}
+
+size_t nodePool_c::blockSize(size_t size) {
+  return 8*((size + 7) / 8) + blockHeader;
+}
+
+void nodePool_c::release(void * p) {
+
+  if (!p) return;
+
+  char * block = static_cast<char *>(p) - blockHeader;
+  freeList_c * l = *reinterpret_cast<freeList_c **>(block);
+
+  if (!l) {
+    ::operator delete(block);
+    return;
+  }
+
+  // the free blocks are linked through the first bytes behind the header
+  *reinterpret_cast<void **>(p) = l->first;
+  l->first = block;
+}
+
+disassemblerNode_c::disassemblerNode_c(unsigned int pn, disassemblerNode_c * comf, int _dir, int _amount, int step, bool cmp) :
+    comefrom(comf), refcount(1), dir(_dir), amount(_amount), hashValue(0), piecenumber(pn), compact(cmp)
 {
   bt_assert(comefrom);
+  bt_assert(pn <= 0xFFFF);
 
   comefrom->incRefCount();
   waylength = comf->waylength+step;
 }
 
 disassemblerNode_c::disassemblerNode_c(unsigned int pn) :
-    comefrom(0), piecenumber(pn), dat(new int16_t[4*piecenumber]),
-    refcount(1), dir(0), amount(0), hashValue(0), waylength(0)
+    comefrom(0), refcount(1), dir(0), amount(0), hashValue(0), waylength(0), piecenumber(pn), compact(false)
 {
+  bt_assert(pn <= 0xFFFF);
 }
 
-disassemblerNode_c::disassemblerNode_c(const assembly_c * assm) :
-    comefrom(0), piecenumber(0), refcount(1), dir(0), amount(0), hashValue(0), waylength(0)
-{
+bool disassemblerNode_c::fitsCompact(unsigned int pn, const int16_t * pos) {
+
+  for (unsigned int i = 0; i < pn; i++) {
+
+    for (unsigned int j = 0; j < 3; j++)
+      if (pos[4*i+j] - pos[j] < -128 || pos[4*i+j] - pos[j] > 127)
+        return false;
+
+    // 0xFF is the marker for removed pieces
+    if (pos[4*i+3] != (int16_t)0xFFFF && (pos[4*i+3] < 0 || pos[4*i+3] >= 0xFF))
+      return false;
+  }
+
+  return true;
+}
+
+disassemblerNode_c * disassemblerNode_c::create(nodePool_c * pool, unsigned int pn, disassemblerNode_c * comf,
+    int _dir, int _amount, const int16_t * pos, int step) {
+
+  bool cmp = fitsCompact(pn, pos);
+
+  disassemblerNode_c * n = new (pool, dataSize(pn, cmp)) disassemblerNode_c(pn, comf, _dir, _amount, step, cmp);
+
+  if (cmp) {
+
+    int16_t * base = n->wide();
+    int8_t * r = n->rel();
+
+    base[0] = pos[0];
+    base[1] = pos[1];
+    base[2] = pos[2];
+    base[3] = 0;
+
+    for (unsigned int i = 0; i < pn; i++) {
+      r[4*i+0] = pos[4*i+0] - pos[0];
+      r[4*i+1] = pos[4*i+1] - pos[1];
+      r[4*i+2] = pos[4*i+2] - pos[2];
+      r[4*i+3] = (pos[4*i+3] == (int16_t)0xFFFF) ? -1 : (int8_t)pos[4*i+3];
+    }
+
+  } else
+
+    memcpy(n->wide(), pos, 4*pn*sizeof(int16_t));
+
+  return n;
+}
+
+disassemblerNode_c * disassemblerNode_c::create(unsigned int pn, disassemblerNode_c * comf, int _dir, int _amount, int step) {
+
+  return new (0, dataSize(pn, false)) disassemblerNode_c(pn, comf, _dir, _amount, step, false);
+}
+
+disassemblerNode_c * disassemblerNode_c::create(unsigned int pn) {
+
+  return new (0, dataSize(pn, false)) disassemblerNode_c(pn);
+}
+
+disassemblerNode_c * disassemblerNode_c::create(const assembly_c * assm) {
+
   /* create the first node with the start state
    * here all pieces are at position (0; 0; 0)
    */
+  unsigned int pn = 0;
+
   for (unsigned int j = 0; j < assm->placementCount(); j++)
     if (assm->isPlaced(j))
-      piecenumber++;
+      pn++;
 
-  dat = new int16_t[4*piecenumber];
+  disassemblerNode_c * n = create(pn);
 
   /* create pieces field. This field contains the
    * names of all present pieces. Because at the start
@@ -58,23 +214,15 @@ disassemblerNode_c::disassemblerNode_c(const assembly_c * assm) :
   unsigned int pc = 0;
   for (unsigned int j = 0; j < assm->placementCount(); j++)
     if (assm->isPlaced(j)) {
-      bt_assert(
-          abs(assm->getX(j)) < maxMove &&
-          abs(assm->getY(j)) < maxMove &&
-          abs(assm->getZ(j)) < maxMove);
-
-      dat[4*pc+0] = assm->getX(j);
-      dat[4*pc+1] = assm->getY(j);
-      dat[4*pc+2] = assm->getZ(j);
-      dat[4*pc+3] = assm->getTransformation(j);
+      n->set(pc, assm->getX(j), assm->getY(j), assm->getZ(j), assm->getTransformation(j));
       pc++;
     }
+
+  return n;
 }
 
 disassemblerNode_c::~disassemblerNode_c() {
 
-  delete [] dat;
-
   if (comefrom && comefrom->decRefCount())
     delete comefrom;
 }
@@ -86,7 +234,31 @@ void disassemblerNode_c::replaceNode(const disassemblerNode_c *n) {
   bt_assert(piecenumber == n->piecenumber);
   bt_assert(hashValue == n->hashValue);
 
-  memcpy(dat, n->dat, 4*piecenumber*sizeof(int16_t));
+  if (compact) {
+
+    // the relative positions are the same, only the position of piece 0 may differ
+    int16_t * base = wide();
+
+    base[0] = n->getX(0);
+    base[1] = n->getY(0);
+    base[2] = n->getZ(0);
+
+  } else if (!n->compact) {
+
+    memcpy(wide(), n->wide(), 4*piecenumber*sizeof(int16_t));
+
+  } else {
+
+    int16_t * dat = wide();
+
+    for (unsigned int i = 0; i < piecenumber; i++) {
+      dat[4*i+0] = n->getX(i);
+      dat[4*i+1] = n->getY(i);
+      dat[4*i+2] = n->getZ(i);
+      dat[4*i+3] = n->wideTrans(i);
+    }
+  }
+
   dir = n->dir;
   amount = n->amount;
   waylength = n->waylength;
@@ -100,25 +272,46 @@ void disassemblerNode_c::replaceNode(const disassemblerNode_c *n) {
     comefrom->incRefCount();
 }
 
+/* the relative position and the transformation of a piece in one word, just
+ * like they are stored in compact nodes, for wide nodes the values are cut
+ * to 8 bits, that only gives a few more nodes with the same hash value
+ */
+static uint32_t pieceWord(int x, int y, int z, int trans) {
+  return (uint32_t)(uint8_t)x | ((uint32_t)(uint8_t)y << 8) | ((uint32_t)(uint8_t)z << 16) | ((uint32_t)(uint8_t)trans << 24);
+}
+
+/* one step of the hash calculation for the word w of a piece (the body of murmur3),
+ * the multiplications of the words don't depend on each other, so they can overlap
+ */
+static uint32_t hashStep(uint32_t h, uint32_t w) {
+
+  w *= 0xcc9e2d51;
+  w = (w << 15) | (w >> 17);
+  w *= 0x1b873593;
+
+  h ^= w;
+  h = (h << 13) | (h >> 19);
+  return h*5 + 0xe6546b64;
+}
+
 unsigned int disassemblerNode_c::hash(void) const
 {
   if (hashValue) return hashValue;
 
-  unsigned int h = 0x17fe3b3c;
+  uint32_t h = 0x17fe3b3c;
 
-  // as the zero-th entry of the transformation
-  // is not included in the loop below add it manually
-  h += dat[3];
+  if (compact) {
 
-  for (unsigned int i = 1; i < piecenumber; i++) {
-    h += (dat[4*i+0]-dat[0]);
-    h *= 1343;
-    h += (dat[4*i+1]-dat[1]);
-    h *= 923;
-    h += (dat[4*i+2]-dat[2]);
-    h *= 113;
-    h += (dat[4*i+3]);
-    h *= 23;
+    // the words are stored aligned, the compiler reads each with one load
+    const uint8_t * r = reinterpret_cast<const uint8_t *>(rel());
+
+    for (unsigned int i = 0; i < piecenumber; i++, r += 4)
+      h = hashStep(h, (uint32_t)r[0] | ((uint32_t)r[1] << 8) | ((uint32_t)r[2] << 16) | ((uint32_t)r[3] << 24));
+
+  } else {
+
+    for (unsigned int i = 0; i < piecenumber; i++)
+      h = hashStep(h, pieceWord(relX(i), relY(i), relZ(i), wideTrans(i)));
   }
 
   if (h == 0) h = 1;
@@ -129,20 +322,127 @@ unsigned int disassemblerNode_c::hash(void) const
 
 bool disassemblerNode_c::operator == (const disassemblerNode_c &b) const
 {
+  // compact nodes contain the relative positions, so those can be compared directly
+  if (compact && b.compact)
+    return memcmp(rel(), b.rel(), 4*piecenumber) == 0;
+
   // as the zero-th entry of the transformation
   // is not included in the loop below add it manually
-  if (dat[3] != b.dat[3]) return false;
+  if (wideTrans(0) != b.wideTrans(0)) return false;
 
   for (unsigned int i = 1; i < piecenumber; i++) {
-    if (dat[4*i+0] - dat[0] != b.dat[4*i+0] - b.dat[0]) return false;
-    if (dat[4*i+1] - dat[1] != b.dat[4*i+1] - b.dat[1]) return false;
-    if (dat[4*i+2] - dat[2] != b.dat[4*i+2] - b.dat[2]) return false;
-    if (dat[4*i+3] != b.dat[4*i+3]) return false;
+    if (relX(i) != b.relX(i)) return false;
+    if (relY(i) != b.relY(i)) return false;
+    if (relZ(i) != b.relZ(i)) return false;
+    if (wideTrans(i) != b.wideTrans(i)) return false;
   }
 
   return true;
 }
 
+/* one piece of a node in the form used for the canonical comparison */
+struct canonicalPiece {
+  uint16_t cls;
+  int16_t trans;
+  int x, y, z;
+
+  bool operator < (const canonicalPiece & b) const {
+    if (cls != b.cls) return cls < b.cls;
+    if (trans != b.trans) return trans < b.trans;
+    if (x != b.x) return x < b.x;
+    if (y != b.y) return y < b.y;
+    return z < b.z;
+  }
+
+  bool operator != (const canonicalPiece & b) const {
+    return cls != b.cls || trans != b.trans || x != b.x || y != b.y || z != b.z;
+  }
+};
+
+/* the smallest coordinates of all pieces, all pieces of one class are shifted
+ * by the same amount, so this doesn't depend on which piece is where
+ */
+static void minPosition(const disassemblerNode_c & n, int & mx, int & my, int & mz) {
+
+  mx = n.getX(0);
+  my = n.getY(0);
+  mz = n.getZ(0);
+
+  for (unsigned int i = 1; i < n.getPiecenumber(); i++) {
+    if (n.getX(i) < mx) mx = n.getX(i);
+    if (n.getY(i) < my) my = n.getY(i);
+    if (n.getZ(i) < mz) mz = n.getZ(i);
+  }
+}
+
+/* the pieces of the node relative to the smallest coordinates, sorted */
+static void canonicalPieces(const disassemblerNode_c & n, const uint16_t * classes, std::vector<canonicalPiece> & pieces) {
+
+  int mx, my, mz;
+  minPosition(n, mx, my, mz);
+
+  pieces.resize(n.getPiecenumber());
+
+  for (unsigned int i = 0; i < n.getPiecenumber(); i++) {
+    pieces[i].cls = classes[i];
+    pieces[i].trans = n.is_piece_removed(i) ? (int16_t)0xFFFF : (int16_t)n.getTrans(i);
+    pieces[i].x = n.getX(i) - mx;
+    pieces[i].y = n.getY(i) - my;
+    pieces[i].z = n.getZ(i) - mz;
+  }
+
+  std::sort(pieces.begin(), pieces.end());
+}
+
+unsigned int disassemblerNode_c::canonicalHash(const uint16_t * classes) const
+{
+  int mx, my, mz;
+  minPosition(*this, mx, my, mz);
+
+  unsigned int h = 0x17fe3b3c;
+
+  // the values of the pieces are added up, so the order of the pieces doesn't matter,
+  // the bits are mixed before that so that the sum doesn't cancel out differences
+  for (unsigned int i = 0; i < piecenumber; i++) {
+    unsigned int p = classes[i];
+    p *= 1343;
+    p += (uint16_t)wideTrans(i);
+    p *= 923;
+    p += getX(i) - mx;
+    p *= 113;
+    p += getY(i) - my;
+    p *= 23;
+    p += getZ(i) - mz;
+
+    p ^= p >> 16;
+    p *= 0x85ebca6b;
+    p ^= p >> 13;
+
+    h += p;
+  }
+
+  if (h == 0) h = 1;
+
+  return h;
+}
+
+bool disassemblerNode_c::canonicalEquals(const disassemblerNode_c &b, const uint16_t * classes) const
+{
+  // most equal nodes have the pieces in the same places
+  if (*this == b) return true;
+
+  std::vector<canonicalPiece> pa, pb;
+
+  canonicalPieces(*this, classes, pa);
+  canonicalPieces(b, classes, pb);
+
+  for (unsigned int i = 0; i < piecenumber; i++)
+    if (pa[i] != pb[i])
+      return false;
+
+  return true;
+}
+
 bool disassemblerNode_c::is_separation() const {
   for (unsigned int i = 0; i < piecenumber; i++)
     if (is_piece_removed(i))
@@ -150,4 +450,3 @@ bool disassemblerNode_c::is_separation() const {
 
   return false;
 }
-
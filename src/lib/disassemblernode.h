@@ -26,8 +26,73 @@
 #include <stdlib.h>
 #include <stdint.h>
 
+#include <vector>
+
 class assembly_c;
 
+/**
+ * A memory pool for disassembler nodes.
+ *
+ * The disassembler creates and frees huge numbers of small nodes. The pool
+ * takes the memory for the nodes from big slabs and keeps freed blocks
+ * in free lists, one for each block size, to use them again for the next
+ * nodes. So after the first fronts of a search no more memory needs to be
+ * requested from the system.
+ *
+ * The slabs are returned all at once when the pool is destroyed, so all nodes
+ * taken from the pool must be freed before that.
+ *
+ * The pool is not thread safe, only one thread at a time must create or free
+ * nodes of one pool.
+ */
+class nodePool_c {
+
+  private:
+
+    /** the free list and the current slab of one block size */
+    struct freeList_c {
+      /** the first free block */
+      void * first;
+      /** the size of the blocks, including the header */
+      size_t blockSize;
+      /** the part of the current slab that has not been used, yet */
+      char * cur;
+      char * end;
+    };
+
+    /** the free lists, indexed by the block size in units of 8 bytes */
+    std::vector<freeList_c *> lists;
+
+    /** all slabs requested from the system */
+    std::vector<char *> slabs;
+
+  public:
+
+    nodePool_c(void) {}
+    ~nodePool_c(void);
+
+    /**
+     * Return a block of at least size bytes from the pool, or from the heap
+     * when pool is 0.
+     */
+    static void * allocate(nodePool_c * pool, size_t size);
+
+    /**
+     * Return a block received from allocate to the pool it was taken from.
+     * The block knows where it came from.
+     */
+    static void release(void * block);
+
+    /** the number of bytes a block of the given size really takes, including the header */
+    static size_t blockSize(size_t size);
+
+  private:
+
+    // no copying and assigning
+    nodePool_c(const nodePool_c&);
+    void operator=(const nodePool_c&);
+};
+
 /**
  * The node structure used by the disassembler.
  *
@@ -40,8 +105,21 @@ class assembly_c;
  *
  * The node is used by the disassembler to construct its search tree. As
  * the tree can grow pretty large with a lot of nodes, it is important to
- * keep the node small. There is some possible optimisation available
- * in this node. For example you could save just the direction, amount and
+ * keep the node small. So the positions of the pieces are stored directly
+ * behind the node in the same block of memory and nodes created by the
+ * movement analysis are taken from a nodePool_c.
+ *
+ * The positions are stored in one of 2 formats. The wide format stores 4
+ * 16 bit values for each piece: x, y, z and the transformation. Most nodes
+ * fit into the compact format, though: there the position of piece 0 is
+ * stored with 16 bit values, padded to 8 bytes, followed by 4 bytes for each
+ * piece, the position relative to piece 0 and the transformation. So the
+ * relative positions of a piece can be read as one aligned 32 bit word. Nodes created with a complete
+ * position choose the compact format, when the values fit. The nodes are
+ * created by the create functions only.
+ *
+ * There is some more possible optimisation available in this node. For
+ * example you could save just the direction, amount and
  * pieces involved the transition from the come-from node to this node.
  *
  * The redundant information could be calculated from the come-from node.
@@ -65,27 +143,6 @@ private:
    */
   disassemblerNode_c * comefrom;
 
-  /**
-   * Number of pieces this node is handling
-   */
-  unsigned int piecenumber;
-
-  /**
-   * The position and orientation of all involved pieces.
-   *
-   * For more memory performance I will try to limit the
-   * amount of memory required by allocating only one big
-   * chunk of memory with interleaved data
-   * at position x%4 == 0 is x, ==1 is y ==2 is z ==3 is trans
-   *
-   * a piece NOT inside the rest is signified by
-   * trans == 0xFF, the direction the pieces were move out
-   * should be obtained from dir below, when trans is 0xFF
-   * then the data fields also contain the direction, not the
-   * position of the piece
-   */
-  int16_t * dat;
-
   /**
    * A reference counter for automatic deletion of the node.
    * Contains the number of pointers that point to this node
@@ -132,23 +189,107 @@ private:
    */
   unsigned int waylength;
 
+  /**
+   * Number of pieces this node is handling
+   */
+  uint16_t piecenumber;
+
+  /**
+   * The format of the positions behind the node.
+   *
+   * In the wide format there are 4 values for each piece:
+   * at position x%4 == 0 is x, ==1 is y ==2 is z ==3 is trans
+   *
+   * a piece NOT inside the rest is signified by
+   * trans == 0xFFFF, the direction the pieces were move out
+   * should be obtained from dir below, when trans is 0xFFFF
+   * then the data fields also contain the direction, not the
+   * position of the piece
+   *
+   * In the compact format the x, y and z of piece 0 and a padding value come first followed by
+   * 4 bytes for each piece, the position relative to piece 0 and the
+   * transformation. A removed piece has transformation 0xFF.
+   */
+  bool compact;
+
+  /** the wide positions, or the position of piece 0 for compact nodes */
+  int16_t * wide(void) { return reinterpret_cast<int16_t *>(this+1); }
+  const int16_t * wide(void) const { return reinterpret_cast<const int16_t *>(this+1); }
+
+  /** the relative positions and transformations of compact nodes */
+  int8_t * rel(void) { return reinterpret_cast<int8_t *>(wide()+4); }
+  const int8_t * rel(void) const { return reinterpret_cast<const int8_t *>(wide()+4); }
+
+  /** position of piece i relative to piece 0 */
+  int relX(unsigned int i) const { return compact ? rel()[4*i+0] : wide()[4*i+0] - wide()[0]; }
+  int relY(unsigned int i) const { return compact ? rel()[4*i+1] : wide()[4*i+1] - wide()[1]; }
+  int relZ(unsigned int i) const { return compact ? rel()[4*i+2] : wide()[4*i+2] - wide()[2]; }
+
+  /** the transformation of piece i as stored in the wide format */
+  int16_t wideTrans(unsigned int i) const {
+    if (!compact) return wide()[4*i+3];
+    if (rel()[4*i+3] == -1) return (int16_t)0xFFFF;
+    return (uint8_t)rel()[4*i+3];
+  }
+
+  /** number of bytes required behind the node for the positions */
+  static size_t dataSize(unsigned int pn, bool compact) {
+    return compact ? 4*sizeof(int16_t) + 4*pn : 4*pn*sizeof(int16_t);
+  }
+
+  /** can the given positions (in the wide format) be stored in the compact format */
+  static bool fitsCompact(unsigned int pn, const int16_t * pos);
+
+  disassemblerNode_c(unsigned int pn, disassemblerNode_c * comf, int _dir, int _amount, int step, bool compact);
+  disassemblerNode_c(unsigned int pn);
+
+  /** the node and its positions are allocated in one block */
+  static void * operator new(size_t size, nodePool_c * pool, size_t data) {
+    return nodePool_c::allocate(pool, size + data);
+  }
+
+  /** used, when the constructor throws */
+  static void operator delete(void * p, nodePool_c *, size_t) {
+    nodePool_c::release(p);
+  }
+
 public:
 
+  static void operator delete(void * p) {
+    nodePool_c::release(p);
+  }
+
+  /** the memory a node with pn pieces takes at most, including its positions */
+  static size_t memory(unsigned int pn) {
+    return nodePool_c::blockSize(sizeof(disassemblerNode_c) + dataSize(pn, false));
+  }
+
   /**
    * Create a new node.
    *
    * Create a new node with the given number of pieces the given come-from pointer
    * and the defined values for direction, amount.
    * Stepsize is added to the waylength of the come-from pointer and the result will be
-   * saved in our waylength value
+   * saved in our waylength value.
+   *
+   * The positions are given in the wide format and the node will be stored
+   * compact when possible. The node is taken from the pool, or from the
+   * heap when pool is 0
+   */
+  static disassemblerNode_c * create(nodePool_c * pool, unsigned int pn, disassemblerNode_c * comf,
+      int _dir, int _amount, const int16_t * pos, int step = 1);
+
+  /**
+   * Create a new node like above but with the positions to be set
+   * with the set functions below, the node is taken from the heap
    */
-  disassemblerNode_c(unsigned int pn, disassemblerNode_c * comf, int _dir, int _amount, int step = 1);
+  static disassemblerNode_c * create(unsigned int pn, disassemblerNode_c * comf, int _dir, int _amount, int step = 1);
 
   /** creates a root node from an assembly */
-  disassemblerNode_c(const assembly_c * assm);
+  static disassemblerNode_c * create(const assembly_c * assm);
 
-  /** create a new root node with pn pieces */
-  disassemblerNode_c(unsigned int pn);
+  /** create a new root node with pn pieces, set the positions with the set functions below */
+  static disassemblerNode_c * create(unsigned int pn);
 
   ~disassemblerNode_c();
 
@@ -204,28 +345,44 @@ public:
    */
   bool operator == (const disassemblerNode_c &b) const;
 
+  /**
+   * Return a hash value that doesn't change when pieces exchange their places.
+   *
+   * classes contains one value for each piece, pieces with the same value must
+   * be identical. When 2 identical pieces with the same transformation exchange
+   * their positions the result is the same position of the puzzle, so those
+   * nodes get the same value. The value is not cached
+   */
+  unsigned int canonicalHash(const uint16_t * classes) const;
+
+  /**
+   * Compare like the operator above, but identical pieces with the same
+   * transformation may have exchanged their positions, see canonicalHash
+   */
+  bool canonicalEquals(const disassemblerNode_c &b, const uint16_t * classes) const;
+
   /** return x-position of piece i */
   int getX(unsigned int i) const {
     bt_assert(i < piecenumber);
-    return dat[4*i+0];
+    return compact ? wide()[0] + rel()[4*i+0] : wide()[4*i+0];
   }
 
   /** return y-position of piece i */
   int getY(unsigned int i) const {
     bt_assert(i < piecenumber);
-    return dat[4*i+1];
+    return compact ? wide()[1] + rel()[4*i+1] : wide()[4*i+1];
   }
 
   /** return z-position of piece i */
   int getZ(unsigned int i) const {
     bt_assert(i < piecenumber);
-    return dat[4*i+2];
+    return compact ? wide()[2] + rel()[4*i+2] : wide()[4*i+2];
   }
 
   /** return orientation of piece i */
   unsigned int getTrans(unsigned int i) const {
     bt_assert(i < piecenumber);
-    return (unsigned char)dat[4*i+3];
+    return compact ? (uint8_t)rel()[4*i+3] : (unsigned char)wide()[4*i+3];
   }
 
   /** return the number of pieces that are handled in this node */
@@ -237,12 +394,14 @@ public:
    * Setup piece i to be removed in this node.
    *
    * The x, y and z value define the direction in which the
-   * piece is removed
+   * piece is removed. Only for nodes created without positions
    */
   void setRemove(unsigned int i, int x, int y, int z) {
     bt_assert(i < piecenumber);
+    bt_assert(!compact);
     bt_assert(abs(x) < maxMove && abs(y) < maxMove && abs(z) < maxMove);
 
+    int16_t * dat = wide();
     dat[4*i+0] = x;
     dat[4*i+1] = y;
     dat[4*i+2] = z;
@@ -255,8 +414,10 @@ public:
    */
   void set(unsigned int i, int x, int y, int z, unsigned int tr) {
     bt_assert(i < piecenumber);
+    bt_assert(!compact);
     bt_assert(abs(x) < maxMove && abs(y) < maxMove && abs(z) < maxMove);
 
+    int16_t * dat = wide();
     dat[4*i+0] = x;
     dat[4*i+1] = y;
     dat[4*i+2] = z;
@@ -270,15 +431,17 @@ public:
   void set(unsigned int i, int tx, int ty, int tz)
   {
     bt_assert(i < piecenumber);
+    bt_assert(!compact);
     bt_assert(comefrom);
-    bt_assert(abs(comefrom->dat[4*i+0]+tx) < maxMove &&
-              abs(comefrom->dat[4*i+1]+ty) < maxMove &&
-              abs(comefrom->dat[4*i+2]+tz) < maxMove);
-
-    dat[4*i+0] = comefrom->dat[4*i+0]+tx;
-    dat[4*i+1] = comefrom->dat[4*i+1]+ty;
-    dat[4*i+2] = comefrom->dat[4*i+2]+tz;
-    dat[4*i+3] = comefrom->dat[4*i+3];
+    bt_assert(abs(comefrom->getX(i)+tx) < maxMove &&
+              abs(comefrom->getY(i)+ty) < maxMove &&
+              abs(comefrom->getZ(i)+tz) < maxMove);
+
+    int16_t * dat = wide();
+    dat[4*i+0] = comefrom->getX(i)+tx;
+    dat[4*i+1] = comefrom->getY(i)+ty;
+    dat[4*i+2] = comefrom->getZ(i)+tz;
+    dat[4*i+3] = comefrom->wideTrans(i);
     hashValue = 0;
   }
 
@@ -287,7 +450,7 @@ public:
    */
   bool is_piece_removed(unsigned int nr) const {
     bt_assert(nr < piecenumber);
-    return (dat[4*nr+3] == (int16_t)0xFFFF);
+    return compact ? (rel()[4*nr+3] == -1) : (wide()[4*nr+3] == (int16_t)0xFFFF);
   }
 
   /**
@@ -315,15 +478,6 @@ public:
     return waylength;
   }
 
-  /**
-   * Next-pointer for the hash-table lists.
-   *
-   * These node will be saved in disassembler-hash-tables. For
-   * those tables we need a next-pointer to save lists of nodes
-   * that go into the same hash-bucket
-   */
-  disassemblerNode_c * next;
-
 private:
 
   // no copying and assigning
@@ -0,0 +1,114 @@
+/* BurrTools
+ *
+ * BurrTools is the legal property of its developers, whose
+ * names are listed in the COPYRIGHT file, which is included
+ * within the source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+#include "disassemblernode.h"
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_CASE( disassemblernode_test )
+{
+  nodePool_c pool;
+
+  disassemblerNode_c * root = disassemblerNode_c::create(3);
+
+  root->set(0, 0, 0, 0, 0);
+  root->set(1, 2, 0, 0, 5);
+  root->set(2, 0, 3, 0, 7);
+
+  // small moves, stored compact
+  int16_t pos[12] = { 10, 0, 0, 0,   12, 0, 0, 5,   10, 3, 0, 7 };
+
+  disassemblerNode_c * a = disassemblerNode_c::create(&pool, 3, root, 0, 10, pos);
+
+  // the same state from the heap, stored wide, shifted around
+  disassemblerNode_c * b = disassemblerNode_c::create(3, root, 0, 10);
+
+  b->set(0, -5, 1, 1);
+  b->set(1, -5, 1, 1);
+  b->set(2, -5, 1, 1);
+
+  for (int i = 0; i < 3; i++) {
+    BOOST_CHECK_EQUAL( a->getX(i), pos[4*i+0] );
+    BOOST_CHECK_EQUAL( a->getY(i), pos[4*i+1] );
+    BOOST_CHECK_EQUAL( a->getZ(i), pos[4*i+2] );
+    BOOST_CHECK_EQUAL( a->getTrans(i), (unsigned int)pos[4*i+3] );
+    BOOST_CHECK_EQUAL( b->getTrans(i), root->getTrans(i) );
+  }
+
+  BOOST_CHECK( *a == *b );
+  BOOST_CHECK( *b == *a );
+  BOOST_CHECK_EQUAL( a->hash(), b->hash() );
+
+  // a far move and a removed piece, stored wide
+  int16_t far[12] = { 0, 0, 0, 0,   1000, 0, 0, 5,   0, -1, 0, (int16_t)0xFFFF };
+
+  disassemblerNode_c * c = disassemblerNode_c::create(&pool, 3, a, 1, 1, far);
+
+  BOOST_CHECK_EQUAL( c->getX(1), 1000 );
+  BOOST_CHECK( c->is_separation() );
+  BOOST_CHECK( c->is_piece_removed(2) );
+  BOOST_CHECK( !c->is_piece_removed(1) );
+  BOOST_CHECK_EQUAL( c->getY(2), -1 );
+  BOOST_CHECK( !(*c == *a) );
+
+  // a removed piece in a compact node
+  int16_t rem[12] = { 10, 0, 0, 0,   12, 0, 0, 5,   0, 0, 1, (int16_t)0xFFFF };
+
+  disassemblerNode_c * d = disassemblerNode_c::create(&pool, 3, a, 1, 1, rem);
+
+  BOOST_CHECK( d->is_piece_removed(2) );
+  BOOST_CHECK_EQUAL( d->getZ(2), 1 );
+  BOOST_CHECK_EQUAL( d->getTrans(2), 0xFFu );
+
+  // replacing a compact node with the wide node of the same state keeps the state
+  a->replaceNode(b);
+  BOOST_CHECK( *a == *b );
+  BOOST_CHECK_EQUAL( a->getX(0), b->getX(0) );
+  BOOST_CHECK_EQUAL( a->getX(1), b->getX(1) );
+
+  // pieces 1 and 2 are identical, exchanging them gives the same position
+  const uint16_t classes[3] = { 0, 1, 1 };
+
+  int16_t one[12] = { 0, 0, 0, 0,   2, 0, 0, 3,   5, 0, 0, 3 };
+  int16_t two[12] = { 7, 1, 0, 0,   12, 1, 0, 3,   9, 1, 0, 3 };
+  int16_t oth[12] = { 2, 0, 0, 0,   0, 0, 0, 3,   5, 0, 0, 3 };
+
+  disassemblerNode_c * e = disassemblerNode_c::create(&pool, 3, root, 0, 1, one);
+  disassemblerNode_c * f = disassemblerNode_c::create(&pool, 3, root, 0, 1, two);
+  disassemblerNode_c * g = disassemblerNode_c::create(&pool, 3, root, 0, 1, oth);
+
+  BOOST_CHECK( !(*e == *f) );
+  BOOST_CHECK( e->canonicalEquals(*f, classes) );
+  BOOST_CHECK( f->canonicalEquals(*e, classes) );
+  BOOST_CHECK_EQUAL( e->canonicalHash(classes), f->canonicalHash(classes) );
+  BOOST_CHECK( e->canonicalEquals(*e, classes) );
+
+  // piece 0 is different from the others
+  BOOST_CHECK( !e->canonicalEquals(*g, classes) );
+
+  if (e->decRefCount()) delete e;
+  if (f->decRefCount()) delete f;
+  if (g->decRefCount()) delete g;
+  if (d->decRefCount()) delete d;
+  if (c->decRefCount()) delete c;
+  if (a->decRefCount()) delete a;
+  if (b->decRefCount()) delete b;
+  BOOST_CHECK( root->decRefCount() );
+  delete root;
+}
@@ -0,0 +1,90 @@
+/* BurrTools
+ *
+ * BurrTools is the legal property of its developers, whose
+ * names are listed in the COPYRIGHT file, which is included
+ * within the source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+#include "disassemblerstats.h"
+
+#include <sys/time.h>
+
+void disassemblerStats_c::reset(void) {
+
+  analyses = time = 0;
+
+  levelNodes.clear();
+  maxFront = maxStored = 0;
+
+  hashInserts = hashProbes = hashMaxProbe = 0;
+  hashEntries = hashSlots = 0;
+
+  cacheLookups = cacheMisses = cacheTime = 0;
+
+  closures = closuresKept = 0;
+}
+
+void disassemblerStats_c::add(const disassemblerStats_c & s) {
+
+  analyses += s.analyses;
+  time += s.time;
+
+  if (s.levelNodes.size() > levelNodes.size())
+    levelNodes.resize(s.levelNodes.size(), 0);
+
+  for (unsigned int i = 0; i < s.levelNodes.size(); i++)
+    levelNodes[i] += s.levelNodes[i];
+
+  if (s.maxFront > maxFront) maxFront = s.maxFront;
+  if (s.maxStored > maxStored) maxStored = s.maxStored;
+
+  hashInserts += s.hashInserts;
+  hashProbes += s.hashProbes;
+  if (s.hashMaxProbe > hashMaxProbe) hashMaxProbe = s.hashMaxProbe;
+  hashEntries += s.hashEntries;
+  hashSlots += s.hashSlots;
+
+  cacheLookups += s.cacheLookups;
+  cacheMisses += s.cacheMisses;
+  cacheTime += s.cacheTime;
+
+  closures += s.closures;
+  closuresKept += s.closuresKept;
+}
+
+uint64_t disassemblerStats_c::nodes(void) const {
+
+  uint64_t n = 0;
+
+  for (unsigned int i = 0; i < levelNodes.size(); i++)
+    n += levelNodes[i];
+
+  return n;
+}
+
+double disassemblerStats_c::cacheHitRate(void) const {
+  return cacheLookups ? (double)(cacheLookups - cacheMisses) / cacheLookups : 0;
+}
+
+double disassemblerStats_c::hashLoad(void) const {
+  return hashSlots ? (double)hashEntries / hashSlots : 0;
+}
+
+uint64_t disassemblerStats_c::now(void) {
+  struct timeval tv;
+  gettimeofday(&tv, 0);
+  return (uint64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+}
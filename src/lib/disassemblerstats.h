@@ -0,0 +1,98 @@
+/* BurrTools
+ *
+ * BurrTools is the legal property of its developers, whose
+ * names are listed in the COPYRIGHT file, which is included
+ * within the source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+#ifndef __DISASSEMBLERSTATS_H__
+#define __DISASSEMBLERSTATS_H__
+
+#include <stdint.h>
+
+#include <vector>
+
+/**
+ * Counters that show where a disassembler spends its time.
+ *
+ * The disassemblers collect these for each call, the counters of several calls
+ * can be added up to get the numbers for a whole solve. Collecting is not
+ * thread safe, each thread counts into its own object and the objects are
+ * added together once the threads are finished.
+ */
+class disassemblerStats_c {
+
+  public:
+
+    uint64_t analyses;        ///< number of assemblies analysed
+    uint64_t time;            ///< microseconds spent in the analyses
+
+    /**
+     * nodes expanded on each level of the searches, level 0 contains the start
+     * nodes. The searches for the sub problems are added to the same levels
+     */
+    std::vector<uint64_t> levelNodes;
+    uint64_t maxFront;        ///< the most nodes waiting to be expanded in one level
+    uint64_t maxStored;       ///< the most nodes kept in the hash tables at one time
+
+    uint64_t hashInserts;     ///< nodes inserted into the hash tables, including the ones already there
+    uint64_t hashProbes;      ///< entries looked at by the insertions
+    uint64_t hashMaxProbe;    ///< the most entries looked at by one insertion
+    uint64_t hashEntries;     ///< nodes in the hash tables when they were emptied
+    uint64_t hashSlots;       ///< size of the hash tables when they were emptied
+
+    uint64_t cacheLookups;    ///< values asked from the movement cache
+    uint64_t cacheMisses;     ///< values the movement cache had to calculate
+    uint64_t cacheTime;       ///< microseconds spent calculating the values
+
+    uint64_t closures;        ///< closures of the movement matrices calculated
+    uint64_t closuresKept;    ///< closures that could be kept from the node before
+
+    disassemblerStats_c(void) { reset(); }
+
+    /** set all counters to 0 */
+    void reset(void);
+
+    /** add the counters of s, the maxima are the maxima of both */
+    void add(const disassemblerStats_c & s);
+
+    /** add count expanded nodes on the given level */
+    void addNodes(unsigned int level, uint64_t count) {
+      if (level >= levelNodes.size())
+        levelNodes.resize(level+1, 0);
+      levelNodes[level] += count;
+    }
+
+    /** a level with front nodes to expand was started while stored nodes are kept */
+    void addFront(uint64_t front, uint64_t stored) {
+      if (front > maxFront) maxFront = front;
+      if (stored > maxStored) maxStored = stored;
+    }
+
+    /** the total number of expanded nodes */
+    uint64_t nodes(void) const;
+
+    /** the part of the movement cache lookups that didn't need a calculation */
+    double cacheHitRate(void) const;
+
+    /** average number of nodes per entry of the hash tables when they were emptied */
+    double hashLoad(void) const;
+
+    /** current time in microseconds, for the time counters */
+    static uint64_t now(void);
+};
+
+#endif
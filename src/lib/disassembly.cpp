@@ -150,103 +150,54 @@ state_c::state_c(xmlParser_c & pars, unsigned int pn)
 {
   pars.require(xmlParser_c::START_TAG, "state");
 
-#ifndef NDEBUG
-  piecenumber = pn;
-#endif
+  bool gotX = false, gotY = false, gotZ = false;
 
-  dx = dy = dz = 0;
+  dx.resize(pn);
+  dy.resize(pn);
+  dz.resize(pn);
 
-  try
+  do
   {
-    do
-    {
-      int state = pars.nextTag();
-
-      if (state == xmlParser_c::END_TAG) break;
-      if (state != xmlParser_c::START_TAG)
-        pars.exception("expected new tag but dounf something else");
+    int state = pars.nextTag();
 
-      if (pars.getName() == "dx")
-      {
-        dx = new int[pn];
-        pars.next();
-        getNumbers(pars.getText(), dx, dx+pn, true);
-        pars.next();
-        pars.require(xmlParser_c::END_TAG, "dx");
-      }
-      else if (pars.getName() == "dy")
-      {
-        dy = new int[pn];
-        pars.next();
-        getNumbers(pars.getText(), dy, dy+pn, true);
-        pars.next();
-        pars.require(xmlParser_c::END_TAG, "dy");
-      }
-      else if (pars.getName() == "dz")
-      {
-        dz = new int[pn];
-        pars.next();
-        getNumbers(pars.getText(), dz, dz+pn, true);
-        pars.next();
-        pars.require(xmlParser_c::END_TAG, "dz");
-      }
-    } while (true);
+    if (state == xmlParser_c::END_TAG) break;
+    if (state != xmlParser_c::START_TAG)
+      pars.exception("expected new tag but dounf something else");
 
-    if (!dx || !dy || !dz)
-      pars.exception("disassembly state needs dx, dy and dz subnode");
-  }
+    if (pars.getName() == "dx")
+    {
+      pars.next();
+      getNumbers(pars.getText(), dx.begin(), dx.end(), true);
+      pars.next();
+      pars.require(xmlParser_c::END_TAG, "dx");
+      gotX = true;
+    }
+    else if (pars.getName() == "dy")
+    {
+      pars.next();
+      getNumbers(pars.getText(), dy.begin(), dy.end(), true);
+      pars.next();
+      pars.require(xmlParser_c::END_TAG, "dy");
+      gotY = true;
+    }
+    else if (pars.getName() == "dz")
+    {
+      pars.next();
+      getNumbers(pars.getText(), dz.begin(), dz.end(), true);
+      pars.next();
+      pars.require(xmlParser_c::END_TAG, "dz");
+      gotZ = true;
+    }
+  } while (true);
 
-  catch (xmlParserException_c & e)
-  {
-    if (dx) delete [] dx;
-    if (dy) delete [] dy;
-    if (dz) delete [] dz;
-    pars.exception(e.what());
-  }
+  if (!gotX || !gotY || !gotZ)
+    pars.exception("disassembly state needs dx, dy and dz subnode");
 
   pars.require(xmlParser_c::END_TAG, "state");
 }
 
-state_c::state_c(const state_c * cpy, unsigned int pn)
-#ifndef NDEBUG
-: piecenumber(pn)
-#endif
-{
-  dx = new int[pn];
-  dy = new int[pn];
-  dz = new int[pn];
-
-  memcpy(dx, cpy->dx, pn*sizeof(int));
-  memcpy(dy, cpy->dy, pn*sizeof(int));
-  memcpy(dz, cpy->dz, pn*sizeof(int));
-}
-
-state_c::state_c(unsigned int pn)
-#ifndef NDEBUG
-: piecenumber(pn)
-#endif
-{
-  dx = new int[pn];
-  dy = new int[pn];
-  dz = new int[pn];
-  bt_assert(dx && dy && dz);
-}
-
-state_c::~state_c() {
-  delete [] dx;
-  delete [] dy;
-  delete [] dz;
-}
-
-void state_c::set(unsigned int piece, int x, int y, int z) {
-  bt_assert(piece < piecenumber);
-  dx[piece] = x;
-  dy[piece] = y;
-  dz[piece] = z;
-}
-
 bool state_c::pieceRemoved(unsigned int i) const {
-  bt_assert(i < piecenumber);
+  bt_assert(i < dx.size());
   return (abs(dx[i]) > 10000) || (abs(dy[i]) > 10000) || (abs(dz[i]) > 10000);
 }
 
@@ -271,6 +222,69 @@ int disassembly_c::compare(const disassembly_c * s2) const
  * Separation
  ************************************************************************/
 
+/* every keyStateInterval-th state contains all piece positions */
+static const unsigned int keyStateInterval = 16;
+
+/* marker for values that don't fit into one int16, the value follows
+ * in the next 2 entries
+ */
+static const int16_t escapeValue = -32768;
+
+static void putValue(std::vector<int16_t> & data, int v) {
+  if ((v > escapeValue) && (v <= 32767))
+    data.push_back(v);
+  else {
+    data.push_back(escapeValue);
+    data.push_back((int16_t)((uint32_t)v >> 16));
+    data.push_back((int16_t)((uint32_t)v & 0xFFFF));
+  }
+}
+
+static int getValue(const int16_t *& p) {
+  int v = *p++;
+  if (v == escapeValue) {
+    v = (int)(((uint32_t)(uint16_t)p[0] << 16) | (uint16_t)p[1]);
+    p += 2;
+  }
+  return v;
+}
+
+state_c separation_c::getState(unsigned int num) const {
+
+  bt_assert(num < stateStart.size());
+
+  unsigned int pn = pieces.size();
+  state_c st(pn);
+
+  /* start with the key state before the requested state... */
+  unsigned int key = num - num % keyStateInterval;
+  const int16_t * p = &stateData[0] + stateStart[key];
+
+  for (unsigned int i = 0; i < pn; i++) {
+    int x = getValue(p);
+    int y = getValue(p);
+    int z = getValue(p);
+    st.set(i, x, y, z);
+  }
+
+  /* ... and apply the differences up to the requested state */
+  for (unsigned int s = key+1; s <= num; s++) {
+
+    p = &stateData[0] + stateStart[s];
+    const int16_t * end = &stateData[0] + ((s+1 < stateStart.size()) ? stateStart[s+1] : stateData.size());
+
+    while (p < end) {
+      unsigned int i = (uint16_t)*p++;
+      int x = getValue(p);
+      int y = getValue(p);
+      int z = getValue(p);
+      st.set(i, st.getX(i) + x, st.getY(i) + y, st.getZ(i) + z);
+    }
+  }
+
+  return st;
+}
+
 void separation_c::save(xmlWriter_c & xml, int type) const
 {
   xml.newTag("separation");
@@ -295,8 +309,8 @@ void separation_c::save(xmlWriter_c & xml, int type) const
   xml.endTag("pieces");
 
   // now add all the states
-  for (unsigned int jj = 0; jj < states.size(); jj++)
-    states[jj]->save(xml, pieces.size());
+  for (unsigned int jj = 0; jj < stateStart.size(); jj++)
+    getState(jj).save(xml, pieces.size());
 
   // finally save the removed and left over part
   // we add an attribute to the node of the subseparations to later distinguish
@@ -352,14 +366,19 @@ separation_c::separation_c(xmlParser_c & pars, unsigned int pieceCnt)
         pars.exception("there are states behind the sub separations");
 
       // get the states
-      states.push_back(new state_c(pars, piecenumber));
+      addstate(state_c(pars, piecenumber));
     }
     else if (pars.getName() == "separation")
     {
       if (removedPc == 0)
       {
+        if (stateStart.size() == 0)
+          pars.exception("there must be states before the sub separations");
+
+        state_c last = getState(getMoves());
+
         for (unsigned int i = 0; i < pieceCnt; i++)
-          if (states[states.size()-1]->pieceRemoved(i))
+          if (last.pieceRemoved(i))
             removedPc++;
           else
             leftPc++;
@@ -394,7 +413,7 @@ separation_c::separation_c(xmlParser_c & pars, unsigned int pieceCnt)
 
   } while(true);
 
-  if (states.size() == 0)
+  if (stateStart.size() == 0)
     pars.exception("there are no state nodes in the separation");
 
   pars.require(xmlParser_c::END_TAG, "separation");
@@ -411,13 +430,11 @@ separation_c::separation_c(separation_c * r, separation_c * l, const std::vector
 separation_c::~separation_c() {
   delete removed;
   delete left;
-  for (unsigned int i = 0; i < states.size(); i++)
-    delete states[i];
 }
 
 unsigned int separation_c::sumMoves(void) const {
-  bt_assert(states.size());
-  unsigned int erg = states.size() - 1;
+  bt_assert(stateStart.size());
+  unsigned int erg = stateStart.size() - 1;
   if (removed)
     erg += removed->sumMoves();
   if (left)
@@ -426,17 +443,40 @@ unsigned int separation_c::sumMoves(void) const {
   return erg;
 }
 
-void separation_c::addstate(state_c *st) {
-  bt_assert(st->getPiecenumber() == pieces.size());
-  states.push_front(st);
+void separation_c::addstate(const state_c & st) {
+  bt_assert(st.getPiecenumber() == pieces.size());
+  bt_assert(pieces.size() <= 0xFFFF);
+
+  unsigned int num = stateStart.size();
+  stateStart.push_back(stateData.size());
+
+  if (num % keyStateInterval == 0) {
+
+    for (unsigned int i = 0; i < pieces.size(); i++) {
+      putValue(stateData, st.getX(i));
+      putValue(stateData, st.getY(i));
+      putValue(stateData, st.getZ(i));
+    }
+
+  } else {
+
+    state_c prev = getState(num-1);
+
+    for (unsigned int i = 0; i < pieces.size(); i++)
+      if ((st.getX(i) != prev.getX(i)) || (st.getY(i) != prev.getY(i)) || (st.getZ(i) != prev.getZ(i))) {
+        stateData.push_back((int16_t)i);
+        putValue(stateData, st.getX(i) - prev.getX(i));
+        putValue(stateData, st.getY(i) - prev.getY(i));
+        putValue(stateData, st.getZ(i) - prev.getZ(i));
+      }
+  }
 }
 
 separation_c::separation_c(const separation_c * cpy) {
 
   pieces = cpy->pieces;
-
-  for (unsigned int i = 0; i < cpy->states.size(); i++)
-    states.push_back(new state_c(cpy->states[i], pieces.size()));
+  stateData = cpy->stateData;
+  stateStart = cpy->stateStart;
 
   if (cpy->left)
     left = new separation_c(cpy->left);
@@ -453,16 +493,16 @@ separation_c::separation_c(const separation_c * cpy) {
 
 
 bool separation_c::containsMultiMoves(void) {
-  return (states.size() > 2) ||
+  return (stateStart.size() > 2) ||
     (left && left->containsMultiMoves()) ||
     (removed && removed->containsMultiMoves());
 }
 
 int separation_c::movesText2(char * txt, int len) const {
 
-  bt_assert(states.size() > 0);
+  bt_assert(stateStart.size() > 0);
 
-  int len2 = snprintf(txt, len, "%zu", states.size()-1);
+  int len2 = snprintf(txt, len, "%zu", stateStart.size()-1);
 
   if (len2+5 > len)
     return len2;
@@ -501,7 +541,7 @@ void separation_c::exchangeShape(unsigned int s1, unsigned int s2) {
 unsigned int separation_c::getSequenceLength(unsigned int x) const
 {
   if (x == 0)
-    return states.size();
+    return stateStart.size();
 
   x--;
 
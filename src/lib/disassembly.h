@@ -27,9 +27,10 @@
 
 #include "bt_assert.h"
 
-#include <deque>
 #include <vector>
 
+#include <stdint.h>
+
 class xmlWriter_c;
 class xmlParser_c;
 
@@ -90,20 +91,18 @@ class disassembly_c
 /**
  * defines one step in the separation process.
  * one state of relative piece positions on your way
+ *
+ * states are not kept like this inside the separations, they are
+ * only used to hand over single states, see separation_c
  */
 class state_c {
 
   /** contains the x positions of all the pieces that are handled */
-  int *dx;
+  std::vector<int> dx;
   /** contains the y positions of all the pieces that are handled */
-  int *dy;
+  std::vector<int> dy;
   /** contains the z positions of all the pieces that are handled */
-  int *dz;
-
-#ifndef NDEBUG
-  /** we only keep the piecenumber for checking purposes */
-  unsigned int piecenumber;
-#endif
+  std::vector<int> dz;
 
 public:
 
@@ -111,51 +110,43 @@ public:
    * create a new spate for pn pieces. you can not add more
    * pieces later on, so plan ahead
    */
-  state_c(unsigned int pn);
-
-  /** copy constructor */
-  state_c(const state_c * cpy, unsigned int pn);
+  state_c(unsigned int pn) : dx(pn), dy(pn), dz(pn) {}
 
   /** load from an xml node */
   state_c(xmlParser_c & pars, unsigned int pn);
 
-  ~state_c();
-
   /** save into an xml node */
   void save(xmlWriter_c & xml, unsigned int piecenumber) const;
 
   /** set the position of a piece */
-  void set(unsigned int piece, int x, int y, int z);
+  void set(unsigned int piece, int x, int y, int z) {
+    bt_assert(piece < dx.size());
+    dx[piece] = x;
+    dy[piece] = y;
+    dz[piece] = z;
+  }
 
   /** get the x position of a piece */
   int getX(unsigned int i) const {
-    bt_assert(i < piecenumber);
+    bt_assert(i < dx.size());
     return dx[i];
   }
   /** get the y position of a piece */
   int getY(unsigned int i) const {
-    bt_assert(i < piecenumber);
+    bt_assert(i < dy.size());
     return dy[i];
   }
   /** get the z position of a piece */
   int getZ(unsigned int i) const {
-    bt_assert(i < piecenumber);
+    bt_assert(i < dz.size());
     return dz[i];
   }
 
   /** check, if the piece is removed in this state */
   bool pieceRemoved(unsigned int i) const;
 
-#ifndef NDEBUG
-  /** on assert needs to check the piecenumber */
-  unsigned int getPiecenumber(void) const { return piecenumber; }
-#endif
-
-private:
-
-  // no copying and assigning
-  state_c(const state_c&);
-  void operator=(const state_c&);
+  /** the number of pieces in this state */
+  unsigned int getPiecenumber(void) const { return dx.size(); }
 };
 
 
@@ -177,7 +168,7 @@ class separation_c : public disassembly_c
   std::vector<unsigned int> pieces;
 
   /**
-   * vector with all the states that finally lead to 2 separate
+   * all the states that finally lead to 2 separate
    * subpuzzles. one state represents the  position of
    * all the pieces inside this subpuzzle relative to their
    * position in the completely assembled puzzle
@@ -188,8 +179,19 @@ class separation_c : public disassembly_c
    * the first state is the beginning state, for this partition, e.g
    * for the root node the first state represents the assembles puzzle
    * with all values 0
+   *
+   * as there are lots of solutions with lots of states kept in memory
+   * the states are stored compactly: every 16th state (starting with
+   * the first) is a key state that contains the positions of all pieces,
+   * all other states only contain the pieces that moved relative to the
+   * previous state as piece number and the 3 position differences.
+   * All values are int16, values that don't fit are escaped into 3
+   * entries
    */
-  std::deque <state_c *> states;
+  std::vector<int16_t> stateData;
+
+  /** where in stateData each state starts */
+  std::vector<uint32_t> stateStart;
 
   /* the 2 parts the puzzle gets divided with the
    * last move. If one of this parts consists of only
@@ -231,13 +233,14 @@ public:
    * return the number of moves that are required to separate the puzzle.
    * this number is one smaller than the number of states
    */
-  unsigned int getMoves(void) const { return states.size() - 1; }
+  unsigned int getMoves(void) const { return stateStart.size() - 1; }
 
-  /** get one state from the separation process */
-  const state_c * getState(unsigned int num) const {
-    bt_assert(num < states.size());
-    return states[num];
-  }
+  /**
+   * get one state from the separation process. The state is
+   * decoded from the compact storage, so when you need it more than
+   * once, keep a copy
+   */
+  state_c getState(unsigned int num) const;
 
   /** get the separation for the pieces that were removed */
   const separation_c * getLeft(void) const { return left; }
@@ -246,14 +249,11 @@ public:
   const separation_c * getRemoved(void) const { return removed; }
 
   /**
-   * add a new state to the FRONT of the current state list.
-   * this is necessary because the list is generated when back
-   * tracking from the graph search, so we visit the states in
-   * the wrong order
+   * add a new state to the end of the current state list.
    * keep in mind that the new state must have the same number
    * of pieces as all the other states
    */
-  void addstate(state_c *st);
+  void addstate(const state_c & st);
 
   /** return the number of pieces that are in this separation */
   unsigned int getPieceNumber(void) const { return pieces.size(); }
@@ -0,0 +1,77 @@
+/* BurrTools
+ *
+ * BurrTools is the legal property of its developers, whose
+ * names are listed in the COPYRIGHT file, which is included
+ * within the source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+#include "disassembly.h"
+#include <boost/test/unit_test.hpp>
+
+#include <stdlib.h>
+
+/* states are stored as differences to the previous state with key states in between
+ * and escapes for big values, all the states must come back out as they went in
+ */
+BOOST_AUTO_TEST_CASE( separation_states_test )
+{
+  const unsigned int pn = 5;
+
+  std::vector<unsigned int> pcs;
+  for (unsigned int i = 0; i < pn; i++)
+    pcs.push_back(i);
+
+  separation_c sep(0, 0, pcs);
+
+  srand(1);
+
+  std::vector<std::vector<int> > pos;
+  std::vector<int> cur(3*pn, 0);
+
+  for (unsigned int s = 0; s < 100; s++) {
+
+    /* move a random piece, sometimes a very long way */
+    unsigned int p = rand() % pn;
+    int amount = (rand() % 10 == 0) ? 40000 + rand() % 100000 : (rand() % 7) - 3;
+    cur[3*p + rand() % 3] += amount;
+
+    state_c st(pn);
+    for (unsigned int i = 0; i < pn; i++)
+      st.set(i, cur[3*i], cur[3*i+1], cur[3*i+2]);
+
+    sep.addstate(st);
+    pos.push_back(cur);
+  }
+
+  BOOST_CHECK( sep.getMoves() == 99 );
+
+  separation_c cpy(&sep);
+
+  for (unsigned int s = 0; s < pos.size(); s++) {
+
+    state_c st = sep.getState(s);
+    state_c st2 = cpy.getState(s);
+
+    for (unsigned int i = 0; i < pn; i++) {
+      BOOST_CHECK( st.getX(i) == pos[s][3*i] );
+      BOOST_CHECK( st.getY(i) == pos[s][3*i+1] );
+      BOOST_CHECK( st.getZ(i) == pos[s][3*i+2] );
+      BOOST_CHECK( st2.getX(i) == pos[s][3*i] );
+      BOOST_CHECK( st2.getY(i) == pos[s][3*i+1] );
+      BOOST_CHECK( st2.getZ(i) == pos[s][3*i+2] );
+    }
+  }
+}
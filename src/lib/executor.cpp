@@ -0,0 +1,350 @@
+/* BurrTools
+ *
+ * BurrTools is the legal property of its developers, whose
+ * names are listed in the COPYRIGHT file, which is included
+ * within the source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+#include "executor.h"
+
+#include "thread.h"
+#include "bt_assert.h"
+
+static unsigned int requestedSize = 0;
+static executor_c * pool = 0;
+
+void task_c::execute(void) {
+
+  failed = false;
+
+  if (cancelled())
+    return;
+
+  /* an exception must not leave the worker thread or the stack of a task
+   * that runs this one while it waits, so it is kept for the owner of the task
+   */
+  try {
+    run();
+  }
+
+  catch (assert_exception & a) {
+    ae = a;
+    failed = true;
+  }
+
+  catch (...) {
+    ae = assert_exception("task_c::run threw an exception", __FILE__, __LINE__, __PRETTY_FUNCTION__);
+    failed = true;
+  }
+}
+
+void task_c::rethrow(void) {
+
+  if (failed) {
+    failed = false;
+    throw ae;
+  }
+}
+
+#ifdef NO_THREADING
+
+/* without threads everything is done right away in the calling thread */
+
+class executorImpl_c { };
+
+executor_c::executor_c(unsigned int /*threads*/) : impl(0) { }
+executor_c::~executor_c(void) { }
+
+executor_c & executor_c::instance(void) {
+
+  if (!pool)
+    pool = new executor_c(1);
+
+  return *pool;
+}
+
+unsigned int executor_c::size(void) const { return 1; }
+
+void executor_c::submit(task_c * t) {
+
+  bt_assert(t->state == task_c::TS_IDLE);
+
+  t->state = task_c::TS_RUNNING;
+  t->execute();
+  t->state = task_c::TS_IDLE;
+}
+
+void executor_c::wait(task_c * t) {
+  bt_assert(t->state == task_c::TS_IDLE);
+  t->rethrow();
+}
+
+bool executor_c::inWorker(void) const { return false; }
+
+#else
+
+#include <boost/thread.hpp>
+
+#include <deque>
+
+class executorImpl_c {
+
+  public:
+
+    /** the deque of one worker, the owner works at the back, thieves at the front */
+    struct worker {
+      boost::mutex lock;
+      std::deque<task_c *> tasks;
+    };
+
+    std::vector<worker *> workers;
+    std::vector<boost::thread *> threads;
+
+    /** protects the shared queue, the queued counter and the task states */
+    boost::mutex lock;
+
+    /** signalled whenever a task is queued or a task has finished */
+    boost::condition_variable changed;
+
+    /** the tasks submitted from outside of the pool */
+    std::deque<task_c *> shared;
+
+    /** number of tasks waiting in all the queues */
+    unsigned long queued;
+
+    bool shutdown;
+
+    /** the index of the worker for the worker threads, not set for other threads */
+    boost::thread_specific_ptr<unsigned int> self;
+
+    executorImpl_c(unsigned int size);
+    ~executorImpl_c(void);
+
+    /** index of the calling worker or -1 */
+    int me(void) {
+      unsigned int * s = self.get();
+      return s ? (int)*s : -1;
+    }
+
+    /**
+     * find a task to run: own deque, shared queue, other deques. Workers
+     * that wait for a task only help with tasks from the deques, the shared queue
+     * contains the big jobs that would block the waiting worker for too long
+     */
+    task_c * take(int w, bool shared);
+
+    void execute(task_c * t);
+
+    void workerLoop(unsigned int w);
+};
+
+executorImpl_c::executorImpl_c(unsigned int size) : queued(0), shutdown(false) {
+
+  for (unsigned int i = 0; i < size; i++)
+    workers.push_back(new worker);
+
+  for (unsigned int i = 0; i < size; i++)
+    threads.push_back(new boost::thread(&executorImpl_c::workerLoop, this, i));
+}
+
+executorImpl_c::~executorImpl_c(void) {
+
+  {
+    boost::mutex::scoped_lock l(lock);
+    shutdown = true;
+  }
+  changed.notify_all();
+
+  for (unsigned int i = 0; i < threads.size(); i++) {
+    threads[i]->join();
+    delete threads[i];
+    delete workers[i];
+  }
+}
+
+task_c * executorImpl_c::take(int w, bool useShared) {
+
+  task_c * t = 0;
+
+  if (w >= 0) {
+    boost::mutex::scoped_lock l(workers[w]->lock);
+    if (!workers[w]->tasks.empty()) {
+      t = workers[w]->tasks.back();
+      workers[w]->tasks.pop_back();
+    }
+  }
+
+  if (!t && useShared) {
+    boost::mutex::scoped_lock l(lock);
+    if (!shared.empty()) {
+      t = shared.front();
+      shared.pop_front();
+      queued--;
+      return t;
+    }
+  }
+
+  for (unsigned int i = 1; !t && i <= workers.size(); i++) {
+
+    // start stealing with the neighbour, so that not all thieves go to the same deque
+    unsigned int v = (w + i) % workers.size();
+
+    boost::mutex::scoped_lock l(workers[v]->lock);
+    if (!workers[v]->tasks.empty()) {
+      t = workers[v]->tasks.front();
+      workers[v]->tasks.pop_front();
+    }
+  }
+
+  if (t) {
+    boost::mutex::scoped_lock l(lock);
+    queued--;
+  }
+
+  return t;
+}
+
+void executorImpl_c::execute(task_c * t) {
+
+  t->state = task_c::TS_RUNNING;
+
+  t->execute();
+
+  {
+    boost::mutex::scoped_lock l(lock);
+    t->state = task_c::TS_IDLE;
+  }
+  changed.notify_all();
+}
+
+void executorImpl_c::workerLoop(unsigned int w) {
+
+  self.reset(new unsigned int(w));
+
+  while (true) {
+
+    task_c * t = take(w, true);
+
+    if (t) {
+      execute(t);
+      continue;
+    }
+
+    boost::mutex::scoped_lock l(lock);
+
+    if (shutdown)
+      break;
+
+    if (queued == 0)
+      changed.wait(l);
+  }
+}
+
+executor_c::executor_c(unsigned int threads) : impl(new executorImpl_c(threads)) { }
+
+executor_c::~executor_c(void) {
+  delete impl;
+}
+
+void executor_c::createPool(void) {
+  pool = new executor_c(requestedSize ? requestedSize : thread_c::hardwareThreads());
+}
+
+executor_c & executor_c::instance(void) {
+
+  static boost::once_flag once = BOOST_ONCE_INIT;
+  boost::call_once(&executor_c::createPool, once);
+
+  return *pool;
+}
+
+unsigned int executor_c::size(void) const {
+  return impl->workers.size();
+}
+
+void executor_c::submit(task_c * t) {
+
+  bt_assert(t->state == task_c::TS_IDLE);
+  t->state = task_c::TS_QUEUED;
+
+  int w = impl->me();
+
+  // count the task before it becomes visible, a thief may take it from the
+  // deque at once and decrements the counter then
+  {
+    boost::mutex::scoped_lock l(impl->lock);
+    impl->queued++;
+    if (w < 0)
+      impl->shared.push_back(t);
+  }
+
+  if (w >= 0) {
+    boost::mutex::scoped_lock l(impl->workers[w]->lock);
+    impl->workers[w]->tasks.push_back(t);
+  }
+
+  impl->changed.notify_all();
+}
+
+void executor_c::wait(task_c * t) {
+
+  int w = impl->me();
+
+  if (w < 0) {
+
+    boost::mutex::scoped_lock l(impl->lock);
+    while (t->state != task_c::TS_IDLE)
+      impl->changed.wait(l);
+
+    l.unlock();
+    t->rethrow();
+
+    return;
+  }
+
+  // a worker helps with the other tasks while waiting, otherwise the
+  // pool could end up with all workers waiting for queued tasks
+  while (t->state != task_c::TS_IDLE) {
+
+    task_c * o = impl->take(w, false);
+
+    if (o) {
+      impl->execute(o);
+      continue;
+    }
+
+    boost::mutex::scoped_lock l(impl->lock);
+    if (t->state != task_c::TS_IDLE && impl->queued == impl->shared.size())
+      impl->changed.wait(l);
+  }
+
+  t->rethrow();
+}
+
+bool executor_c::inWorker(void) const {
+  return impl->me() >= 0;
+}
+
+#endif
+
+bool executor_c::setSize(unsigned int threads) {
+
+  if (pool)
+    return false;
+
+  requestedSize = threads;
+  return true;
+}
@@ -0,0 +1,204 @@
+/* BurrTools
+ *
+ * BurrTools is the legal property of its developers, whose
+ * names are listed in the COPYRIGHT file, which is included
+ * within the source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+#ifndef __EXECUTOR_H__
+#define __EXECUTOR_H__
+
+#ifndef NO_THREADING
+#include <boost/atomic.hpp>
+#endif
+
+#include "bt_assert.h"
+
+#include <vector>
+
+/**
+ * A flag to cancel tasks.
+ *
+ * Several tasks can share one token. Cancelling the token prevents all tasks
+ * that have not yet started from running at all, tasks that are already
+ * running should check isCancelled from time to time and return early.
+ */
+class cancelToken_c {
+
+  private:
+
+#ifndef NO_THREADING
+    boost::atomic<bool> cancelled;
+#else
+    bool cancelled;
+#endif
+
+  public:
+
+    cancelToken_c(void) : cancelled(false) {}
+
+    void cancel(void) { cancelled = true; }
+    void reset(void) { cancelled = false; }
+    bool isCancelled(void) const { return cancelled; }
+
+  private:
+
+    // no copying and assigning
+    cancelToken_c(const cancelToken_c&);
+    void operator=(const cancelToken_c&);
+};
+
+/**
+ * A piece of work for the executor.
+ *
+ * Derive from this class and implement run. The task belongs to the one who
+ * submitted it, the executor never deletes tasks. A task must not be
+ * deleted or submitted again before executor_c::wait has returned for it.
+ *
+ * run should not throw, tasks that can fail should keep the error and let
+ * the one who waits for them handle it. When an exception escapes anyway
+ * the executor catches it, so the workers and the other waiters continue,
+ * and executor_c::wait throws an assert_exception for the task.
+ */
+class task_c {
+
+  friend class executor_c;
+  friend class executorImpl_c;
+
+  public:
+
+    task_c(void) : token(0), state(TS_IDLE), failed(false) {}
+    virtual ~task_c(void) {}
+
+    /** use the given token to cancel this task, 0 for no token */
+    void setCancelToken(const cancelToken_c * t) { token = t; }
+
+    /** returns true, when the token of the task has been cancelled */
+    bool cancelled(void) const { return token && token->isCancelled(); }
+
+    /** returns true, when the task has been submitted and is not yet done */
+    bool pending(void) const { return state != TS_IDLE; }
+
+  protected:
+
+    /** the work to do */
+    virtual void run(void) = 0;
+
+  private:
+
+    enum {
+      TS_IDLE,    ///< not submitted or done
+      TS_QUEUED,  ///< waiting in a queue
+      TS_RUNNING  ///< currently running
+    };
+
+    const cancelToken_c * token;
+
+#ifndef NO_THREADING
+    boost::atomic<int> state;
+#else
+    int state;
+#endif
+
+    /** run has thrown, ae is the exception to pass on in executor_c::wait */
+    bool failed;
+    assert_exception ae;
+
+    /** call run, exceptions are kept in failed and ae */
+    void execute(void);
+
+    /** throw the kept exception, if there is one */
+    void rethrow(void);
+
+    // no copying and assigning
+    task_c(const task_c&);
+    void operator=(const task_c&);
+};
+
+class executorImpl_c;
+
+/**
+ * The library wide thread pool.
+ *
+ * All work that should run in parallel is submitted as tasks to this one
+ * pool, so the number of threads working for the library never exceeds its
+ * size, regardless of how many solvers or other jobs are active.
+ *
+ * Each worker thread has its own deque of tasks. Tasks submitted from within a
+ * worker go to the back of the deque of that worker and are taken from there
+ * again (newest first, the data is probably still in the cache). Idle workers
+ * steal the oldest tasks from the front of the other deques. Tasks submitted
+ * from outside of the pool go into a shared queue and are started in the
+ * order they were submitted.
+ *
+ * When a worker waits for a task it runs other tasks from the deques in the
+ * meantime, so tasks may submit subtasks and wait for them without blocking
+ * the pool.
+ *
+ * With NO_THREADING there are no threads at all, submit runs the task
+ * right away.
+ */
+class executor_c {
+
+  public:
+
+    /** the pool, it is created with the first call */
+    static executor_c & instance(void);
+
+    /**
+     * set the number of worker threads, 0 means one for each processor
+     * of the machine. This only has an effect when called before the pool
+     * is used for the first time, false is returned otherwise
+     */
+    static bool setSize(unsigned int threads);
+
+    /** number of worker threads */
+    unsigned int size(void) const;
+
+    /**
+     * queue the task for execution. The task must not be pending.
+     * When the cancel token of the task is cancelled before the task
+     * starts, it will not be run
+     */
+    void submit(task_c * t);
+
+    /**
+     * wait until the task is done. When called from a worker thread other
+     * subtasks are executed while waiting. When run of the task has thrown
+     * an exception it is thrown here
+     */
+    void wait(task_c * t);
+
+    /** returns true, when the calling thread is one of the workers of the pool */
+    bool inWorker(void) const;
+
+  private:
+
+    executor_c(unsigned int threads);
+
+    static void createPool(void);
+
+    /** the pool lives until the program ends, it is never destroyed */
+    ~executor_c(void);
+
+    executorImpl_c * impl;
+
+    // no copying and assigning
+    executor_c(const executor_c&);
+    void operator=(const executor_c&);
+};
+
+#endif
@@ -0,0 +1,108 @@
+/* BurrTools
+ *
+ * BurrTools is the legal property of its developers, whose
+ * names are listed in the COPYRIGHT file, which is included
+ * within the source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+#include "executor.h"
+#include <boost/test/unit_test.hpp>
+
+/* sums up the numbers from 1 to n by splitting the range into subtasks
+ * that are waited for inside of the tasks
+ */
+class sumTask_c : public task_c {
+
+  unsigned long from, to;
+
+  public:
+
+    unsigned long result;
+
+    sumTask_c(unsigned long f, unsigned long t) : from(f), to(t), result(0) {}
+
+  protected:
+
+    void run(void) {
+
+      if (to - from < 16) {
+        for (unsigned long i = from; i <= to; i++)
+          result += i;
+        return;
+      }
+
+      unsigned long mid = (from + to) / 2;
+
+      sumTask_c a(from, mid);
+      sumTask_c b(mid+1, to);
+
+      executor_c::instance().submit(&a);
+      executor_c::instance().submit(&b);
+      executor_c::instance().wait(&a);
+      executor_c::instance().wait(&b);
+
+      result = a.result + b.result;
+    }
+};
+
+/* a task that fails */
+class failTask_c : public task_c {
+
+  protected:
+
+    void run(void) {
+      bt_assert(false);
+    }
+};
+
+BOOST_AUTO_TEST_CASE( executor_test )
+{
+  executor_c::setSize(3);
+
+  sumTask_c t(1, 10000);
+
+  executor_c::instance().submit(&t);
+  executor_c::instance().wait(&t);
+
+  BOOST_CHECK( !t.pending() );
+  BOOST_CHECK_EQUAL( t.result, 10000ul * 10001 / 2 );
+
+  // cancelled tasks are not run at all
+  cancelToken_c token;
+  token.cancel();
+
+  sumTask_c c(1, 100);
+  c.setCancelToken(&token);
+
+  executor_c::instance().submit(&c);
+  executor_c::instance().wait(&c);
+
+  BOOST_CHECK_EQUAL( c.result, 0ul );
+
+  // the exception of a task is thrown by wait, the pool keeps on working
+  failTask_c f;
+
+  executor_c::instance().submit(&f);
+  BOOST_CHECK_THROW( executor_c::instance().wait(&f), assert_exception );
+  BOOST_CHECK( !f.pending() );
+
+  sumTask_c s(1, 1000);
+
+  executor_c::instance().submit(&s);
+  executor_c::instance().wait(&s);
+
+  BOOST_CHECK_EQUAL( s.result, 1000ul * 1001 / 2 );
+}
@@ -0,0 +1,365 @@
+/* BurrTools
+ *
+ * BurrTools is the legal property of its developers, whose
+ * names are listed in the COPYRIGHT file, which is included
+ * within the source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+#include "frontfile.h"
+
+#include "bt_assert.h"
+#include "disassemblernode.h"
+
+#include <algorithm>
+#include <queue>
+
+#ifndef WIN32
+#include <stdlib.h>
+#include <unistd.h>
+#endif
+
+/* open a new temporary file in the directory, it is removed once it is closed */
+static FILE * tempFile(const std::string & directory) {
+
+#ifndef WIN32
+  if (!directory.empty()) {
+
+    std::string name = directory + "/burrtoolsXXXXXX";
+    std::vector<char> buf(name.begin(), name.end());
+    buf.push_back(0);
+
+    int fd = mkstemp(&buf[0]);
+
+    if (fd >= 0) {
+      unlink(&buf[0]);
+      return fdopen(fd, "w+b");
+    }
+  }
+#else
+  (void)directory;
+#endif
+
+  return tmpfile();
+}
+
+/* the files can get bigger than what a long can address, returns false, when seeking failed */
+static bool seekRecord(FILE * f, unsigned long idx, unsigned int pn) {
+
+  uint64_t pos = (uint64_t)idx * frontFile_c::recordSize(pn) * sizeof(int16_t);
+
+#ifdef WIN32
+  return _fseeki64(f, pos, SEEK_SET) == 0;
+#else
+  return fseeko(f, pos, SEEK_SET) == 0;
+#endif
+}
+
+frontFile_c::frontFile_c(unsigned int p, const std::string & directory) : pn(p), records(0) {
+
+  f = tempFile(directory);
+  failed = !f;
+}
+
+frontFile_c::~frontFile_c(void) {
+  if (f) fclose(f);
+}
+
+int frontFile_c::compare(const int16_t * a, const int16_t * b, unsigned int pn) {
+
+  // the same order as the comparison of the nodes: transformation of piece 0, then the other pieces relative to piece 0
+  if (a[3] != b[3]) return a[3] < b[3] ? -1 : 1;
+
+  for (unsigned int i = 1; i < pn; i++) {
+
+    for (unsigned int j = 0; j < 3; j++) {
+
+      int da = a[4*i+j] - a[j];
+      int db = b[4*i+j] - b[j];
+
+      if (da != db) return da < db ? -1 : 1;
+    }
+
+    if (a[4*i+3] != b[4*i+3]) return a[4*i+3] < b[4*i+3] ? -1 : 1;
+  }
+
+  return 0;
+}
+
+void frontFile_c::record(const disassemblerNode_c * node, int16_t * rec) {
+
+  const disassemblerNode_c * from = node->getComefrom();
+  unsigned int pn = node->getPiecenumber();
+
+  // the root node is its own come-from node
+  if (!from) from = node;
+
+  for (unsigned int i = 0; i < pn; i++) {
+    rec[4*i+0] = node->getX(i);
+    rec[4*i+1] = node->getY(i);
+    rec[4*i+2] = node->getZ(i);
+    rec[4*i+3] = node->getTrans(i);
+
+    rec[4*(pn+i)+0] = from->getX(i);
+    rec[4*(pn+i)+1] = from->getY(i);
+    rec[4*(pn+i)+2] = from->getZ(i);
+    rec[4*(pn+i)+3] = from->getTrans(i);
+  }
+}
+
+void frontFile_c::add(const int16_t * rec) {
+
+  if (failed) return;
+
+  if (fwrite(rec, sizeof(int16_t), recordSize(pn), f) == recordSize(pn))
+    records++;
+  else
+    failed = true;
+}
+
+void frontFile_c::rewind(void) {
+
+  if (failed) return;
+
+  if (fflush(f) != 0 || !seekRecord(f, 0, pn))
+    failed = true;
+}
+
+bool frontFile_c::read(int16_t * rec) {
+
+  if (failed) return false;
+
+  if (fread(rec, sizeof(int16_t), recordSize(pn), f) == recordSize(pn))
+    return true;
+
+  // the end of the file is no error
+  if (ferror(f))
+    failed = true;
+
+  return false;
+}
+
+bool frontFile_c::find(const int16_t * pos, int16_t * rec) {
+
+  if (failed || fflush(f) != 0) {
+    failed = true;
+    return false;
+  }
+
+  unsigned long lo = 0;
+  unsigned long hi = records;
+
+  while (lo < hi) {
+
+    unsigned long mid = lo + (hi-lo)/2;
+
+    if (!seekRecord(f, mid, pn) || !read(rec)) {
+      failed = true;
+      return false;
+    }
+
+    int c = compare(rec, pos, pn);
+
+    if (c == 0)
+      return true;
+    else if (c < 0)
+      lo = mid+1;
+    else
+      hi = mid;
+  }
+
+  return false;
+}
+
+/* runs with fewer records than this are not written, each run keeps a file open while merging */
+static const unsigned long minRunRecords = 4096;
+
+frontBuilder_c::frontBuilder_c(unsigned int p, unsigned long memory, const std::string & dir) :
+  pn(p), directory(dir), buffered(0), failed(false) {
+
+  maxRecords = memory / (frontFile_c::recordSize(pn) * sizeof(int16_t));
+  if (maxRecords < minRunRecords)
+    maxRecords = minRunRecords;
+}
+
+frontBuilder_c::~frontBuilder_c(void) {
+
+  for (unsigned int i = 0; i < runs.size(); i++)
+    delete runs[i];
+}
+
+void frontBuilder_c::add(const disassemblerNode_c * node) {
+
+  bt_assert(node->getPiecenumber() == pn);
+
+  unsigned int rs = frontFile_c::recordSize(pn);
+
+  buffer.resize((buffered+1)*rs);
+  frontFile_c::record(node, &buffer[buffered*rs]);
+  buffered++;
+
+  if (buffered >= maxRecords)
+    flush();
+}
+
+/* orders the indices of the records in the buffer, equal records stay in the order they were added */
+class recordOrder_c {
+
+    const std::vector<int16_t> & buffer;
+    unsigned int pn;
+
+  public:
+
+    recordOrder_c(const std::vector<int16_t> & b, unsigned int p) : buffer(b), pn(p) {}
+
+    bool operator()(unsigned long a, unsigned long b) const {
+      int c = frontFile_c::compare(&buffer[a*frontFile_c::recordSize(pn)], &buffer[b*frontFile_c::recordSize(pn)], pn);
+      return c < 0 || (c == 0 && a < b);
+    }
+};
+
+void frontBuilder_c::flush(void) {
+
+  if (!buffered) return;
+
+  unsigned int rs = frontFile_c::recordSize(pn);
+
+  std::vector<unsigned long> order(buffered);
+  for (unsigned long i = 0; i < buffered; i++)
+    order[i] = i;
+
+  std::sort(order.begin(), order.end(), recordOrder_c(buffer, pn));
+
+  frontFile_c * run = new frontFile_c(pn, directory);
+
+  for (unsigned long i = 0; i < buffered; i++)
+    if (i == 0 || frontFile_c::compare(&buffer[order[i-1]*rs], &buffer[order[i]*rs], pn) != 0)
+      run->add(&buffer[order[i]*rs]);
+
+  if (!run->ok())
+    failed = true;
+
+  runs.push_back(run);
+
+  buffered = 0;
+  buffer.clear();
+}
+
+/* the heads of the runs while merging, the run with the smallest
+ * record comes first, for equal records the older run
+ */
+class runOrder_c {
+
+    const std::vector<int16_t> & heads;
+    unsigned int pn;
+
+  public:
+
+    runOrder_c(const std::vector<int16_t> & h, unsigned int p) : heads(h), pn(p) {}
+
+    bool operator()(unsigned int a, unsigned int b) const {
+      int c = frontFile_c::compare(&heads[a*frontFile_c::recordSize(pn)], &heads[b*frontFile_c::recordSize(pn)], pn);
+      return c > 0 || (c == 0 && a > b);
+    }
+};
+
+/* a front that is read in parallel to the merge to leave out its positions */
+class frontReader_c {
+
+    frontFile_c * front;
+    std::vector<int16_t> rec;
+    bool valid;
+    unsigned int pn;
+
+  public:
+
+    frontReader_c(frontFile_c * f, unsigned int p) : front(f), rec(frontFile_c::recordSize(p)), valid(false), pn(p) {
+      if (front) {
+        front->rewind();
+        valid = front->read(&rec[0]);
+      }
+    }
+
+    /** true, when the front contains the positions of r, the records must be checked in sorted order */
+    bool contains(const int16_t * r) {
+
+      while (valid && frontFile_c::compare(&rec[0], r, pn) < 0)
+        valid = front->read(&rec[0]);
+
+      return valid && frontFile_c::compare(&rec[0], r, pn) == 0;
+    }
+};
+
+frontFile_c * frontBuilder_c::finish(frontFile_c * cur, frontFile_c * old) {
+
+  flush();
+
+  unsigned int rs = frontFile_c::recordSize(pn);
+
+  std::vector<int16_t> heads(runs.size() * rs);
+  std::priority_queue<unsigned int, std::vector<unsigned int>, runOrder_c> queue(runOrder_c(heads, pn));
+
+  for (unsigned int i = 0; i < runs.size(); i++) {
+    runs[i]->rewind();
+    if (runs[i]->read(&heads[i*rs]))
+      queue.push(i);
+  }
+
+  frontReader_c curReader(cur, pn);
+  frontReader_c oldReader(old, pn);
+
+  frontFile_c * res = new frontFile_c(pn, directory);
+
+  std::vector<int16_t> last(rs);
+  bool haveLast = false;
+
+  while (!queue.empty()) {
+
+    unsigned int r = queue.top();
+    queue.pop();
+
+    const int16_t * rec = &heads[r*rs];
+
+    if ((!haveLast || frontFile_c::compare(&last[0], rec, pn) != 0) &&
+        !curReader.contains(rec) && !oldReader.contains(rec))
+      res->add(rec);
+
+    std::copy(rec, rec+rs, last.begin());
+    haveLast = true;
+
+    if (runs[r]->read(&heads[r*rs]))
+      queue.push(r);
+  }
+
+  /* a run or front that could not be read ends like a complete one, so the
+   * result is only usable, when all files are fine
+   */
+  bool broken = failed || (cur && !cur->ok()) || (old && !old->ok());
+
+  for (unsigned int i = 0; i < runs.size(); i++) {
+    broken |= !runs[i]->ok();
+    delete runs[i];
+  }
+  runs.clear();
+
+  res->rewind();
+
+  if (broken || !res->ok()) {
+    delete res;
+    return 0;
+  }
+
+  return res;
+}
@@ -0,0 +1,176 @@
+/* BurrTools
+ *
+ * BurrTools is the legal property of its developers, whose
+ * names are listed in the COPYRIGHT file, which is included
+ * within the source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+#ifndef __FRONTFILE_H__
+#define __FRONTFILE_H__
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <string>
+#include <vector>
+
+class disassemblerNode_c;
+
+/**
+ * A front of the breadth first search of disassembler_0_c stored in a file.
+ *
+ * When the fronts of a search get too big for the memory, the disassembler
+ * keeps them in files. Each node is stored as a record with its own positions
+ * followed by the positions of the node it was reached from, both in the wide
+ * format of disassemblerNode_c, 4 16 bit values (x, y, z and transformation)
+ * for each piece.
+ *
+ * The records are sorted by the positions relative to piece 0, the way
+ * disassemblerNode_c compares its nodes, and each position is contained only
+ * once. So a position can be found by binary search and fronts can be compared
+ * by going through them in parallel.
+ *
+ * The file is a temporary file that is removed, when the front is destroyed.
+ *
+ * Running out of disk space is not unusual for big fronts, so errors of the
+ * file are not asserts. Once an operation has failed the front is broken, all
+ * further operations do nothing and ok returns false.
+ */
+class frontFile_c {
+
+  private:
+
+    FILE * f;
+
+    /** number of pieces of the nodes */
+    unsigned int pn;
+
+    /** number of records in the file */
+    unsigned long records;
+
+    /** an operation on the file has failed */
+    bool failed;
+
+  public:
+
+    /**
+     * create an empty front for nodes with pn pieces, the file is
+     * placed in the given directory, or the default place for temporary files
+     * when it is empty
+     */
+    frontFile_c(unsigned int pn, const std::string & directory);
+    ~frontFile_c(void);
+
+    /** number of 16 bit values of a record */
+    static unsigned int recordSize(unsigned int pn) { return 8*pn; }
+
+    /**
+     * compare the positions (the first half of the records) of a and
+     * b, returns a value less than, equal to or greater than 0
+     */
+    static int compare(const int16_t * a, const int16_t * b, unsigned int pn);
+
+    /**
+     * create the record for a node, for the root node without a
+     * come-from node its own positions are used as come-from positions
+     */
+    static void record(const disassemblerNode_c * node, int16_t * rec);
+
+    /** number of records */
+    unsigned long size(void) const { return records; }
+
+    /** false, when the file could not be created, written or read */
+    bool ok(void) const { return !failed; }
+
+    /** append a record, the records must be added in sorted order */
+    void add(const int16_t * rec);
+
+    /** start reading the records from the beginning */
+    void rewind(void);
+
+    /** read the next record, returns false, when there are no more records or reading failed */
+    bool read(int16_t * rec);
+
+    /**
+     * find the record with the same positions as pos (relative to piece 0) and
+     * copy it into rec, returns false, when there is none. The reading position is
+     * undefined afterwards, call rewind before reading again
+     */
+    bool find(const int16_t * pos, int16_t * rec);
+
+  private:
+
+    // no copying and assigning
+    frontFile_c(const frontFile_c&);
+    void operator=(const frontFile_c&);
+};
+
+/**
+ * Collects the nodes of a new front of the search.
+ *
+ * The records are kept in memory until they need more than the given number
+ * of bytes, then they are sorted and written into a file (a run). At the end
+ * the runs are merged into a new front. Duplicates are only dropped while
+ * sorting and merging, not when the nodes are added.
+ */
+class frontBuilder_c {
+
+  private:
+
+    unsigned int pn;
+    unsigned long maxRecords;
+    std::string directory;
+
+    /** the records that are not yet written */
+    std::vector<int16_t> buffer;
+    unsigned long buffered;
+
+    /** the sorted runs written so far */
+    std::vector<frontFile_c *> runs;
+
+    /** one of the runs could not be written */
+    bool failed;
+
+    /** sort the buffer and write it as a new run */
+    void flush(void);
+
+  public:
+
+    frontBuilder_c(unsigned int pn, unsigned long memory, const std::string & directory);
+    ~frontBuilder_c(void);
+
+    /** add a node */
+    void add(const disassemblerNode_c * node);
+
+    /** number of records waiting in memory */
+    unsigned long inMemory(void) const { return buffered; }
+
+    /**
+     * merge all nodes into a new front, each position is contained only once and
+     * positions that are in one of the fronts cur and old (both may be 0) are left out.
+     * The caller has to free the returned front. When one of the files could not
+     * be written or read 0 is returned
+     */
+    frontFile_c * finish(frontFile_c * cur, frontFile_c * old);
+
+  private:
+
+    // no copying and assigning
+    frontBuilder_c(const frontBuilder_c&);
+    void operator=(const frontBuilder_c&);
+};
+
+#endif
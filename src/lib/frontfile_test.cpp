@@ -0,0 +1,106 @@
+/* BurrTools
+ *
+ * BurrTools is the legal property of its developers, whose
+ * names are listed in the COPYRIGHT file, which is included
+ * within the source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+#include "frontfile.h"
+#include "disassemblernode.h"
+#include <boost/test/unit_test.hpp>
+
+/* a node with 2 pieces, piece 1 is d units right of piece 0, which is at x */
+static disassemblerNode_c * node(disassemblerNode_c * root, int x, int d) {
+
+  disassemblerNode_c * n = disassemblerNode_c::create(2, root, 0, 1);
+
+  n->set(0, x, 0, 0, 0);
+  n->set(1, x+d, 0, 0, 0);
+
+  return n;
+}
+
+BOOST_AUTO_TEST_CASE( frontfile_test )
+{
+  disassemblerNode_c * root = disassemblerNode_c::create(2);
+
+  root->set(0, 0, 0, 0, 0);
+  root->set(1, 1, 0, 0, 0);
+
+  // the current front contains the even distances below 100
+  frontBuilder_c curBuilder(2, 0, "");
+
+  for (int d = 0; d < 100; d += 2) {
+    disassemblerNode_c * n = node(root, 0, d);
+    curBuilder.add(n);
+    if (n->decRefCount())
+      delete n;
+  }
+
+  frontFile_c * cur = curBuilder.finish(0, 0);
+
+  BOOST_CHECK_EQUAL( cur->size(), 50u );
+
+  // a new front, big enough for several runs, each distance twice with different x
+  frontBuilder_c builder(2, 0, "");
+
+  for (int d = 9999; d >= 0; d--) {
+    disassemblerNode_c * n = node(root, d % 7, d);
+    disassemblerNode_c * m = node(root, 3, d);
+    builder.add(n);
+    builder.add(m);
+    if (n->decRefCount())
+      delete n;
+    if (m->decRefCount())
+      delete m;
+  }
+
+  frontFile_c * next = builder.finish(cur, 0);
+
+  // each distance is there once, the ones of the current front are left out
+  BOOST_CHECK_EQUAL( next->size(), 10000u - 50u );
+
+  std::vector<int16_t> rec(frontFile_c::recordSize(2));
+  std::vector<int16_t> last(frontFile_c::recordSize(2));
+
+  next->rewind();
+
+  for (unsigned long i = 0; i < next->size(); i++) {
+    BOOST_CHECK( next->read(&rec[0]) );
+    if (i)
+      BOOST_CHECK( frontFile_c::compare(&last[0], &rec[0], 2) < 0 );
+    last = rec;
+  }
+
+  BOOST_CHECK( !next->read(&rec[0]) );
+
+  // positions are found relative to piece 0, the come-from positions are kept
+  int16_t pos[8] = { 100, 5, 5, 0,   101, 5, 5, 0 };
+
+  BOOST_CHECK( next->find(pos, &rec[0]) );
+  BOOST_CHECK_EQUAL( rec[4] - rec[0], 1 );
+  BOOST_CHECK_EQUAL( rec[12], 1 );
+
+  pos[4] = 102;
+
+  BOOST_CHECK( !next->find(pos, &rec[0]) );
+
+  delete next;
+  delete cur;
+
+  if (root->decRefCount())
+    delete root;
+}
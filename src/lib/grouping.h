@@ -97,6 +97,9 @@ public:
    */
   void addPieces(unsigned int pc, unsigned int group, unsigned int count);
 
+  /** returns true, when any piece has been added with a group */
+  bool hasGroups(void) const { return numGroups > 0; }
+
   /** remove all sets and start fresh */
   void reSet(void);
 
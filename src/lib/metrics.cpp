@@ -0,0 +1,194 @@
+/* BurrTools
+ *
+ * BurrTools is the legal property of its developers, whose
+ * names are listed in the COPYRIGHT file, which is included
+ * within the source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+#include "metrics.h"
+
+#include "bt_assert.h"
+
+#include <sys/time.h>
+
+static uint64_t now(void) {
+  struct timeval tv;
+  gettimeofday(&tv, 0);
+  return (uint64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+#ifndef NO_THREADING
+
+void solveMetrics_c::put(value_t & v, uint64_t val) { v.store(val, boost::memory_order_relaxed); }
+uint64_t solveMetrics_c::get(const value_t & v) { return v.load(boost::memory_order_relaxed); }
+
+void solveMetrics_c::beginUpdate(void) {
+  seq.store(seq.load(boost::memory_order_relaxed) + 1, boost::memory_order_relaxed);
+  boost::atomic_thread_fence(boost::memory_order_release);
+}
+
+void solveMetrics_c::endUpdate(void) {
+  put(time, now() - startTime);
+  seq.store(seq.load(boost::memory_order_relaxed) + 1, boost::memory_order_release);
+}
+
+#else
+
+void solveMetrics_c::put(value_t & v, uint64_t val) { v = val; }
+uint64_t solveMetrics_c::get(const value_t & v) { return v; }
+
+void solveMetrics_c::beginUpdate(void) { seq++; }
+
+void solveMetrics_c::endUpdate(void) {
+  put(time, now() - startTime);
+  seq++;
+}
+
+#endif
+
+solveMetrics_c::solveMetrics_c(void) : seq(0) {
+  reset();
+}
+
+void solveMetrics_c::reset(void) {
+
+  startTime = phaseStart = now();
+  disassemblyCount = 0;
+  interlockedCount = 0;
+
+  beginUpdate();
+
+  put(iterations, 0);
+  put(assemblies, 0);
+  put(solutions, 0);
+  put(disassemblies, 0);
+  put(interlocked, 0);
+  put(nodes, 0);
+  put(queueDepth, 0);
+  put(memory, 0);
+  put(finished, 0);
+  put(phase, PH_IDLE);
+  for (unsigned int i = 0; i < PH_NUM; i++)
+    put(phaseTime[i], 0);
+
+  endUpdate();
+}
+
+void solveMetrics_c::getSnapshot(snapshot & s) const {
+
+#ifndef NO_THREADING
+  unsigned int s1, s2;
+
+  do {
+    s1 = seq.load(boost::memory_order_acquire);
+
+    // odd means the writer is just changing the values
+    if (s1 & 1) continue;
+#endif
+
+    s.time = get(time);
+    s.iterations = get(iterations);
+    s.assemblies = get(assemblies);
+    s.solutions = get(solutions);
+    s.disassemblies = get(disassemblies);
+    s.interlocked = get(interlocked);
+    s.nodes = get(nodes);
+    s.queueDepth = get(queueDepth);
+    s.memory = get(memory);
+    s.finished = get(finished);
+    s.phase = get(phase);
+    for (unsigned int i = 0; i < PH_NUM; i++)
+      s.phaseTime[i] = get(phaseTime[i]);
+
+#ifndef NO_THREADING
+    boost::atomic_thread_fence(boost::memory_order_acquire);
+    s2 = seq.load(boost::memory_order_relaxed);
+
+    if (s1 == s2) break;
+
+  } while (true);
+#endif
+}
+
+void solveMetrics_c::getRates(const snapshot & older, const snapshot & newer, rates & r) {
+
+  if (newer.time <= older.time) {
+    r.iterations = r.assemblies = r.disassemblies = r.nodes = 0;
+    return;
+  }
+
+  double t = (newer.time - older.time) / 1000000.0;
+
+  r.iterations = (newer.iterations - older.iterations) / t;
+  r.assemblies = (newer.assemblies - older.assemblies) / t;
+  r.disassemblies = (newer.disassemblies - older.disassemblies) / t;
+  r.nodes = (newer.nodes - older.nodes) / t;
+}
+
+void solveMetrics_c::setPhase(unsigned int ph) {
+
+  bt_assert(ph < PH_NUM);
+
+  uint64_t n = now();
+  unsigned int old = get(phase);
+
+  beginUpdate();
+  put(phaseTime[old], get(phaseTime[old]) + (n - phaseStart));
+  put(phase, ph);
+  endUpdate();
+
+  phaseStart = n;
+}
+
+void solveMetrics_c::setAssemblerProgress(unsigned long it, float fin) {
+
+  if (fin < 0) fin = 0;
+  if (fin > 1) fin = 1;
+
+  beginUpdate();
+  put(iterations, it);
+  put(finished, (uint64_t)(fin * 1000000));
+  endUpdate();
+}
+
+void solveMetrics_c::setSolutionCounts(unsigned long ass, unsigned long sol) {
+  beginUpdate();
+  put(assemblies, ass);
+  put(solutions, sol);
+  endUpdate();
+}
+
+void solveMetrics_c::addDisassembly(void) {
+  disassemblyCount++;
+  beginUpdate();
+  put(disassemblies, disassemblyCount);
+  endUpdate();
+}
+
+void solveMetrics_c::addInterlocked(unsigned long count) {
+  interlockedCount += count;
+  beginUpdate();
+  put(interlocked, interlockedCount);
+  endUpdate();
+}
+
+void solveMetrics_c::setDisassemblerProgress(unsigned long n, unsigned long q, unsigned long m) {
+  beginUpdate();
+  put(nodes, n);
+  put(queueDepth, q);
+  put(memory, m);
+  endUpdate();
+}
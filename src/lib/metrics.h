@@ -0,0 +1,157 @@
+/* BurrTools
+ *
+ * BurrTools is the legal property of its developers, whose
+ * names are listed in the COPYRIGHT file, which is included
+ * within the source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+#ifndef __METRICS_H__
+#define __METRICS_H__
+
+#include <stdint.h>
+
+#ifndef NO_THREADING
+#include <boost/atomic.hpp>
+#endif
+
+/**
+ * Progress information of a running solve.
+ *
+ * The solving thread is the only one writing into this class, all other
+ * threads (GUI, command line tools, library users) may read a snapshot at
+ * any time and as often as they like. Publication is done seqlock style: the
+ * writer increments a sequence counter before and after changing the values,
+ * readers retry until they get a copy with the same even counter on both
+ * ends. So the writer never waits for anything and readers always get a
+ * consistent set of values.
+ *
+ * The engines only publish every few thousand steps, so the cost in the hot
+ * loops is a counter check.
+ */
+class solveMetrics_c {
+
+  public:
+
+    /** the phases of a solve, times are collected for each of them */
+    enum {
+      PH_PREPARATION,
+      PH_REDUCE,
+      PH_ASSEMBLING,
+      PH_DISASSEMBLING,
+      PH_IDLE,
+      PH_NUM
+    };
+
+    /** a consistent copy of the metrics */
+    struct snapshot {
+      uint64_t time;          ///< microseconds since the metrics were reset
+      uint64_t iterations;    ///< iterations of the assembler
+      uint64_t assemblies;    ///< assemblies found
+      uint64_t solutions;     ///< assemblies that could be disassembled
+      uint64_t disassemblies; ///< number of disassembly analyses done
+      uint64_t interlocked;   ///< disassembly analyses that ended at once because nothing could move
+      uint64_t nodes;         ///< nodes the disassembler has examined
+      uint64_t queueDepth;    ///< current size of the open list of the disassembler
+      uint64_t memory;        ///< estimated bytes used by the disassembler node fronts
+      uint64_t finished;      ///< part of the search space done in millionths
+      uint64_t phase;         ///< the current phase, one of PH_xxx
+      uint64_t phaseTime[PH_NUM]; ///< microseconds spent in each phase
+    };
+
+    /** speeds calculated from 2 snapshots */
+    struct rates {
+      double iterations;    ///< assembler iterations per second
+      double assemblies;    ///< assemblies per second
+      double disassemblies; ///< disassembly analyses per second
+      double nodes;         ///< disassembler nodes per second
+    };
+
+    solveMetrics_c(void);
+
+    /** set all values to 0 and restart the clock, only the writer may do this */
+    void reset(void);
+
+    /** get a consistent copy of the current values, can be called from any thread */
+    void getSnapshot(snapshot & s) const;
+
+    /**
+     * calculate the speeds between two snapshots, older must have been
+     * taken before newer, when no time has passed all rates are 0
+     */
+    static void getRates(const snapshot & older, const snapshot & newer, rates & r);
+
+    /* the writer functions, they must all be called from the same thread */
+
+    /** switch to a new phase, the time since the last switch is added to the old phase */
+    void setPhase(unsigned int phase);
+
+    /** the assembler publishes its progress, finished is the value of assembler_c::getFinished */
+    void setAssemblerProgress(unsigned long iterations, float finished);
+
+    /** publish the current counters of the solutions */
+    void setSolutionCounts(unsigned long assemblies, unsigned long solutions);
+
+    /** one more disassembly analysis has been started */
+    void addDisassembly(void);
+
+    /** the assemblies of count disassembly analyses were found to be completely interlocked */
+    void addInterlocked(unsigned long count = 1);
+
+    /** the disassembler publishes its progress */
+    void setDisassemblerProgress(unsigned long nodes, unsigned long queueDepth, unsigned long memory);
+
+  private:
+
+#ifndef NO_THREADING
+    typedef boost::atomic<uint64_t> value_t;
+    boost::atomic<unsigned int> seq;
+#else
+    typedef uint64_t value_t;
+    unsigned int seq;
+#endif
+
+    value_t time;
+    value_t iterations;
+    value_t assemblies;
+    value_t solutions;
+    value_t disassemblies;
+    value_t interlocked;
+    value_t nodes;
+    value_t queueDepth;
+    value_t memory;
+    value_t finished;
+    value_t phase;
+    value_t phaseTime[PH_NUM];
+
+    /** writer side local values, not published */
+    uint64_t startTime;
+    uint64_t phaseStart;
+    uint64_t disassemblyCount;
+    uint64_t interlockedCount;
+
+    void beginUpdate(void);
+    void endUpdate(void);
+
+    /** access to the values, the ordering is done by the sequence counter */
+    static void put(value_t & v, uint64_t val);
+    static uint64_t get(const value_t & v);
+
+    // no copying and assigning
+    solveMetrics_c(const solveMetrics_c&);
+    void operator=(const solveMetrics_c&);
+};
+
+#endif
@@ -33,15 +33,19 @@ bool isNotchable(const voxel_c * v)
   voxel_0_c vxz(v->getX(), 1u, v->getZ(), &gt, 0);
   voxel_0_c vyz(1u, v->getY(), v->getZ(), &gt, 0);
 
-  for (unsigned int x = 0; x < v->getX(); x++)
-    for (unsigned int y = 0; y < v->getY(); y++)
-      for (unsigned int z = 0; z < v->getZ(); z++)
-        if (v->isFilled(x, y, z))
-        {
-          vxy.set(x, y, 0, voxel_c::VX_FILLED);
-          vxz.set(x, 0, z, voxel_c::VX_FILLED);
-          vyz.set(0, y, z, voxel_c::VX_FILLED);
-        }
+  {
+    voxelEdit_c exy(vxy), exz(vxz), eyz(vyz);
+
+    for (unsigned int x = 0; x < v->getX(); x++)
+      for (unsigned int y = 0; y < v->getY(); y++)
+        for (unsigned int z = 0; z < v->getZ(); z++)
+          if (v->isFilled(x, y, z))
+          {
+            vxy.set(x, y, 0, voxel_c::VX_FILLED);
+            vxz.set(x, 0, z, voxel_c::VX_FILLED);
+            vyz.set(0, y, z, voxel_c::VX_FILLED);
+          }
+  }
 
   for (unsigned int x = 0; x < v->getX(); x++)
     for (unsigned int y = 0; y < v->getY(); y++)
@@ -22,6 +22,7 @@
 
 #include "bt_assert.h"
 #include "movementcache.h"
+#include "disassemblerstats.h"
 #include "problem.h"
 #include "puzzle.h"
 #include "disassemblernode.h"
@@ -31,135 +32,183 @@
 
 #include <string.h>
 
-/**
- * this function fills the matrix with the movement values of
- * pairs of pieces
- * this is done using the movement cache
+#if defined(__SSE4_1__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+/* the closure of the movement matrix is a min-plus closure, what Bill Cutler describes
+ * is in fact the Floyd-Warshall algorithm on the distances: piece y can move m[y][x]
+ * relative to x, and x can move m[x][i] relative to i, so y can move at most
+ * m[y][x] + m[x][i] relative to i, because i can push x which pushes y
+ *
+ * the rows of each direction are in one block and padded to a multiple of 4, so the
+ * innermost loop runs over whole vectors. The padding columns are calculated as well
+ * but never used
  */
-void movementAnalysator_c::prepare(void) {
 
-  unsigned int * idx = matrix;
+/* for each row i in [i1, i2) and each k in [k1, k2) relax the columns [j1, j2) of
+ * row i by the columns of row k
+ */
+static void relax(unsigned int * m, unsigned int stride, unsigned int k1, unsigned int k2,
+                  unsigned int i1, unsigned int i2, unsigned int j1, unsigned int j2) {
+
+  for (unsigned int k = k1; k < k2; k++) {
 
-  int idxCol = cache->numDirections();
-  int idxRow = cache->numDirections() * (piecenumber- pieces->size());
+    const unsigned int * rk = m + k*stride;
 
-  for (unsigned int j = 0; j < pieces->size(); j++) {
-    for (unsigned int i = 0; i < pieces->size(); i++) {
-      if (i != j)
-        cache->getMoValue(searchnode->getX(j) - searchnode->getX(i),
-                          searchnode->getY(j) - searchnode->getY(i),
-                          searchnode->getZ(j) - searchnode->getZ(i),
-                          searchnode->getTrans(i), searchnode->getTrans(j),
-                          (*pieces)[i], (*pieces)[j], idx);
+    for (unsigned int i = i1; i < i2; i++) {
 
-      // the diagonals are always zero and will stay that for ever they are initialised
-      // to that value in the init function so only the other values need
-      idx += idxCol;
+      // the diagonal is 0, so row k can not change itself
+      if (i == k) continue;
+
+      unsigned int * ri = m + i*stride;
+      unsigned int c = ri[k];
+      unsigned int j = j1;
+
+#if defined(__AVX2__)
+      __m256i cv = _mm256_set1_epi32(c);
+      for (; j+8 <= j2; j += 8) {
+        __m256i v = _mm256_add_epi32(_mm256_loadu_si256((const __m256i*)(rk+j)), cv);
+        _mm256_storeu_si256((__m256i*)(ri+j), _mm256_min_epu32(_mm256_loadu_si256((const __m256i*)(ri+j)), v));
+      }
+#endif
+#if defined(__SSE4_1__)
+      __m128i cw = _mm_set1_epi32(c);
+      for (; j+4 <= j2; j += 4) {
+        __m128i v = _mm_add_epi32(_mm_loadu_si128((const __m128i*)(rk+j)), cw);
+        _mm_storeu_si128((__m128i*)(ri+j), _mm_min_epu32(_mm_loadu_si128((const __m128i*)(ri+j)), v));
+      }
+#endif
+      for (; j < j2; j++)
+        if (rk[j] + c < ri[j])
+          ri[j] = rk[j] + c;
     }
-    idx += idxRow;
   }
+}
 
-  /* having a look at this algorithm in more detail
-   * it comes out that the first pass has lots to do, the 2nd pass
-   * is much cheaper (usually a few more corrections sometimes
-   * event zero) and then it finished
-   *
-   * so I change this: always look, if a change done leads to other necessary
-   * changes, and only if that is the case do another loop
+/* pieces are handled in blocks of this size, when there are more of them */
+static const unsigned int closureBlock = 16;
+
+/* the closure of a matrix with n rows, the columns are calculated up to the padded stride */
+static void closure(unsigned int * m, unsigned int n, unsigned int stride) {
+
+  if (n <= closureBlock) {
+    relax(m, stride, 0, n, 0, n, 0, stride);
+    return;
+  }
+
+  /* the blocked Floyd-Warshall, for each block of k first the diagonal block, then the
+   * blocks in the same rows and columns and last all the others. That way the rows
+   * used for relaxing stay in the cache
    */
+  for (unsigned int kb = 0; kb < n; kb += closureBlock) {
 
-  /* second part of Bills algorithm. */
+    unsigned int ke = (kb + closureBlock < n) ? kb + closureBlock : n;
 
-  unsigned int dirs = cache->numDirections();
-  unsigned int rowStep = dirs*piecenumber;
-  unsigned int size = dirs*pieces->size();
+    relax(m, stride, kb, ke, kb, ke, kb, ke);
 
-  bool again = false;
+    for (unsigned int jb = 0; jb < stride; jb += closureBlock)
+      if (jb != kb)
+        relax(m, stride, kb, ke, kb, ke, jb, (jb + closureBlock < stride) ? jb + closureBlock : stride);
 
-  for (unsigned int d = 0; d < dirs; d++) {
-    do {
-      again = false;
+    for (unsigned int ib = 0; ib < n; ib += closureBlock)
+      if (ib != kb)
+        relax(m, stride, kb, ke, ib, (ib + closureBlock < n) ? ib + closureBlock : n, kb, ke);
 
-#if 0
-      // this is just for commentary reasons it show the same algorithm as below
-      // just a bit more understandable
+    for (unsigned int ib = 0; ib < n; ib += closureBlock)
+      if (ib != kb)
+        for (unsigned int jb = 0; jb < stride; jb += closureBlock)
+          if (jb != kb)
+            relax(m, stride, kb, ke, ib, (ib + closureBlock < n) ? ib + closureBlock : n,
+                  jb, (jb + closureBlock < stride) ? jb + closureBlock : stride);
+  }
+}
 
-      for (unsigned int y = 0; y < pieces->size(); y++)
-        for (unsigned int x = 0; x < pieces->size(); x++) {
-          unsigned int min = matrix[x*dirs+d] + matrix[y*piecenumber*dirs+d];
+/**
+ * this function fills the matrix with the movement values of
+ * pairs of pieces
+ * this is done using the movement cache
+ *
+ * The values of a pair of pieces only depend on their relative position, so compared
+ * to the node analysed before only the pairs of pieces that were moved by different
+ * amounts need to be asked from the cache. In a breadth first search the node before
+ * is normally a sibling or the parent of the current node, so most pairs stay the same.
+ * When the pieces are different from the last call, all pairs are calculated.
+ *
+ * The closure is only kept, when no value changed. Updating it for changed values is only
+ * possible, when all of them got smaller, but moving pieces always brings them nearer
+ * to some pieces and further away from others, so that practically never happens
+ */
+void movementAnalysator_c::prepare(void) {
 
-          for (unsigned int i = 1; i < pieces->size(); i++) {
-            unsigned int l = matrix[(x + i*piecenumber)*dirs+d] + matrix[(i + y*piecenumber)*dirs+d];
-            if (l < min) min = l;
-          }
+  unsigned int dirs = cache->numDirections();
+  unsigned int n = pieces->size();
+  unsigned int mv[dirs];
 
-          if (min < matrix[(x + y*piecenumber)*dirs+d]) {
-            matrix[(x + y*piecenumber)*dirs+d] = min;
-            if (!again) {
-              for (unsigned int i = 0; i < y; i++)
-                if (min + matrix[(y + i*piecenumber)*dirs+d] < matrix[(x + i*piecenumber)*dirs+d]) {
-                  again = true;
-                  break;
-                }
-
-              if (!again)
-                for (unsigned int i = 0; i < x; i++)
-                  if (matrix[(i + x*piecenumber)*dirs+d] + min < matrix[(i + y*piecenumber)*dirs+d]) {
-                    again = true;
-                    break;
-                  }
-            }
-          }
-        }
-#endif
+  bool all = (lastPieces != *pieces);
 
-      unsigned int * pos1 = matrix + d;           // y * piecenumber;
-      unsigned int idx, i;
+  // how far each piece has moved since the last call
+  int delta[3*n];
 
-      for (unsigned int y = 0; y < size; y+=dirs) {
-        unsigned int * pos2 = matrix + d;           // x
+  for (unsigned int i = 0; i < n; i++) {
+    delta[3*i+0] = searchnode->getX(i) - lastPositions[4*i+0];
+    delta[3*i+1] = searchnode->getY(i) - lastPositions[4*i+1];
+    delta[3*i+2] = searchnode->getZ(i) - lastPositions[4*i+2];
 
-        for (unsigned int x = 0; x < size; x+=dirs) {
-          unsigned int min = *pos2 + *pos1;
+    if ((int)searchnode->getTrans(i) != lastPositions[4*i+3])
+      all = true;
+  }
 
-          for (i = dirs, idx = rowStep; i < size; i+=dirs, idx += rowStep) {
-            unsigned int l = pos2[idx] + pos1[i];
-            if (l < min) min = l;
-          }
+  bool changed = all;
 
-          if (min < pos1[x]) {
-            pos1[x] = min;
+  for (unsigned int j = 0; j < n; j++)
+    for (unsigned int i = 0; i < n; i++) {
 
-            if (!again) {
+      // the diagonals are always zero and will stay that for ever they are initialised
+      // to that value in the init function so only the other values need
+      if (i == j) continue;
 
-              unsigned int * pos3 = matrix + d;
+      if (!all &&
+          delta[3*i+0] == delta[3*j+0] && delta[3*i+1] == delta[3*j+1] && delta[3*i+2] == delta[3*j+2])
+        continue;
 
-              for (i = 0; i < y; i+=dirs) {
-                if (min + pos3[y] < pos3[x]) {
-                  again = true;
-                  break;
-                }
-                pos3 += rowStep;
-              }
+      cache->getMoValue(searchnode->getX(j) - searchnode->getX(i),
+                        searchnode->getY(j) - searchnode->getY(i),
+                        searchnode->getZ(j) - searchnode->getZ(i),
+                        searchnode->getTrans(i), searchnode->getTrans(j),
+                        (*pieces)[i], (*pieces)[j], mv, stats);
 
-              if (!again) {
+      for (unsigned int d = 0; d < dirs; d++) {
 
-                pos3 = matrix + d + piecenumber*x;
+        unsigned int & r = raw[d*matrixSize + j*matrixStride + i];
 
-                for (i = 0; i < x; i+=dirs)
-                  if (pos3[i] + min < pos1[i]) {
-                    again = true;
-                    break;
-                  }
-              }
-            }
-          }
-          pos2+=dirs;
+        if (mv[d] != r) {
+          r = mv[d];
+          changed = true;
         }
-
-        pos1 += rowStep;
       }
-    } while (again > 0);
+    }
+
+  if (changed) {
+
+    /* second part of Bills algorithm. */
+    memcpy(matrix, raw, dirs * matrixSize * sizeof(unsigned int));
+
+    for (unsigned int d = 0; d < dirs; d++)
+      closure(matrix + d*matrixSize, n, matrixStride);
+
+    if (stats) stats->closures++;
+
+  } else if (stats)
+    stats->closuresKept++;
+
+  lastPieces = *pieces;
+
+  for (unsigned int i = 0; i < n; i++) {
+    lastPositions[4*i+0] = searchnode->getX(i);
+    lastPositions[4*i+1] = searchnode->getY(i);
+    lastPositions[4*i+2] = searchnode->getZ(i);
+    lastPositions[4*i+3] = searchnode->getTrans(i);
   }
 }
 
@@ -200,9 +249,9 @@ bool movementAnalysator_c::checkmovement(unsigned int maxPieces, unsigned int ne
   unsigned int nd = nextdir >> 1;
   unsigned int dirs = cache->numDirections();
   bt_assert(nd < dirs);
-  unsigned int rowIdx = (piecenumber-next_pn)*dirs;
-  unsigned int rowIdx2 = piecenumber*dirs;
-  unsigned int rowIdx3 = (piecenumber*next_pn-1)*dirs;
+  unsigned int rowIdx = matrixStride-next_pn;
+  unsigned int rowIdx2 = matrixStride;
+  unsigned int rowIdx3 = matrixStride*next_pn-1;
 
   // the idea here is the following, if we want to move
   // a piece the matrix tells us if we can do that with respect to
@@ -216,7 +265,7 @@ bool movementAnalysator_c::checkmovement(unsigned int maxPieces, unsigned int ne
     do {
 
       finished = true;
-      unsigned int * idx = matrix + nd;
+      unsigned int * idx = matrix + nd*matrixSize;
 
       // go over all pieces
       for (int i = 0; i < next_pn; i++)
@@ -234,7 +283,7 @@ bool movementAnalysator_c::checkmovement(unsigned int maxPieces, unsigned int ne
               // if the requested movement is more than the matrix allows
               // we must also move the new piece
 
-              if (movement[i] > *idx) {  // idx points to matrix[(j+piecenumber*i)*dirs+nd]
+              if (movement[i] > *idx) {  // idx points to matrix[nd*matrixSize + i*matrixStride + j]
                 // count the number of moved pieces, if there are more
                 // than halve, we bail out because it doesn't make sense
                 // to move more than that amount
@@ -250,7 +299,7 @@ bool movementAnalysator_c::checkmovement(unsigned int maxPieces, unsigned int ne
                 finished = false;
               }
             }
-            idx += dirs;
+            idx++;
           }
           // the current piece is now checked, so we don't need to do that again
           check[i] = false;
@@ -268,7 +317,7 @@ bool movementAnalysator_c::checkmovement(unsigned int maxPieces, unsigned int ne
     do {
 
       finished = true;
-      unsigned int * idx = matrix + nd;
+      unsigned int * idx = matrix + nd*matrixSize;
 
       for (int i = 0; i < next_pn; i++)
       {
@@ -276,7 +325,7 @@ bool movementAnalysator_c::checkmovement(unsigned int maxPieces, unsigned int ne
         {
           for (int j = 0; j < next_pn; j++) {
             if ((i != j) && (movement[j] == 0)) {
-              if (movement[i] > *idx) {  // idx should point to matrix[(i + piecenumber * j)*dirs+nr]
+              if (movement[i] > *idx) {  // idx should point to matrix[nd*matrixSize + j*matrixStride + i]
                 moved_pieces++;
                 if (moved_pieces > maxPieces)
                   return false;
@@ -293,7 +342,7 @@ bool movementAnalysator_c::checkmovement(unsigned int maxPieces, unsigned int ne
         }
         else
         {
-          idx += dirs;
+          idx++;
         }
       }
 
@@ -303,10 +352,14 @@ bool movementAnalysator_c::checkmovement(unsigned int maxPieces, unsigned int ne
   return true;
 }
 
-movementAnalysator_c::movementAnalysator_c(const problem_c & problem) :
-  piecenumber(problem.getNumberOfPieces()), maxstep((unsigned int) -1) {
+movementAnalysator_c::movementAnalysator_c(const problem_c & problem, bool poolNodes, movementCache_c * sharedCache) :
+  piecenumber(problem.getNumberOfPieces()), ownCache(!sharedCache), stats(0), maxstep((unsigned int) -1) {
 
-  cache = problem.getPuzzle().getGridType()->getMovementCache(problem);
+  if (sharedCache) {
+    bt_assert(sharedCache->isShared());
+    cache = sharedCache;
+  } else
+    cache = problem.getPuzzle().getGridType()->getMovementCache(problem);
   /* we assert that there must be a cache, otherwise no disassembly
    * analysis is possible anyway and this should not
    * have been called
@@ -315,9 +368,16 @@ movementAnalysator_c::movementAnalysator_c(const problem_c & problem) :
 
   /* allocate the necessary arrays */
   movement = new unsigned int[piecenumber];
+  positions = new int16_t[4*piecenumber];
 
-  matrix = new unsigned int[cache->numDirections() * piecenumber * piecenumber];
-  memset(matrix, 0, cache->numDirections() * piecenumber * piecenumber * sizeof(unsigned int));
+  matrixStride = (piecenumber + 3) & ~3;
+  matrixSize = matrixStride * piecenumber;
+  matrix = new unsigned int[cache->numDirections() * matrixSize];
+  memset(matrix, 0, cache->numDirections() * matrixSize * sizeof(unsigned int));
+  raw = new unsigned int[cache->numDirections() * matrixSize];
+  memset(raw, 0, cache->numDirections() * matrixSize * sizeof(unsigned int));
+  lastPositions = new int[4*piecenumber];
+  memset(lastPositions, 0, 4 * piecenumber * sizeof(int));
 
   /* create the weights array */
   weights = new int[problem.getNumberOfPieces()];
@@ -330,16 +390,25 @@ movementAnalysator_c::movementAnalysator_c(const problem_c & problem) :
   nextstate = -1;
 
   nodes = new countingNodeHash();
+
+  pool = poolNodes ? new nodePool_c() : 0;
 }
 
 movementAnalysator_c::~movementAnalysator_c() {
 
   delete [] movement;
   delete [] matrix;
+  delete [] raw;
+  delete [] lastPositions;
 
-  delete cache;
+  if (ownCache)
+    delete cache;
   delete [] weights;
   delete nodes;
+  delete [] positions;
+
+  // the nodes in the hashtable above might come from the pool
+  delete pool;
 }
 
 static int max(int a, int b) { if (a > b) return a; else return b; }
@@ -384,53 +453,62 @@ disassemblerNode_c * movementAnalysator_c::newNode(unsigned int amount) {
     nd ^= 1;
   }
 
-  disassemblerNode_c * n = new disassemblerNode_c(pieces->size(), searchnode, nd, amount);
-
   /* create a new state with the pieces moved */
   for (unsigned int i = 0; i < pieces->size(); i++) {
 
     if (movement[i]) {
 
-      if (movement[i] >= 10000) {
+      int mx, my, mz;
 
-        int mx, my, mz;
+      cache->getDirection(nd >> 1, &mx, &my, &mz);
 
-        cache->getDirection(nd >> 1, &mx, &my, &mz);
+      if (movement[i] < 10000) {
+        mx *= movement[i];
+        my *= movement[i];
+        mz *= movement[i];
+      }
 
-        if (nd & 1) {
-          mx = -mx;
-          my = -my;
-          mz = -mz;
-        }
+      if (nd & 1) {
+        mx = -mx;
+        my = -my;
+        mz = -mz;
+      }
 
-        n->setRemove(i, mx, my, mz);
+      if (movement[i] >= 10000) {
 
-      } else {
+        // removed pieces contain the direction they were removed in
+        bt_assert(abs(mx) < 32767 && abs(my) < 32767 && abs(mz) < 32767);
 
-        int mx, my, mz;
+        positions[4*i+0] = mx;
+        positions[4*i+1] = my;
+        positions[4*i+2] = mz;
+        positions[4*i+3] = (int16_t)0xFFFF;
 
-        cache->getDirection(nd >> 1, &mx, &my, &mz);
+        continue;
+      }
 
-        mx *= movement[i];
-        my *= movement[i];
-        mz *= movement[i];
+      mx += searchnode->getX(i);
+      my += searchnode->getY(i);
+      mz += searchnode->getZ(i);
 
-        if (nd & 1) {
-          mx = -mx;
-          my = -my;
-          mz = -mz;
-        }
+      bt_assert(abs(mx) < 32767 && abs(my) < 32767 && abs(mz) < 32767);
 
-        n->set(i, mx, my, mz);
-      }
+      positions[4*i+0] = mx;
+      positions[4*i+1] = my;
+      positions[4*i+2] = mz;
 
     } else {
 
-      n->set(i, 0, 0, 0);
-
+      positions[4*i+0] = searchnode->getX(i);
+      positions[4*i+1] = searchnode->getY(i);
+      positions[4*i+2] = searchnode->getZ(i);
     }
+
+    positions[4*i+3] = searchnode->getTrans(i);
   }
 
+  disassemblerNode_c * n = disassemblerNode_c::create(pool, pieces->size(), searchnode, nd, amount, positions);
+
   return n;
 }
 
@@ -524,6 +602,33 @@ void movementAnalysator_c::init_find(disassemblerNode_c * nd, const std::vector<
   prepare();
 }
 
+bool movementAnalysator_c::interlocked(disassemblerNode_c * nd, const std::vector<unsigned int> & pcs) {
+
+  searchnode = nd;
+  pieces = &pcs;
+
+  prepare();
+
+  /* after the closure a group of pieces can move, when all its pieces can move
+   * relative to all other pieces, so a single non zero value is enough
+   * for a possible move. The negative directions are the transposed
+   * matrices, they contain the same values
+   */
+  unsigned int n = pcs.size();
+
+  for (unsigned int d = 0; d < cache->numDirections(); d++)
+    for (unsigned int j = 0; j < n; j++) {
+
+      const unsigned int * row = matrix + d*matrixSize + j*matrixStride;
+
+      for (unsigned int i = 0; i < n; i++)
+        if (row[i])
+          return false;
+    }
+
+  return true;
+}
+
 /* at first we check if movement is possible at all in the current direction, if so
  * the next thing to do is to check if something can be removed, and finally we look for longer
  * movements in the actual direction
@@ -23,11 +23,15 @@
 
 #include <vector>
 
+#include <stdint.h>
+
 class problem_c;
 class disassemblerNode_c;
 class movementCache_c;
 class assembly_c;
 class countingNodeHash;
+class nodePool_c;
+class disassemblerStats_c;
 
 /**
  * this class is can do analysis of movements within a puzzle.
@@ -48,16 +52,42 @@ class movementAnalysator_c {
      * the matrix for the negative direction in the same direction is the
      * transposition (m[i][j] == m[j][i]) we save the calculation or copying
      * and rather do the transposition inside the checkmovement function
+     *
+     * The matrices of the directions follow one another, each one is matrixSize
+     * values big, the rows of a matrix are matrixStride values apart, that is
+     * the number of pieces rounded up to a multiple of 4
      */
     unsigned int * matrix;
+    unsigned int matrixStride;
+    unsigned int matrixSize;
+
+    /* the matrix before the closure together with the pieces and their positions
+     * and orientations of the node it was calculated for, prepare only updates
+     * the values that change
+     */
+    unsigned int * raw;
+    std::vector<unsigned int> lastPieces;
+    int * lastPositions;
     unsigned int * movement;
     int * weights;
     unsigned int piecenumber;
 
     movementCache_c * cache;
 
+    /** true, when the cache belongs to this analyser */
+    bool ownCache;
+
     countingNodeHash * nodes;
 
+    /** where the movement cache lookups and closures are counted, may be 0 */
+    disassemblerStats_c * stats;
+
+    /* the pool for the new nodes, or 0 when they come from the heap, and
+     * the positions of the node that is created in newNode
+     */
+    nodePool_c * pool;
+    int16_t * positions;
+
     /* these variables are used for the routine that looks
      * for the pieces to move find, checkmovement
      */
@@ -79,8 +109,14 @@ class movementAnalysator_c {
      * construct the analyser for this concrete problem.
      * This can not be changed, once you done that but you can analyse
      * many positions
+     *
+     * When poolNodes is true, the nodes are taken from a pool that belongs
+     * to the analyser, so they all must be freed before the analyser is destroyed
+     *
+     * When a cache is given, the analyser uses that one instead of creating
+     * its own, the cache must be shared and live longer than the analyser
      */
-    movementAnalysator_c(const problem_c & puz);
+    movementAnalysator_c(const problem_c & puz, bool poolNodes = false, movementCache_c * sharedCache = 0);
     ~movementAnalysator_c(void);
 
     /* you use either the 2 functions below, or completeFind
@@ -93,6 +129,14 @@ class movementAnalysator_c {
     void init_find(disassemblerNode_c * nd, const std::vector<unsigned int> & pieces);
     disassemblerNode_c * find(void);
 
+    /**
+     * returns true, when no piece and no group of pieces of the node can move
+     * at all. That is the case when the movement matrices have nothing but
+     * zeros, and then find would not return any node. This only needs the matrices,
+     * so it is a lot cheaper than starting a search to find out that there is no move
+     */
+    bool interlocked(disassemblerNode_c * nd, const std::vector<unsigned int> & pieces);
+
     void completeFind(disassemblerNode_c * searchnode, const std::vector<unsigned int> & pieces, std::vector<disassemblerNode_c*> * result);
 
     /**
@@ -103,6 +147,12 @@ class movementAnalysator_c {
      */
     disassemblerNode_c * findMatching(disassemblerNode_c * nd, const std::vector<unsigned int> & pcs, unsigned int piece, int dx, int dy, int dz);
 
+    /** the movement cache used by this analyser */
+    movementCache_c * getCache(void) { return cache; }
+
+    /** count the movement cache lookups and the closures into s, 0 to not count anything */
+    void setStats(disassemblerStats_c * s) { stats = s; }
+
   private:
 
     // no copying and assigning
@@ -21,11 +21,31 @@
 #include "movementcache.h"
 
 #include "voxel.h"
+#include "voxelrows.h"
 #include "problem.h"
 #include "puzzle.h"
+#include "shapecache.h"
+#include "assembly.h"
+#include "executor.h"
+#include "disassemblerstats.h"
 
+#include <stdio.h>
 #include <string.h>
 
+#ifndef WIN32
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#endif
+
+#include <new>
+#include <vector>
+
+/* number of buckets of the table for the new values of a shared cache, it
+ * can not grow, so it is big
+ */
+static const unsigned int sharedTableSize = 1 << 16;
+
 /* the hash function. I don't know how well it performs, but it seems to be okay */
 static unsigned int moHashValue(unsigned int s1, unsigned int s2, int dx, int dy, int dz, unsigned char t1, unsigned char t2) {
   unsigned int val = dx * 0x10101010;
@@ -72,7 +92,12 @@ void movementCache_c::moRehash(void) {
   moHash = newHash;
 }
 
-movementCache_c::movementCache_c(const problem_c & puzzle) : gt(puzzle.getPuzzle().getGridType()) {
+movementCache_c::movementCache_c(const problem_c & puzzle) :
+  shared(false), flatTable(0), flatSize(0), flatEntries(0), sharedHash(0), sharedEntries(0),
+  shapeCache(puzzle.getPuzzle().getShapeCache()), gt(puzzle.getPuzzle().getGridType()) {
+
+  // the shapes are kept until the cache is destroyed
+  shapeCache.addUser();
 
   /* initial table */
   moTableSize = 101;
@@ -81,18 +106,27 @@ movementCache_c::movementCache_c(const problem_c & puzzle) : gt(puzzle.getPuzzle
   moEntries = 0;
 
   /* Initialise the shape array with the shapes from the
-   * puzzle problem. The shape with transformation 0 is just
-   * a pointer into the puzzle, so don't delete them later on
+   * puzzle problem. All shapes belong to the puzzle, so don't
+   * delete them later on
    */
   num_shapes = puzzle.getNumberOfParts();
 
   num_transformations = puzzle.getPuzzle().getGridType()->getSymmetries()->getNumTransformations();
 
+  shapeIds = new unsigned int [num_shapes];
+
   shapes = new const voxel_c ** [num_shapes];
   for (unsigned int s = 0; s < num_shapes; s++) {
     shapes[s] = new const voxel_c * [num_transformations];
     memset(shapes[s], 0, num_transformations * sizeof(voxel_c*));
     shapes[s][0] = puzzle.getPartShape(s);
+    shapeIds[s] = puzzle.getShapeIdOfPart(s);
+  }
+
+  rows = new const voxelRows_c ** [num_shapes];
+  for (unsigned int s = 0; s < num_shapes; s++) {
+    rows[s] = new const voxelRows_c * [num_transformations];
+    memset(rows[s], 0, num_transformations * sizeof(voxelRows_c*));
   }
 
   /* Initialise the piece array */
@@ -104,6 +138,36 @@ movementCache_c::movementCache_c(const problem_c & puzzle) : gt(puzzle.getPuzzle
     for (unsigned int i = 0; i < puzzle.getPartMaximum(s); i++)
       pieces[pos++] = s;
 
+  /* the key for saved values, a FNV-1a hash over the grid and the shapes,
+   * the colours of the voxels don't matter for the movement
+   */
+  shapeKey = 0xcbf29ce484222325ULL;
+
+  std::vector<int> keyData;
+
+  keyData.push_back(gt->getType());
+  keyData.push_back(num_shapes);
+  keyData.push_back(num_transformations);
+
+  for (unsigned int s = 0; s < num_shapes; s++) {
+
+    const voxel_c * v = shapes[s][0];
+
+    keyData.push_back(v->getX());
+    keyData.push_back(v->getY());
+    keyData.push_back(v->getZ());
+    keyData.push_back(v->getHx());
+    keyData.push_back(v->getHy());
+    keyData.push_back(v->getHz());
+
+    for (unsigned int i = 0; i < v->getXYZ(); i++)
+      keyData.push_back(v->getState(i));
+  }
+
+  for (unsigned int i = 0; i < keyData.size(); i++) {
+    shapeKey ^= (uint32_t)keyData[i];
+    shapeKey *= 0x100000001b3ULL;
+  }
 }
 
 movementCache_c::~movementCache_c() {
@@ -121,19 +185,40 @@ movementCache_c::~movementCache_c() {
   }
   delete [] moHash;
 
-  /* the shape with transformation 0 is just
-   * a pointer into the puzzle, so don't delete them
-   *
-   * but all the others are created by us, so we free them
+  for (unsigned int i = 0; i < flatSize; i++)
+    if (flatTable[i]) {
+      delete [] flatTable[i]->move;
+      delete flatTable[i];
+    }
+  delete [] flatTable;
+
+  if (sharedHash) {
+    for (unsigned int i = 0; i < sharedTableSize; i++) {
+      moEntry * e = sharedHash[i];
+      while (e) {
+        moEntry * n = e->next;
+        delete [] e->move;
+        delete e;
+        e = n;
+      }
+    }
+    delete [] sharedHash;
+  }
+
+  /* the shapes belong to the shape cache of the puzzle, so only the
+   * arrays are freed, but the rows are ours
    */
   for (unsigned int s = 0; s < num_shapes; s++) {
-    for (unsigned int t = 1; t < num_transformations; t++)
-      if (shapes[s][t])
-        delete shapes[s][t];
     delete [] shapes[s];
+
+    for (unsigned int t = 0; t < num_transformations; t++)
+      delete rows[s][t];
+    delete [] rows[s];
   }
 
   delete [] shapes;
+  delete [] shapeIds;
+  delete [] rows;
   delete [] pieces;
 }
 
@@ -141,24 +226,32 @@ const voxel_c * movementCache_c::getTransformedShape(unsigned int s, unsigned ch
 
   if (!shapes[s][t])
   {
-    // our required orientation doesn't exist, so we calculate it
-
-    voxel_c * sh = gt->getVoxel(shapes[s][0]);
-    bt_assert2(sh->transform(t));
-
-    // in the single threaded case simply enter our new shape
-    shapes[s][t] = sh;
+    // our required orientation is not yet known, so we get it from the puzzle
+    shapes[s][t] = shapeCache.getShape(shapeIds[s], t);
+    bt_assert(shapes[s][t]);
   }
 
+  if (!rows[s][t])
+    rows[s][t] = new voxelRows_c(shapes[s][t]);
+
   return shapes[s][t];
 }
 
-void movementCache_c::getMoValue(int dx, int dy, int dz, unsigned char t1, unsigned char t2, unsigned int p1, unsigned int p2, unsigned int * movements)
+void movementCache_c::getMoValue(int dx, int dy, int dz, unsigned char t1, unsigned char t2, unsigned int p1, unsigned int p2, unsigned int * movements,
+                                 disassemblerStats_c * stats)
 {
   /* find out the shapes that the pieces have */
   unsigned int s1 = pieces[p1];
   unsigned int s2 = pieces[p2];
 
+  if (shared) {
+    memcpy(movements, getSharedValue(s1, s2, dx, dy, dz, t1, t2, stats), numDirections()*sizeof(unsigned int));
+    return;
+  }
+
+  if (stats)
+    stats->cacheLookups++;
+
   unsigned int h = moHashValue(s1, s2, dx, dy, dz, t1, t2);
 
   moEntry * e = moHash[h % moTableSize];
@@ -176,7 +269,19 @@ void movementCache_c::getMoValue(int dx, int dy, int dz, unsigned char t1, unsig
     e->dx = dx; e->dy = dy; e->dz = dz;
     e->t1 = t1; e->t2 = t2;
     e->s1 = s1; e->s2 = s2;
-    e->move = moCalcValues(getTransformedShape(s1, t1), getTransformedShape(s2, t2), dx, dy, dz);
+
+    // the rows are created together with the shapes, so the shapes must be there first
+    const voxel_c * sh1 = getTransformedShape(s1, t1);
+    const voxel_c * sh2 = getTransformedShape(s2, t2);
+
+    uint64_t start = stats ? disassemblerStats_c::now() : 0;
+
+    e->move = moCalcValues(sh1, sh2, rows[s1][t1], rows[s2][t2], dx, dy, dz);
+
+    if (stats) {
+      stats->cacheMisses++;
+      stats->cacheTime += disassemblerStats_c::now() - start;
+    }
 
     if (++moEntries > moTableSize) moRehash();
 
@@ -187,3 +292,469 @@ void movementCache_c::getMoValue(int dx, int dy, int dz, unsigned char t1, unsig
   /* return the values */
   memcpy(movements, e->move, numDirections()*sizeof(unsigned int));
 }
+
+/* the hash values are used with a power of 2 table size in the flat
+ * table, so the bits need to be mixed
+ */
+static unsigned int flatSlot(unsigned int h, unsigned int size) {
+
+  h ^= h >> 16;
+  h *= 0x85ebca6b;
+  h ^= h >> 13;
+  h *= 0xc2b2ae35;
+  h ^= h >> 16;
+
+  return h & (size-1);
+}
+
+void movementCache_c::rebuildFlatTable(void) {
+
+  unsigned int entries = flatEntries + moEntries + sharedEntries;
+
+  unsigned int size = 1024;
+  while (size < 2*entries)
+    size *= 2;
+
+  moEntry ** tab = new moEntry * [size];
+  memset(tab, 0, size * sizeof(moEntry*));
+
+  std::vector<moEntry *> all;
+  all.reserve(entries);
+
+  for (unsigned int i = 0; i < flatSize; i++)
+    if (flatTable[i])
+      all.push_back(flatTable[i]);
+
+  for (unsigned int i = 0; i < moTableSize; i++) {
+    for (moEntry * e = moHash[i]; e; e = e->next)
+      all.push_back(e);
+    moHash[i] = 0;
+  }
+
+  for (unsigned int i = 0; i < sharedTableSize; i++) {
+    for (moEntry * e = sharedHash[i]; e; e = e->next)
+      all.push_back(e);
+    sharedHash[i] = 0;
+  }
+
+  for (unsigned int i = 0; i < all.size(); i++) {
+
+    moEntry * e = all[i];
+    unsigned int j = flatSlot(moHashValue(e->s1, e->s2, e->dx, e->dy, e->dz, e->t1, e->t2), size);
+
+    while (tab[j])
+      j = (j+1) & (size-1);
+
+    e->next = 0;
+    tab[j] = e;
+  }
+
+  delete [] flatTable;
+
+  flatTable = tab;
+  flatSize = size;
+  flatEntries = all.size();
+  moEntries = 0;
+  sharedEntries = 0;
+}
+
+const unsigned int * movementCache_c::getSharedValue(unsigned int s1, unsigned int s2, int dx, int dy, int dz, unsigned char t1, unsigned char t2,
+                                                     disassemblerStats_c * stats) {
+
+  if (stats)
+    stats->cacheLookups++;
+
+  unsigned int h = moHashValue(s1, s2, dx, dy, dz, t1, t2);
+
+  for (unsigned int i = flatSlot(h, flatSize); flatTable[i]; i = (i+1) & (flatSize-1)) {
+
+    const moEntry * e = flatTable[i];
+
+    if (e->dx == dx && e->dy == dy && e->dz == dz &&
+        e->t1 == t1 && e->t2 == t2 && e->s1 == s1 && e->s2 == s2)
+      return e->move;
+  }
+
+  /* not in the flat table, look into the table of new values. Entries are only added
+   * at the front of the lists and never removed, so the lists can be read while others
+   * add entries
+   */
+  h &= sharedTableSize-1;
+
+  moEntry * head = sharedHash[h];
+
+  for (moEntry * e = head; e; e = e->next)
+    if (e->dx == dx && e->dy == dy && e->dz == dz &&
+        e->t1 == t1 && e->t2 == t2 && e->s1 == s1 && e->s2 == s2)
+      return e->move;
+
+  moEntry * n = new moEntry;
+  n->dx = dx; n->dy = dy; n->dz = dz;
+  n->t1 = t1; n->t2 = t2;
+  n->s1 = s1; n->s2 = s2;
+
+  uint64_t start = stats ? disassemblerStats_c::now() : 0;
+
+  n->move = moCalcValues(shapes[s1][t1], shapes[s2][t2], rows[s1][t1], rows[s2][t2], dx, dy, dz);
+
+  if (stats) {
+    stats->cacheMisses++;
+    stats->cacheTime += disassemblerStats_c::now() - start;
+  }
+
+#ifndef NO_THREADING
+  while (true) {
+
+    moEntry * oldHead = head;
+
+    n->next = head;
+
+    if (sharedHash[h].compare_exchange_weak(head, n)) {
+      sharedEntries++;
+      return n->move;
+    }
+
+    /* somebody else added entries in the meantime, when one of them
+     * has the values we calculated, that one is used
+     */
+    for (moEntry * e = head; e != oldHead; e = e->next)
+      if (e->dx == dx && e->dy == dy && e->dz == dz &&
+          e->t1 == t1 && e->t2 == t2 && e->s1 == s1 && e->s2 == s2) {
+        delete [] n->move;
+        delete n;
+        return e->move;
+      }
+  }
+#else
+  n->next = head;
+  sharedHash[h] = n;
+  sharedEntries++;
+  return n->move;
+#endif
+}
+
+/* calculates the values for some of the pairs of pieces of the assembled position */
+class moPrecomputeTask_c : public task_c {
+
+  private:
+
+    movementCache_c * cache;
+    const assembly_c * assm;
+    const std::vector<unsigned int> & placed;
+    unsigned int first, step;
+
+  public:
+
+    /** an assert or a failed allocation within the task is passed on to the thread waiting for it */
+    bool asserted;
+    assert_exception ae;
+    bool outOfMemory;
+
+    moPrecomputeTask_c(movementCache_c * c, const assembly_c * a, const std::vector<unsigned int> & p, unsigned int f, unsigned int s) :
+      cache(c), assm(a), placed(p), first(f), step(s), asserted(false), outOfMemory(false) {}
+
+  protected:
+
+    void run(void) {
+
+      try {
+
+        unsigned int n = placed.size();
+
+        for (unsigned int k = first; k < n*n; k += step) {
+
+          unsigned int i = placed[k / n];
+          unsigned int j = placed[k % n];
+
+          if (i == j) continue;
+
+          // the same values as the movement analysis requests for the assembled position
+          cache->getSharedValue(cache->pieces[i], cache->pieces[j],
+              assm->getX(j) - assm->getX(i), assm->getY(j) - assm->getY(i), assm->getZ(j) - assm->getZ(i),
+              assm->getTransformation(i), assm->getTransformation(j), 0);
+        }
+      }
+
+      catch (assert_exception & a) {
+        ae = a;
+        asserted = true;
+      }
+
+      catch (std::bad_alloc &) {
+        outOfMemory = true;
+      }
+    }
+};
+
+void movementCache_c::precompute(const assembly_c * assm) {
+
+  if (!shared) {
+
+    /* all transformed shapes are needed now, later on the shapes must
+     * not be changed any more because other threads might use them
+     */
+    for (unsigned int s = 0; s < num_shapes; s++)
+      for (unsigned int t = 0; t < num_transformations; t++)
+        getTransformedShape(s, t);
+
+#ifndef NO_THREADING
+    sharedHash = new boost::atomic<moEntry *>[sharedTableSize];
+    for (unsigned int i = 0; i < sharedTableSize; i++)
+      sharedHash[i] = 0;
+#else
+    sharedHash = new moEntry * [sharedTableSize];
+    memset(sharedHash, 0, sharedTableSize * sizeof(moEntry*));
+#endif
+
+    shared = true;
+    rebuildFlatTable();
+
+  } else if (4*sharedEntries > flatEntries) {
+
+    /* the table of new values has grown, the flat table is faster, the flat table
+     * grows by at least a quarter each time, so all values are moved only a few times
+     */
+    rebuildFlatTable();
+  }
+
+  std::vector<unsigned int> placed;
+
+  for (unsigned int j = 0; j < assm->placementCount(); j++)
+    if (assm->isPlaced(j))
+      placed.push_back(j);
+
+  unsigned int tasks = executor_c::instance().size();
+  if (tasks > placed.size())
+    tasks = placed.size();
+
+  std::vector<moPrecomputeTask_c *> t;
+
+  for (unsigned int i = 0; i < tasks; i++) {
+    t.push_back(new moPrecomputeTask_c(this, assm, placed, i, tasks));
+    executor_c::instance().submit(t[i]);
+  }
+
+  bool asserted = false;
+  bool outOfMemory = false;
+  assert_exception ae;
+
+  for (unsigned int i = 0; i < tasks; i++) {
+
+    executor_c::instance().wait(t[i]);
+
+    if (t[i]->asserted && !asserted) {
+      asserted = true;
+      ae = t[i]->ae;
+    }
+
+    outOfMemory |= t[i]->outOfMemory;
+
+    delete t[i];
+  }
+
+  if (asserted)
+    throw ae;
+
+  if (outOfMemory)
+    throw std::bad_alloc();
+}
+
+/* the saved values start with this header, followed by the entries */
+struct moFileHeader {
+  char magic[4];
+  uint32_t version;
+  uint64_t key;
+  uint32_t directions;
+  uint32_t entries;
+};
+
+/* one entry of the file, followed by the movement for each direction */
+struct moFileEntry {
+  int32_t dx, dy, dz;
+  uint32_t s1, s2;
+  uint16_t t1, t2;
+};
+
+static const char moFileMagic[4] = { 'B', 'T', 'M', 'C' };
+
+/* increase, when the format or the calculation of the values changes */
+static const uint32_t moFileVersion = 1;
+
+std::string movementCache_c::fileName(const std::string & directory) const {
+
+  char name[40];
+  snprintf(name, sizeof(name), "movement-%016llx.cache", (unsigned long long)shapeKey);
+
+  return directory.empty() ? std::string(name) : directory + "/" + name;
+}
+
+bool movementCache_c::load(const std::string & directory) {
+
+  bt_assert(!shared);
+
+  FILE * f = fopen(fileName(directory).c_str(), "rb");
+
+  if (!f) return false;
+
+  moFileHeader h;
+
+  if (fread(&h, sizeof(h), 1, f) != 1 ||
+      memcmp(h.magic, moFileMagic, sizeof(moFileMagic)) != 0 ||
+      h.version != moFileVersion ||
+      h.key != shapeKey ||
+      h.directions != numDirections()) {
+    fclose(f);
+    return false;
+  }
+
+  unsigned int dirs = numDirections();
+
+  /* the number of entries must match the size of the file, otherwise a
+   * broken header could make us allocate huge amounts of memory
+   */
+  long start = ftell(f);
+  long end = (start >= 0 && fseek(f, 0, SEEK_END) == 0) ? ftell(f) : -1;
+  unsigned long recordSize = sizeof(moFileEntry) + (unsigned long)dirs * sizeof(unsigned int);
+
+  if (end < start || fseek(f, start, SEEK_SET) != 0 ||
+      (unsigned long)(end - start) / recordSize != h.entries ||
+      (unsigned long)(end - start) % recordSize != 0) {
+    fclose(f);
+    return false;
+  }
+
+  /* read everything first, a broken file is not used at all */
+  std::vector<moFileEntry> entries(h.entries);
+  std::vector<unsigned int> moves(h.entries * dirs);
+
+  bool ok = true;
+
+  for (unsigned int i = 0; ok && i < h.entries; i++) {
+
+    moFileEntry & e = entries[i];
+
+    ok = fread(&e, sizeof(e), 1, f) == 1 &&
+         (!dirs || fread(&moves[i*dirs], sizeof(unsigned int), dirs, f) == dirs) &&
+         e.s1 < num_shapes && e.s2 < num_shapes &&
+         e.t1 < num_transformations && e.t2 < num_transformations;
+  }
+
+  fclose(f);
+
+  if (!ok) return false;
+
+  for (unsigned int i = 0; i < entries.size(); i++) {
+
+    const moFileEntry & fe = entries[i];
+
+    unsigned int hv = moHashValue(fe.s1, fe.s2, fe.dx, fe.dy, fe.dz, fe.t1, fe.t2);
+
+    moEntry * e = moHash[hv % moTableSize];
+
+    while (e && (e->dx != fe.dx || e->dy != fe.dy || e->dz != fe.dz ||
+                 e->t1 != fe.t1 || e->t2 != fe.t2 || e->s1 != fe.s1 || e->s2 != fe.s2))
+      e = e->next;
+
+    // the values calculated in this run are kept
+    if (e) continue;
+
+    e = new moEntry;
+    e->dx = fe.dx; e->dy = fe.dy; e->dz = fe.dz;
+    e->t1 = fe.t1; e->t2 = fe.t2;
+    e->s1 = fe.s1; e->s2 = fe.s2;
+    e->move = new unsigned int[dirs];
+    memcpy(e->move, &moves[i*dirs], dirs*sizeof(unsigned int));
+
+    if (++moEntries > moTableSize) moRehash();
+
+    e->next = moHash[hv % moTableSize];
+    moHash[hv % moTableSize] = e;
+  }
+
+  return true;
+}
+
+bool movementCache_c::save(const std::string & directory) {
+
+  std::vector<const moEntry *> all;
+
+  for (unsigned int i = 0; i < moTableSize; i++)
+    for (const moEntry * e = moHash[i]; e; e = e->next)
+      all.push_back(e);
+
+  for (unsigned int i = 0; i < flatSize; i++)
+    if (flatTable[i])
+      all.push_back(flatTable[i]);
+
+  if (sharedHash)
+    for (unsigned int i = 0; i < sharedTableSize; i++)
+      for (const moEntry * e = sharedHash[i]; e; e = e->next)
+        all.push_back(e);
+
+  /* the values are written into a new file that replaces the old one once
+   * it is complete, so that other runs never see a half written file
+   */
+  std::string name = fileName(directory);
+
+#ifndef WIN32
+  std::vector<char> tmpName(name.begin(), name.end());
+  const char * suffix = ".XXXXXX";
+  tmpName.insert(tmpName.end(), suffix, suffix+strlen(suffix)+1);
+
+  int fd = mkstemp(&tmpName[0]);
+
+  // temporary files are only readable by the owner, the cache is not secret
+  if (fd >= 0)
+    fchmod(fd, 0644);
+
+  FILE * f = fd >= 0 ? fdopen(fd, "wb") : 0;
+#else
+  std::string tmpName = name + ".new";
+  FILE * f = fopen(tmpName.c_str(), "wb");
+#endif
+
+  if (!f) return false;
+
+  unsigned int dirs = numDirections();
+
+  moFileHeader h;
+  memcpy(h.magic, moFileMagic, sizeof(moFileMagic));
+  h.version = moFileVersion;
+  h.key = shapeKey;
+  h.directions = dirs;
+  h.entries = all.size();
+
+  bool ok = fwrite(&h, sizeof(h), 1, f) == 1;
+
+  for (unsigned int i = 0; ok && i < all.size(); i++) {
+
+    moFileEntry fe;
+    memset(&fe, 0, sizeof(fe));
+
+    fe.dx = all[i]->dx; fe.dy = all[i]->dy; fe.dz = all[i]->dz;
+    fe.s1 = all[i]->s1; fe.s2 = all[i]->s2;
+    fe.t1 = all[i]->t1; fe.t2 = all[i]->t2;
+
+    ok = fwrite(&fe, sizeof(fe), 1, f) == 1 &&
+         (!dirs || fwrite(all[i]->move, sizeof(unsigned int), dirs, f) == dirs);
+  }
+
+  ok = (fclose(f) == 0) && ok;
+
+#ifndef WIN32
+  ok = ok && rename(&tmpName[0], name.c_str()) == 0;
+
+  if (!ok)
+    unlink(&tmpName[0]);
+#else
+  if (ok) {
+    remove(name.c_str());
+    ok = rename(tmpName.c_str(), name.c_str()) == 0;
+  }
+
+  if (!ok)
+    remove(tmpName.c_str());
+#endif
+
+  return ok;
+}
@@ -21,9 +21,21 @@
 #ifndef __MOVEMENTCACHE_H__
 #define __MOVEMENTCACHE_H__
 
+#ifndef NO_THREADING
+#include <boost/atomic.hpp>
+#endif
+
+#include <stdint.h>
+
+#include <string>
+
 class voxel_c;
+class voxelRows_c;
 class problem_c;
 class gridType_c;
+class shapeCache_c;
+class assembly_c;
+class disassemblerStats_c;
 
 /**
  * Calculates and stores the information required for movement analysis
@@ -40,6 +52,18 @@ class gridType_c;
  * are not inside the table.
  *
  * So only the derived classes do actually calculate something.
+ *
+ * When several threads analyse the same problem they can share one cache.
+ * For that precompute must be called before each assembly is analysed.
+ * It moves all values calculated so far into a flat table that is not changed
+ * until the next call, so it can be read without any locking, and calculates
+ * the values for the assembled position in parallel. Values that are missing
+ * in the flat table are entered into a second hash table that several threads
+ * can extend at the same time without locks.
+ *
+ * The values can be saved into a file and loaded again the next time the
+ * same shapes are analysed. The file is named after a hash of everything the
+ * values depend on, so each set of shapes gets its own file.
  */
 class movementCache_c {
 
@@ -79,13 +103,54 @@ class movementCache_c {
   unsigned int moTableSize; ///< size of the hash table
   unsigned int moEntries;   ///< number of entries in the table
 
+  /** true, when the cache has been prepared to be shared */
+  bool shared;
+
+  /**
+   * the values calculated before the last call to precompute in an open
+   * addressing table. It is not changed while the cache is shared
+   */
+  moEntry ** flatTable;
+  unsigned int flatSize;    ///< size of the flat table, a power of 2
+  unsigned int flatEntries; ///< number of entries in the flat table
+
+  /** the table for new values while the cache is shared */
+#ifndef NO_THREADING
+  boost::atomic<moEntry *> * sharedHash;
+  boost::atomic<unsigned int> sharedEntries;
+#else
+  moEntry ** sharedHash;
+  unsigned int sharedEntries;
+#endif
+
+  /**
+   * return the values from the shared tables, calculating them when necessary,
+   * the lookup is counted in stats, when it is not 0
+   */
+  const unsigned int * getSharedValue(unsigned int s1, unsigned int s2, int dx, int dy, int dz, unsigned char t1, unsigned char t2,
+                                      disassemblerStats_c * stats);
+
+  /** move all values into the flat table */
+  void rebuildFlatTable(void);
+
+  friend class moPrecomputeTask_c;
+
   /**
    * Saves the shapes in all orientations.
-   * The voxel spaces are calculated on demand. The entry at the zero-th position are
-   * pointers into the puzzle, so we must not free them
+   * The voxel spaces are taken from the shape cache of the puzzle on demand, they
+   * belong to that cache, so we must not free them
    */
   const voxel_c *** shapes;
 
+  /** the cache of the puzzle with the transformed shapes */
+  shapeCache_c & shapeCache;
+
+  /** the ids of the shapes within the puzzle */
+  unsigned int * shapeIds;
+
+  /** the shapes as bit rows, they are created together with the shapes */
+  const voxelRows_c *** rows;
+
   /** the mapping of piece numbers to shape ids */
   unsigned int * pieces;
 
@@ -97,15 +162,25 @@ class movementCache_c {
 
   void moRehash(void); ///< this function resizes the hash table to roughly twice the size
 
-  /** when the entry is not inside the table, this function calculates the values for the movement info */
-  virtual unsigned int* moCalcValues(const voxel_c * sh1, const voxel_c * sh2, int dx, int dy, int dz) = 0;
+  /**
+   * when the entry is not inside the table, this function calculates the values for the movement info,
+   * r1 and r2 are the bit rows of the 2 shapes
+   */
+  virtual unsigned int* moCalcValues(const voxel_c * sh1, const voxel_c * sh2,
+                                     const voxelRows_c * r1, const voxelRows_c * r2, int dx, int dy, int dz) = 0;
 
-  /// the gridtype used. We need this to make copies and transformations of the shapes
+  /// the gridtype used
   const gridType_c * gt;
 
-  /// get the transformed shape from the shapes array, calculating missing ones
+  /// get the transformed shape from the shapes array, fetching missing ones from the shape cache
   const voxel_c * getTransformedShape(unsigned int s, unsigned char t);
 
+  /** hash of the grid type and the shapes including their hotspots */
+  uint64_t shapeKey;
+
+  /** the name of the file for the values within directory */
+  std::string fileName(const std::string & directory) const;
+
 public:
 
   /** create the cache. The cache is then fixed to the puzzle and the problem, it can
@@ -121,8 +196,37 @@ public:
    * the 2nd piece is offset by dx, dy and dz relative to the first,
    * the 2 pieces are the pieces p1 and p2 from the puzzle and problem defined in the constructor
    * and the 2 pieces are transformed by t1 and t2
+   *
+   * the lookup and the calculation, when one is necessary, are counted in stats, when it is not 0
+   */
+  void getMoValue(int dx, int dy, int dz, unsigned char t1, unsigned char t2, unsigned int p1, unsigned int p2, unsigned int * movements,
+                  disassemblerStats_c * stats = 0);
+
+  /**
+   * Prepare the cache to be shared between threads for the analysis of the
+   * given assembly, the values for the assembled position are calculated in
+   * parallel.
+   *
+   * This must not be called while other threads use the cache. An exception
+   * within the calculation is thrown once all of it is finished
+   */
+  void precompute(const assembly_c * assm);
+
+  /** true, when the cache can be used by several threads */
+  bool isShared(void) const { return shared; }
+
+  /**
+   * load the values saved into directory by an earlier run for the same shapes.
+   * Returns false, when there is no file or it doesn't fit to the shapes, then
+   * nothing is loaded. This must be called before the cache is shared
+   */
+  bool load(const std::string & directory);
+
+  /**
+   * save all values calculated so far into directory, an existing file
+   * is replaced. Returns false, when the file could not be written
    */
-  void getMoValue(int dx, int dy, int dz, unsigned char t1, unsigned char t2, unsigned int p1, unsigned int p2, unsigned int * movements);
+  bool save(const std::string & directory);
 
   /**
    * return the number of different directions of movement that are possible within
@@ -21,6 +21,7 @@
 #include "movementcache_0.h"
 
 #include "voxel.h"
+#include "voxelrows.h"
 
 #define NUM_DIRECTIONS 3
 
@@ -31,7 +32,8 @@ static int min(int a, int b) { if (a < b) return a; else return b; }
 static int max(int a, int b) { if (a > b) return a; else return b; }
 
 /* calculate the required movement possibilities */
-unsigned int* movementCache_0_c::moCalcValues(const voxel_c * sh1, const voxel_c * sh2, int dx, int dy, int dz) {
+unsigned int* movementCache_0_c::moCalcValues(const voxel_c * sh1, const voxel_c * sh2,
+                                              const voxelRows_c * r1, const voxelRows_c * r2, int dx, int dy, int dz) {
 
   /* because the dx, dy and dz values are calculated using the hotspot we need to reverse
    * that process
@@ -42,6 +44,55 @@ unsigned int* movementCache_0_c::moCalcValues(const voxel_c * sh1, const voxel_c
 
   unsigned int * move = new unsigned int[NUM_DIRECTIONS];
 
+  if (!calcRows(sh1, sh2, r1, r2, dx, dy, dz, move))
+    calcScalar(sh1, sh2, dx, dy, dz, move);
+
+  return move;
+}
+
+/* the gap along an axis is the smallest number of empty voxels between a voxel of
+ * the first piece and a following voxel of the 2nd piece. When the first piece is
+ * moved by gap+1 it overlaps the 2nd piece for the first time. Voxels used by both
+ * pieces count as voxels of the first piece, so they are removed from the 2nd.
+ *
+ * The frame checks all rows at once for each distance, normally the pieces touch so
+ * the check ends after very few distances
+ */
+bool movementCache_0_c::calcRows(const voxel_c * sh1, const voxel_c * sh2, const voxelRows_c * r1, const voxelRows_c * r2,
+                                 int dx, int dy, int dz, unsigned int * move) {
+
+  rowFrame_c frame(sh1, *r1, false, sh2, *r2, dx, dy, dz);
+
+  if (!frame.fits())
+    return false;
+
+  frame.removeOverlap();
+
+  move[0] = move[1] = move[2] = 32000;
+
+  for (int d = 0; d+1 < frame.sizeX(); d++)
+    if (frame.overlap(d+1, 0, 0)) {
+      move[0] = d;
+      break;
+    }
+
+  for (int d = 0; d+1 < frame.sizeY(); d++)
+    if (frame.overlap(0, d+1, 0)) {
+      move[1] = d;
+      break;
+    }
+
+  for (int d = 0; d+1 < frame.sizeZ(); d++)
+    if (frame.overlap(0, 0, d+1)) {
+      move[2] = d;
+      break;
+    }
+
+  return true;
+}
+
+void movementCache_0_c::calcScalar(const voxel_c * sh1, const voxel_c * sh2, int dx, int dy, int dz, unsigned int * move) {
+
   /* calculate some bounding boxes for the intersecting and union boxes of the 2 pieces */
   int x1i, x2i, y1i, y2i, z1i, z2i;
 
@@ -151,8 +202,6 @@ unsigned int* movementCache_0_c::moCalcValues(const voxel_c * sh1, const voxel_c
   move[0] = mx;
   move[1] = my;
   move[2] = mz;
-
-  return move;
 }
 
 
@@ -30,9 +30,23 @@ class movementCache_0_c : public movementCache_c {
 
     movementCache_0_c(const problem_c & puz);
 
+    /**
+     * calculate the movement possibilities voxel by voxel. The 2nd shape is at dx, dy, dz relative
+     * to the first in voxel coordinates, the 3 values are written to move
+     */
+    static void calcScalar(const voxel_c * sh1, const voxel_c * sh2, int dx, int dy, int dz, unsigned int * move);
+
+    /**
+     * the same as calcScalar but using the bit rows of the shapes. Returns false, when the
+     * 2 shapes don't fit into the rows, then nothing is calculated
+     */
+    static bool calcRows(const voxel_c * sh1, const voxel_c * sh2, const voxelRows_c * r1, const voxelRows_c * r2,
+                         int dx, int dy, int dz, unsigned int * move);
+
   private:
 
-    unsigned int* moCalcValues(const voxel_c * sh1, const voxel_c * sh2, int dx, int dy, int dz);
+    unsigned int* moCalcValues(const voxel_c * sh1, const voxel_c * sh2,
+                               const voxelRows_c * r1, const voxelRows_c * r2, int dx, int dy, int dz);
 
     virtual unsigned int numDirections(void);
     virtual void getDirection(unsigned int dir, int * x, int * y, int * z);
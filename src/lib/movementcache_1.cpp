@@ -21,6 +21,7 @@
 #include "movementcache_1.h"
 
 #include "voxel.h"
+#include "voxelrows.h"
 
 #define NUM_DIRECTIONS 4
 #define NUM_CHECKS 3
@@ -66,7 +67,8 @@ movementCache_1_c::movementCache_1_c(const problem_c & puz) : movementCache_c(pu
 }
 
 /* calculate the required movement possibilities */
-unsigned int* movementCache_1_c::moCalcValues(const voxel_c * sh1, const voxel_c * sh2, int dx, int dy, int dz) {
+unsigned int* movementCache_1_c::moCalcValues(const voxel_c * sh1, const voxel_c * sh2,
+                                              const voxelRows_c * r1, const voxelRows_c * r2, int dx, int dy, int dz) {
 
   /* because the dx, dy and dz values are calculated using the hotspot we need to reverse
    * that process
@@ -77,6 +79,50 @@ unsigned int* movementCache_1_c::moCalcValues(const voxel_c * sh1, const voxel_c
 
   unsigned int * move = new unsigned int[NUM_DIRECTIONS];
 
+  if (!calcRows(sh1, sh2, r1, r2, dx, dy, dz, move))
+    calcScalar(sh1, sh2, dx, dy, dz, move);
+
+  return move;
+}
+
+/* the first shape is moved as a whole d steps into a direction, each voxel checks the
+ * voxels given in the checks table for its type. So the movement is blocked after d steps,
+ * when the voxels of one type of the first shape moved by d times the direction plus one
+ * of the check vectors overlap the 2nd shape. The voxel type is the parity of x+y.
+ *
+ * Each of the translations moves at least one coordinate by d, so after the biggest
+ * size of the frame there can be no more overlap
+ */
+bool movementCache_1_c::calcRows(const voxel_c * sh1, const voxel_c * sh2, const voxelRows_c * r1, const voxelRows_c * r2,
+                                 int dx, int dy, int dz, unsigned int * move) {
+
+  rowFrame_c frame(sh1, *r1, true, sh2, *r2, dx, dy, dz);
+
+  if (!frame.fits())
+    return false;
+
+  int maxD = frame.sizeX();
+  if (frame.sizeY() > maxD) maxD = frame.sizeY();
+  if (frame.sizeZ() > maxD) maxD = frame.sizeZ();
+
+  for (unsigned int dir = 0; dir < NUM_DIRECTIONS; dir++) {
+
+    move[dir] = 32000;
+
+    for (int d = 0; d < maxD && move[dir] == 32000; d++)
+      for (int voxel = 0; voxel < NUM_VOXELTYPES; voxel++)
+        for (const int (*ch)[3] = checks[dir][voxel]; (*ch)[0] != -10; ch++)
+          if (frame.overlap(d*dirs[dir][0] + (*ch)[0], d*dirs[dir][1] + (*ch)[1], d*dirs[dir][2] + (*ch)[2], voxel)) {
+            move[dir] = d;
+            break;
+          }
+  }
+
+  return true;
+}
+
+void movementCache_1_c::calcScalar(const voxel_c * sh1, const voxel_c * sh2, int dx, int dy, int dz, unsigned int * move) {
+
   for (unsigned int dir = 0; dir < NUM_DIRECTIONS; dir++) {
 
     unsigned int m = 32000;
@@ -134,8 +180,6 @@ unsigned int* movementCache_1_c::moCalcValues(const voxel_c * sh1, const voxel_c
 
     move[dir] = m;
   }
-
-  return move;
 }
 
 unsigned int movementCache_1_c::numDirections(void) { return NUM_DIRECTIONS; }
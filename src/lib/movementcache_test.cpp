@@ -0,0 +1,99 @@
+/* BurrTools
+ *
+ * BurrTools is the legal property of its developers, whose
+ * names are listed in the COPYRIGHT file, which is included
+ * within the source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+#include "movementcache_0.h"
+#include "movementcache_1.h"
+#include "voxelrows.h"
+#include "voxel_0.h"
+#include "voxel_1.h"
+#include "gridtype.h"
+#include <boost/test/unit_test.hpp>
+
+#include <stdlib.h>
+
+/* fill a voxel space randomly, some voxels are variable */
+static void randomShape(voxel_c & v) {
+
+  for (unsigned int i = 0; i < v.getXYZ(); i++)
+    switch (rand() % 7) {
+      case 0: case 1: v.setState(i, voxel_c::VX_FILLED); break;
+      case 2: v.setState(i, voxel_c::VX_VARIABLE); break;
+      default: v.setState(i, voxel_c::VX_EMPTY); break;
+    }
+}
+
+BOOST_AUTO_TEST_CASE( movementcache_rows_test )
+{
+  gridType_c gt0(gridType_c::GT_BRICKS);
+  gridType_c gt1(gridType_c::GT_TRIANGULAR_PRISM);
+
+  srand(1);
+
+  for (unsigned int i = 0; i < 500; i++) {
+
+    voxel_0_c a0(1 + rand() % 6, 1 + rand() % 6, 1 + rand() % 6, &gt0);
+    voxel_0_c b0(1 + rand() % 6, 1 + rand() % 6, 1 + rand() % 6, &gt0);
+    voxel_1_c a1(1 + rand() % 6, 1 + rand() % 6, 1 + rand() % 6, &gt1);
+    voxel_1_c b1(1 + rand() % 6, 1 + rand() % 6, 1 + rand() % 6, &gt1);
+
+    randomShape(a0); randomShape(b0);
+    randomShape(a1); randomShape(b1);
+
+    voxelRows_c ra0(&a0), rb0(&b0), ra1(&a1), rb1(&b1);
+
+    for (unsigned int j = 0; j < 20; j++) {
+
+      int dx = rand() % 15 - 7;
+      int dy = rand() % 15 - 7;
+      int dz = rand() % 15 - 7;
+
+      unsigned int s[4], r[4];
+
+      movementCache_0_c::calcScalar(&a0, &b0, dx, dy, dz, s);
+      BOOST_CHECK( movementCache_0_c::calcRows(&a0, &b0, &ra0, &rb0, dx, dy, dz, r) );
+      BOOST_CHECK( s[0] == r[0] && s[1] == r[1] && s[2] == r[2] );
+
+      /* the scalar path asserts that the shapes don't overlap */
+      bool overlap = false;
+      for (unsigned int x = 0; x < a1.getX(); x++)
+        for (unsigned int y = 0; y < a1.getY(); y++)
+          for (unsigned int z = 0; z < a1.getZ(); z++)
+            if (!a1.isEmpty(x, y, z) && !b1.isEmpty2(x-dx, y-dy, z-dz))
+              overlap = true;
+
+      if (overlap) continue;
+
+      movementCache_1_c::calcScalar(&a1, &b1, dx, dy, dz, s);
+      BOOST_CHECK( movementCache_1_c::calcRows(&a1, &b1, &ra1, &rb1, dx, dy, dz, r) );
+      BOOST_CHECK( s[0] == r[0] && s[1] == r[1] && s[2] == r[2] && s[3] == r[3] );
+    }
+  }
+
+  // shapes wider than the rows are left to the scalar path
+  voxel_0_c w(70, 1, 1, &gt0);
+  w.setState(0, 0, 0, voxel_c::VX_FILLED);
+  w.setState(69, 0, 0, voxel_c::VX_FILLED);
+
+  voxelRows_c rw(&w);
+  unsigned int r[3];
+
+  BOOST_CHECK( !rw.fits() );
+  BOOST_CHECK( !movementCache_0_c::calcRows(&w, &w, &rw, &rw, 0, 1, 0, r) );
+}
@@ -94,7 +94,7 @@ static void print_rec(const separation_c * s, voxel_c ** pieces, int sx, int sy,
 
   for (unsigned int i = 0; i <= s->getMoves(); i++) {
 
-    const state_c * st = s->getState(i);
+    const state_c st = s->getState(i);
 
     for (int z = -sz/2; z < sz+sz/2; z++) {
       printf(" +");
@@ -111,9 +111,9 @@ static void print_rec(const separation_c * s, voxel_c ** pieces, int sx, int sy,
           char c = ' ';
 
           for (unsigned int pc = 0; pc < s->getPieceNumber(); pc++)
-            if (pieces[pc]->isFilled2(x - (st->getX(pc) - pieces[pc]->getHx()),
-                                      y - (st->getY(pc) - pieces[pc]->getHy()),
-                                      z - (st->getZ(pc) - pieces[pc]->getHz()))) {
+            if (pieces[pc]->isFilled2(x - (st.getX(pc) - pieces[pc]->getHx()),
+                                      y - (st.getY(pc) - pieces[pc]->getHy()),
+                                      z - (st.getZ(pc) - pieces[pc]->getHz()))) {
               c = 'a' + pieceNum[pc];
               break;
             }
@@ -140,10 +140,11 @@ static void print_rec(const separation_c * s, voxel_c ** pieces, int sx, int sy,
   if (s->getRemoved()) {
 
     unsigned int * pieceNum2 = new unsigned int [s->getPieceNumber()];
+    const state_c last = s->getState(s->getMoves());
 
     int pos = 0;
     for (unsigned int i = 0; i < s->getPieceNumber(); i++)
-      if (s->getState(s->getMoves())->pieceRemoved(i))
+      if (last.pieceRemoved(i))
         pieceNum2[pos++] = pieceNum[i];
 
     print_rec(s->getRemoved(), pieces, sx, sy, sz, pieceNum2);
@@ -153,10 +154,11 @@ static void print_rec(const separation_c * s, voxel_c ** pieces, int sx, int sy,
   if (s->getLeft()) {
 
     unsigned int * pieceNum2 = new unsigned int [s->getPieceNumber()];
+    const state_c last = s->getState(s->getMoves());
 
     int pos = 0;
     for (unsigned int i = 0; i < s->getPieceNumber(); i++)
-      if (!(s->getState(s->getMoves())->pieceRemoved(i)))
+      if (!(last.pieceRemoved(i)))
         pieceNum2[pos++] = pieceNum[i];
 
     print_rec(s->getLeft(), pieces, sx, sy, sz, pieceNum2);
@@ -22,6 +22,9 @@
 
 #include "problem.h"
 #include "voxel.h"
+#include "gridtype.h"
+#include "symmetries.h"
+#include "shapecache.h"
 
 #include "../tools/xml.h"
 
@@ -88,13 +91,15 @@
  *
  */
 
-puzzle_c::puzzle_c(const puzzle_c * orig) {
+puzzle_c::puzzle_c(const puzzle_c * orig) : shapeCache(new shapeCache_c(*this)) {
 
   gt = new gridType_c(*orig->gt);
 
   for (unsigned int i = 0; i < orig->shapes.size(); i++)
     shapes.push_back(gt->getVoxel(orig->shapes[i]));
 
+  shapeCache->shapesChanged();
+
   for (unsigned int i = 0; i < orig->problems.size(); i++)
     problems.push_back(new problem_c(orig->problems[i], *this));
 
@@ -105,8 +110,13 @@ puzzle_c::puzzle_c(const puzzle_c * orig) {
   commentPopup = orig->commentPopup;
 }
 
+puzzle_c::puzzle_c(gridType_c * g) : gt(g), commentPopup(false), shapeCache(new shapeCache_c(*this)) {
+}
+
 puzzle_c::~puzzle_c(void) {
 
+  delete shapeCache;
+
   for (unsigned int i = 0; i < shapes.size(); i++)
     delete shapes[i];
 
@@ -116,6 +126,23 @@ puzzle_c::~puzzle_c(void) {
   delete gt;
 }
 
+void puzzle_c::prepareSharedCaches(void) const {
+
+  const symmetries_c * sym = gt->getSymmetries();
+
+  for (unsigned int i = 0; i < shapes.size(); i++) {
+
+    shapes[i]->selfSymmetries();
+
+    int x, y, z;
+
+    for (unsigned int t = 0; t < sym->getNumTransformationsMirror(); t++) {
+      shapes[i]->getHotspot(t, &x, &y, &z);
+      shapes[i]->getBoundingBox(t, &x, &y, &z);
+    }
+  }
+}
+
 unsigned int puzzle_c::addColor(unsigned char r, unsigned char g, unsigned char b) {
   bt_assert(colors.size() < 63);  // only 63 colours are allowed, colour 0 is special
   colors.push_back(r | (uint32_t)g << 8 | (uint32_t)b << 16);
@@ -127,7 +154,10 @@ void puzzle_c::removeColor(unsigned int col) {
   bt_assert(col <= colors.size());
 
   // go through all shapes and remove the deleted colour
-  for (unsigned int i = 0; i < shapes.size(); i++)
+  for (unsigned int i = 0; i < shapes.size(); i++) {
+
+    voxelEdit_c edit(*shapes[i]);
+
     for (unsigned int p = 0; p < shapes[i]->getXYZ(); p++)
       if (shapes[i]->getState(p) != voxel_c::VX_EMPTY) {
         if (shapes[i]->getColor(p) == col)
@@ -135,6 +165,7 @@ void puzzle_c::removeColor(unsigned int col) {
         else if (shapes[i]->getColor(p) > col)
           shapes[i]->setColor(p, shapes[i]->getColor(p)-1);
       }
+  }
 
   // remove colour constraint rules that include this colour
   for (unsigned int i = 0; i < problems.size(); i++) {
@@ -220,7 +251,7 @@ void puzzle_c::save(xmlWriter_c & xml) const
   xml.endTag("puzzle");
 }
 
-puzzle_c::puzzle_c(xmlParser_c & pars)
+puzzle_c::puzzle_c(xmlParser_c & pars) : shapeCache(new shapeCache_c(*this))
 {
   pars.nextTag();
 
@@ -297,6 +328,8 @@ puzzle_c::puzzle_c(xmlParser_c & pars)
       } while (true);
 
       pars.require(xmlParser_c::END_TAG, "shapes");
+
+      shapeCache->shapesChanged();
     }
     else if (pars.getName() == "problems")
     {
@@ -348,12 +381,14 @@ puzzle_c::puzzle_c(xmlParser_c & pars)
 unsigned int puzzle_c::addShape(voxel_c * p) {
   bt_assert(gt->getType() == p->getGridType()->getType());
   shapes.push_back(p);
+  shapeCache->shapesChanged();
   return shapes.size()-1;
 }
 
 /* add empty shape of given size */
 unsigned int puzzle_c::addShape(unsigned int sx, unsigned int sy, unsigned int sz) {
   shapes.push_back(gt->getVoxel(sx, sy, sz, voxel_c::VX_EMPTY));
+  shapeCache->shapesChanged();
   return shapes.size()-1;
 }
 
@@ -371,6 +406,7 @@ void puzzle_c::removeShape(unsigned int idx) {
   delete shapes[idx];
   shapes.erase(shapes.begin()+idx);
 
+  shapeCache->shapesChanged();
 }
 
 void puzzle_c::exchangeShapes(unsigned int s1, unsigned int s2) {
@@ -381,6 +417,8 @@ void puzzle_c::exchangeShapes(unsigned int s1, unsigned int s2) {
   shapes[s1] = shapes[s2];
   shapes[s2] = v;
 
+  shapeCache->shapesChanged();
+
   for (unsigned int i = 0; i < problems.size(); i++)
     problems[i]->exchangeShapes(s1, s2);
 }
@@ -38,6 +38,7 @@ class gridType_c;
 class problem_c;
 class xmlWriter_c;
 class xmlParser_c;
+class shapeCache_c;
 
 /**
  * This class defines the puzzle.
@@ -86,6 +87,9 @@ private:
    */
   bool commentPopup;
 
+  /** the transformed shapes, see \ref getShapeCache */
+  shapeCache_c * shapeCache;
+
 public:
 
   /**
@@ -99,7 +103,7 @@ public:
    * ownership of the given gridtype is taken over, the memory
    * is freed on destruction of this class
    */
-  puzzle_c(gridType_c * g) : gt(g), commentPopup(false) { }
+  puzzle_c(gridType_c * g);
 
   /**
    * load the puzzle from the XML file
@@ -155,6 +159,27 @@ public:
   //@}
 
 
+  /**
+   * Fill all lazily calculated caches of the shapes and the grid type.
+   *
+   * Several threads may work on the problems of one puzzle at the same
+   * time as long as nobody modifies the puzzle. But the shapes calculate
+   * their self symmetries and the hotspots and bounding boxes of their
+   * transformations on demand, which is a write access. This function
+   * calculates all these values, so that afterwards the shared puzzle
+   * really is only read.
+   */
+  void prepareSharedCaches(void) const;
+
+  /**
+   * The shapes of the puzzle in all orientations.
+   *
+   * Everybody who needs transformed shapes or their hotspots and bounding boxes
+   * should get them from here, so that they are only calculated once. The cache
+   * can be used by several threads at the same time
+   */
+  shapeCache_c & getShapeCache(void) const { return *shapeCache; }
+
   /** \name  handle puzzle colours */
   //@{
   /** add a colour, return the index of the new colour */
@@ -0,0 +1,206 @@
+/* BurrTools
+ *
+ * BurrTools is the legal property of its developers, whose
+ * names are listed in the COPYRIGHT file, which is included
+ * within the source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+#include "shapecache.h"
+
+#include "puzzle.h"
+#include "voxel.h"
+#include "gridtype.h"
+#include "symmetries.h"
+
+shapeCache_c::shapeCache_c(const puzzle_c & puz) : puzzle(puz), numTransformations(0), retired(0), users(0) {
+}
+
+shapeCache_c::~shapeCache_c(void) {
+  clear();
+}
+
+void shapeCache_c::clear(void) {
+
+  for (unsigned int s = 0; s < entries.size(); s++) {
+    for (unsigned int t = 0; t < numTransformations; t++) {
+      entry * e = entries[s][t];
+      if (e) {
+        delete e->shape;
+        delete e;
+      }
+    }
+    delete [] entries[s];
+  }
+
+  entries.clear();
+
+  freeRetired();
+}
+
+void shapeCache_c::freeRetired(void) {
+
+#ifndef NO_THREADING
+  entry * e = retired.exchange(0);
+#else
+  entry * e = retired;
+  retired = 0;
+#endif
+
+  while (e) {
+    entry * n = e->next;
+    delete e->shape;
+    delete e;
+    e = n;
+  }
+}
+
+void shapeCache_c::addUser(void) {
+  users++;
+}
+
+void shapeCache_c::removeUser(void) {
+
+  bt_assert(users > 0);
+
+  if (--users == 0)
+    freeRetired();
+}
+
+unsigned long shapeCache_c::getRetired(void) const {
+
+  unsigned long cnt = 0;
+
+  for (const entry * e = retired; e; e = e->next)
+    cnt++;
+
+  return cnt;
+}
+
+void shapeCache_c::shapesChanged(void) {
+
+  clear();
+
+  if (puzzle.getNumberOfShapes() == 0)
+    return;
+
+  numTransformations = puzzle.getGridType()->getSymmetries()->getNumTransformationsMirror();
+
+  for (unsigned int s = 0; s < puzzle.getNumberOfShapes(); s++) {
+#ifndef NO_THREADING
+    boost::atomic<entry *> * tab = new boost::atomic<entry *>[numTransformations];
+#else
+    entry ** tab = new entry * [numTransformations];
+#endif
+    for (unsigned int t = 0; t < numTransformations; t++)
+      tab[t] = 0;
+
+    entries.push_back(tab);
+  }
+}
+
+const voxel_c * shapeCache_c::getShape(unsigned int s, unsigned char trans) {
+
+  bt_assert(s < entries.size());
+  bt_assert(trans < numTransformations);
+
+  const voxel_c * orig = puzzle.getShape(s);
+
+  if (trans == 0)
+    return orig;
+
+  entry * e = entries[s][trans];
+
+  if (e && e->changeCount == orig->getChangeCount())
+    return e->shape;
+
+  // the shape is not there, or it was changed since the copy was made, so make a new copy
+
+  entry * n = new entry;
+
+  n->changeCount = orig->getChangeCount();
+  n->next = 0;
+  n->shape = puzzle.getGridType()->getVoxel(orig);
+
+  if (!n->shape->transform(trans)) {
+    delete n->shape;
+    n->shape = 0;
+  }
+
+#ifndef NO_THREADING
+  /* when another thread has entered its copy in the meantime that one is used,
+   * both copies are made from the same shape because the shapes must not be changed
+   * while several threads use the cache
+   */
+  if (!entries[s][trans].compare_exchange_strong(e, n)) {
+    delete n->shape;
+    delete n;
+    return e->shape;
+  }
+#else
+  entries[s][trans] = n;
+#endif
+
+  /* the old copy is out of date, but the users may still hold the shape, so
+   * it is kept until they are gone
+   */
+  if (e && users == 0) {
+    delete e->shape;
+    delete e;
+  } else if (e) {
+#ifndef NO_THREADING
+    e->next = retired;
+    while (!retired.compare_exchange_weak(e->next, e));
+#else
+    e->next = retired;
+    retired = e;
+#endif
+  }
+
+  return n->shape;
+}
+
+bool shapeCache_c::getHotspot(unsigned int s, unsigned char trans, int * x, int * y, int * z) {
+
+  bt_assert(x && y && z);
+
+  const voxel_c * v = getShape(s, trans);
+
+  if (!v)
+    return false;
+
+  *x = v->getHx();
+  *y = v->getHy();
+  *z = v->getHz();
+
+  return true;
+}
+
+bool shapeCache_c::getBoundingBox(unsigned int s, unsigned char trans, int * x1, int * y1, int * z1, int * x2, int * y2, int * z2) {
+
+  const voxel_c * v = getShape(s, trans);
+
+  if (!v)
+    return false;
+
+  if (x1) *x1 = v->boundX1();
+  if (x2) *x2 = v->boundX2();
+  if (y1) *y1 = v->boundY1();
+  if (y2) *y2 = v->boundY2();
+  if (z1) *z1 = v->boundZ1();
+  if (z2) *z2 = v->boundZ2();
+
+  return true;
+}
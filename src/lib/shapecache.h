@@ -0,0 +1,150 @@
+/* BurrTools
+ *
+ * BurrTools is the legal property of its developers, whose
+ * names are listed in the COPYRIGHT file, which is included
+ * within the source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+#ifndef __SHAPECACHE_H__
+#define __SHAPECACHE_H__
+
+#ifndef NO_THREADING
+#include <boost/atomic.hpp>
+#endif
+
+#include <vector>
+
+class puzzle_c;
+class voxel_c;
+
+/**
+ * The shapes of a puzzle in all their orientations.
+ *
+ * Many parts of the library need rotated copies of the shapes of a puzzle: the
+ * assemblers when they place the pieces, the movement caches of the disassemblers,
+ * the voxel tables and the rotation of assemblies, which needs the hotspots and
+ * bounding boxes of the rotated shapes. Instead of each of them creating its own
+ * copies they all get them from this cache. Each puzzle has one, see
+ * puzzle_c::getShapeCache.
+ *
+ * The copies are created when they are first requested. Several threads may
+ * request copies at the same time, but as with the rest of the puzzle nobody
+ * must change the shapes while that happens.
+ *
+ * Each copy remembers the change count (voxel_c::getChangeCount) of its shape, once
+ * the shape is changed the copy is recreated on the next request.
+ *
+ * The movement caches keep the shapes for their whole life, so they register as
+ * users. Out of date copies are kept as long as there are users and freed, when
+ * the last user leaves. Without users they are freed at once, the others only
+ * use the shapes while nobody changes them. So editing the shapes while no solver
+ * is running doesn't pile up copies.
+ */
+class shapeCache_c {
+
+  private:
+
+    /** one transformed shape */
+    typedef struct entry {
+      voxel_c * shape;          ///< the transformed shape, 0 when the shape can not be transformed like that
+      unsigned int changeCount; ///< the change count of the untransformed shape at the time the copy was made
+      struct entry * next;      ///< the next entry in the list of retired entries
+    } entry;
+
+    /** the puzzle with the shapes */
+    const puzzle_c & puzzle;
+
+    /** the number of transformations including the mirror transformations of the grid */
+    unsigned int numTransformations;
+
+    /** for each shape of the puzzle and each transformation the entry or 0 */
+#ifndef NO_THREADING
+    std::vector<boost::atomic<entry *> *> entries;
+#else
+    std::vector<entry **> entries;
+#endif
+
+    /** the out of date entries that are kept for the users */
+#ifndef NO_THREADING
+    boost::atomic<entry *> retired;
+#else
+    entry * retired;
+#endif
+
+    /** number of users that keep shapes, see addUser */
+#ifndef NO_THREADING
+    boost::atomic<unsigned int> users;
+#else
+    unsigned int users;
+#endif
+
+    /** delete the retired entries */
+    void freeRetired(void);
+
+    /** delete all entries */
+    void clear(void);
+
+  public:
+
+    shapeCache_c(const puzzle_c & puz);
+    ~shapeCache_c(void);
+
+    /**
+     * return shape s of the puzzle transformed by trans. When the shape can not
+     * be transformed like that 0 is returned.
+     *
+     * Transformation 0 returns the shape of the puzzle itself.
+     */
+    const voxel_c * getShape(unsigned int s, unsigned char trans);
+
+    /**
+     * get the hotspot of the transformed shape, returns false, when the
+     * shape can not be transformed like that
+     */
+    bool getHotspot(unsigned int s, unsigned char trans, int * x, int * y, int * z);
+
+    /**
+     * get the bounding box of the transformed shape, returns false, when the
+     * shape can not be transformed like that.
+     *
+     * If the return pointers are 0 the value is not returned
+     */
+    bool getBoundingBox(unsigned int s, unsigned char trans, int * x1, int * y1, int * z1, int * x2 = 0, int * y2 = 0, int * z2 = 0);
+
+    /**
+     * forget all shapes, this must be called when shapes are added to the puzzle,
+     * removed or exchanged
+     */
+    void shapesChanged(void);
+
+    /**
+     * somebody keeps the shapes returned by getShape longer than the current
+     * operation, out of date shapes stay valid until removeUser is called
+     */
+    void addUser(void);
+    void removeUser(void);
+
+    /** number of out of date copies that are kept for the users */
+    unsigned long getRetired(void) const;
+
+  private:
+
+    // no copying and assigning
+    shapeCache_c(const shapeCache_c&);
+    void operator=(const shapeCache_c&);
+};
+
+#endif
@@ -0,0 +1,107 @@
+/* BurrTools
+ *
+ * BurrTools is the legal property of its developers, whose
+ * names are listed in the COPYRIGHT file, which is included
+ * within the source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+#include "shapecache.h"
+#include "puzzle.h"
+#include "voxel_0.h"
+#include "gridtype.h"
+#include <boost/test/unit_test.hpp>
+
+#include <stdlib.h>
+
+/* compare the cached shapes with transformed copies of the shapes */
+static void checkShapes(puzzle_c & p) {
+
+  const gridType_c * gt = p.getGridType();
+
+  for (unsigned int s = 0; s < p.getNumberOfShapes(); s++)
+    for (unsigned int t = 0; t < gt->getSymmetries()->getNumTransformationsMirror(); t++) {
+
+      voxel_c * v = gt->getVoxel(p.getShape(s));
+      BOOST_CHECK( v->transform(t) );
+
+      const voxel_c * c = p.getShapeCache().getShape(s, t);
+      BOOST_CHECK( c && c->getX() == v->getX() && c->getY() == v->getY() && c->getZ() == v->getZ() );
+      BOOST_CHECK( c && c->identicalInBB(v) && v->identicalInBB(c) );
+
+      int hx, hy, hz, x1, y1, z1, x2, y2, z2;
+      BOOST_CHECK( p.getShapeCache().getHotspot(s, t, &hx, &hy, &hz) );
+      BOOST_CHECK( hx == v->getHx() && hy == v->getHy() && hz == v->getHz() );
+
+      BOOST_CHECK( p.getShapeCache().getBoundingBox(s, t, &x1, &y1, &z1, &x2, &y2, &z2) );
+      BOOST_CHECK( x1 == (int)v->boundX1() && y1 == (int)v->boundY1() && z1 == (int)v->boundZ1() );
+      BOOST_CHECK( x2 == (int)v->boundX2() && y2 == (int)v->boundY2() && z2 == (int)v->boundZ2() );
+
+      delete v;
+    }
+}
+
+BOOST_AUTO_TEST_CASE( shapecache_test )
+{
+  puzzle_c p(new gridType_c(gridType_c::GT_BRICKS));
+
+  srand(3);
+
+  for (unsigned int s = 0; s < 3; s++) {
+    unsigned int i = p.addShape(1 + rand() % 5, 1 + rand() % 5, 1 + rand() % 5);
+    for (unsigned int v = 0; v < p.getShape(i)->getXYZ(); v++)
+      if (rand() % 2)
+        p.getShape(i)->setState(v, voxel_c::VX_FILLED);
+  }
+
+  checkShapes(p);
+
+  // changed shapes must be transformed again
+  p.getShape(1)->setState(0, voxel_c::VX_VARIABLE);
+  p.getShape(2)->setHotspot(1, 0, 0);
+  p.getShape(0)->transform(5);
+
+  checkShapes(p);
+
+  // and so must the shapes, when the shape list changes
+  p.exchangeShapes(0, 2);
+  p.removeShape(1);
+
+  checkShapes(p);
+
+  // editing a shape again and again must not pile up out of date copies
+  shapeCache_c & c = p.getShapeCache();
+
+  for (unsigned int i = 0; i < 20; i++) {
+    p.getShape(0)->setState(0, (i & 1) ? voxel_c::VX_FILLED : voxel_c::VX_EMPTY);
+    checkShapes(p);
+  }
+
+  BOOST_CHECK_EQUAL( c.getRetired(), 0ul );
+
+  // unless there is somebody keeping the shapes
+  c.addUser();
+
+  const voxel_c * kept = c.getShape(0, 1);
+  p.getShape(0)->setState(0, voxel_c::VX_FILLED);
+  checkShapes(p);
+
+  BOOST_CHECK( kept != c.getShape(0, 1) );
+  BOOST_CHECK( c.getRetired() > 0 );
+
+  c.removeUser();
+
+  BOOST_CHECK_EQUAL( c.getRetired(), 0ul );
+}
@@ -0,0 +1,197 @@
+/* BurrTools
+ *
+ * BurrTools is the legal property of its developers, whose
+ * names are listed in the COPYRIGHT file, which is included
+ * within the source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+#include "solvescheduler.h"
+
+#include "solvethread.h"
+#include "problem.h"
+#include "puzzle.h"
+#include "voxel.h"
+#include "executor.h"
+
+#include <algorithm>
+
+unsigned long estimateSolveWork(const problem_c & problem) {
+
+  /* the number of placements grows with the size of the result and the
+   * number of pieces, the search tree grows with the number of placements
+   * and the number of pieces, so we use the square of the result size times
+   * the number of pieces. This is crude, but good enough to separate the
+   * big from the small problems
+   */
+  if (!problem.resultValid())
+    return 0;
+
+  unsigned long units = getResultShape(problem)->countState(voxel_c::VX_FILLED) +
+                        getResultShape(problem)->countState(voxel_c::VX_VARIABLE);
+
+  unsigned long work = units * units * problem.getNumberOfPieces();
+
+  /* when a part of the problem is already solved only the rest needs to be done */
+  if (problem.getAssembler()) {
+    float finished = problem.getAssembler()->getFinished();
+
+    if (finished > 0 && finished <= 1)
+      work = (unsigned long)(work * (1 - finished));
+  }
+
+  return work;
+}
+
+solveScheduler_c::solveScheduler_c(puzzle_c & puz, int par, unsigned int thr) :
+  puzzle(puz), parameters(par), threads(thr), solutionLimit(10), solutionDrop(1),
+  sortMethod(solveThread_c::SRT_COMPLETE_MOVES), frontMemory(0), stopPressed(false)
+{
+  if (threads == 0)
+    threads = executor_c::instance().size();
+}
+
+solveScheduler_c::~solveScheduler_c(void) {
+
+  for (unsigned int i = 0; i < jobs.size(); i++)
+    delete jobs[i].thread;
+}
+
+void solveScheduler_c::addProblem(unsigned int problem) {
+
+  bt_assert(problem < puzzle.getNumberOfProblems());
+
+  job j;
+
+  j.problem = problem;
+  j.work = estimateSolveWork(*puzzle.getProblem(problem));
+  j.thread = 0;
+  j.action = solveThread_c::ACT_PREPARATION;
+  j.errState = assembler_c::ERR_NONE;
+  j.errParam = 0;
+
+  jobs.push_back(j);
+}
+
+bool solveScheduler_c::startJob(job & j) {
+
+  j.thread = new solveThread_c(*puzzle.getProblem(j.problem), parameters);
+  j.thread->setSolutionLimits(solutionLimit, solutionDrop);
+  j.thread->setSortMethod(sortMethod);
+  j.thread->setFrontMemory(frontMemory, frontDirectory.c_str());
+  if (!cacheDirectory.empty())
+    j.thread->setMovementCacheDirectory(cacheDirectory.c_str());
+
+  if (!j.thread->start()) {
+    delete j.thread;
+    j.thread = 0;
+    j.action = solveThread_c::ACT_ERROR;
+    return false;
+  }
+
+  return true;
+}
+
+void solveScheduler_c::finishJob(job & j) {
+
+  j.action = j.thread->currentAction();
+
+  if (j.action == solveThread_c::ACT_ERROR) {
+    j.errState = j.thread->getErrorState();
+    j.errParam = j.thread->getErrorParam();
+  } else if (j.action == solveThread_c::ACT_ASSERT)
+    j.ae = j.thread->getAssertException();
+
+  j.stats = j.thread->getDisassemblerStats();
+
+  delete j.thread;
+  j.thread = 0;
+}
+
+/* sort job indices by decreasing work, ties are kept in the order of the problems */
+class jobWorkCompare_c {
+
+  const std::vector<unsigned long> & work;
+
+  public:
+
+    jobWorkCompare_c(const std::vector<unsigned long> & w) : work(w) {}
+
+    bool operator()(unsigned int a, unsigned int b) const { return work[a] > work[b]; }
+};
+
+void solveScheduler_c::run(void) {
+
+  /* from now on all threads only read from the puzzle, but for that
+   * the lazily calculated values within the shapes must be available
+   */
+  puzzle.prepareSharedCaches();
+
+  std::vector<unsigned long> work;
+  std::vector<unsigned int> order;
+
+  for (unsigned int i = 0; i < jobs.size(); i++) {
+    work.push_back(jobs[i].work);
+    order.push_back(i);
+  }
+
+  std::stable_sort(order.begin(), order.end(), jobWorkCompare_c(work));
+
+  unsigned int next = 0;
+  std::vector<unsigned int> running;
+  bool stopPassed = false;
+
+  while (next < order.size() || running.size() > 0) {
+
+    // fill up the free thread slots with the biggest waiting problems
+    while (!stopPressed && running.size() < threads && next < order.size()) {
+      if (startJob(jobs[order[next]]))
+        running.push_back(order[next]);
+      next++;
+    }
+
+    // collect the finished problems
+    bool finished = false;
+
+    for (unsigned int i = 0; i < running.size(); i++)
+      if (!jobs[running[i]].thread->isRunning()) {
+        finishJob(jobs[running[i]]);
+        running.erase(running.begin()+i);
+        i--;
+        finished = true;
+      }
+
+    // when stopped, pass the request on to the running problems and
+    // don't start the remaining ones
+    if (stopPressed && !stopPassed) {
+      for (unsigned int i = 0; i < running.size(); i++)
+        jobs[running[i]].thread->stop();
+
+      next = order.size();
+      stopPassed = true;
+    }
+
+    if (!finished && running.size() > 0)
+      thread_c::sleep(5);
+  }
+}
+
+void solveScheduler_c::stop(void) {
+
+  /* the running threads are stopped by run, as only that
+   * function knows which ones are still alive
+   */
+  stopPressed = true;
+}
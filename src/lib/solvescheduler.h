@@ -0,0 +1,176 @@
+/* BurrTools
+ *
+ * BurrTools is the legal property of its developers, whose
+ * names are listed in the COPYRIGHT file, which is included
+ * within the source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+#ifndef __SOLVESCHEDULER_H__
+#define __SOLVESCHEDULER_H__
+
+#include "assembler.h"
+#include "disassemblerstats.h"
+#include "bt_assert.h"
+
+#ifndef NO_THREADING
+#include <boost/atomic.hpp>
+#endif
+
+#include <string>
+#include <vector>
+
+class puzzle_c;
+class problem_c;
+class solveThread_c;
+
+/**
+ * Solves several problems of one puzzle at the same time.
+ *
+ * Each problem gets its own solveThread_c, so counters, solution lists and
+ * assemblers stay separate for each problem. The scheduler makes sure that
+ * never more than the given number of solve threads run at the same time and
+ * starts the problems with the most estimated work first, so that the long
+ * running problems don't end up at the end of the queue running alone.
+ *
+ * The puzzle itself is shared between all threads. It must not be modified
+ * while the scheduler runs.
+ */
+class solveScheduler_c {
+
+  public:
+
+    /**
+     * Create a scheduler for the given puzzle.
+     *
+     * Parameters are the solveThread_c::PAR_xxx flags used for all the problems.
+     * Threads is the maximal number of problems solved at the same time, 0 means
+     * one for each worker of the executor. The problems run as tasks of the executor,
+     * so they never use more threads than the executor has
+     */
+    solveScheduler_c(puzzle_c & puz, int parameters, unsigned int threads = 0);
+    ~solveScheduler_c(void);
+
+    /** add a problem (by its index in the puzzle) to the list of problems to solve */
+    void addProblem(unsigned int problem);
+
+    /** same as in solveThread_c, these values are used for all problems */
+    void setSolutionLimits(unsigned int limit, unsigned int drop = 1) {
+      solutionLimit = limit;
+      solutionDrop = drop;
+    }
+
+    /** same as in solveThread_c, this value is used for all problems */
+    void setSortMethod(int sort) { sortMethod = sort; }
+
+    /** same as in solveThread_c, these values are used for all problems */
+    void setFrontMemory(unsigned long memory, const char * directory) {
+      frontMemory = memory;
+      frontDirectory = directory ? directory : "";
+    }
+
+    /** same as in solveThread_c, this value is used for all problems */
+    void setMovementCacheDirectory(const char * directory) { cacheDirectory = directory ? directory : ""; }
+
+    /**
+     * Solve all added problems.
+     *
+     * The function returns once all problems have been handled, or after
+     * stop has been called and all the running problems did stop
+     */
+    void run(void);
+
+    /**
+     * stop all running problems and don't start any new ones.
+     * This can be called from an other thread while run is active
+     */
+    void stop(void);
+
+    /** return the number of threads the scheduler uses at most */
+    unsigned int getThreads(void) const { return threads; }
+
+    /** number of problems added to the scheduler */
+    unsigned int getNumberOfJobs(void) const { return jobs.size(); }
+
+    /** the index of the problem of the job within the puzzle, jobs are kept in the order they were added */
+    unsigned int getProblem(unsigned int job) const { bt_assert(job < jobs.size()); return jobs[job].problem; }
+
+    /** the solveThread_c::ACT_xxx value with which the problem finished */
+    unsigned int getFinalAction(unsigned int job) const { bt_assert(job < jobs.size()); return jobs[job].action; }
+
+    /** when the problem finished with ACT_ERROR this is the error */
+    assembler_c::errState getErrorState(unsigned int job) const { bt_assert(job < jobs.size()); return jobs[job].errState; }
+
+    /** when the problem finished with ACT_ERROR this is the error parameter */
+    int getErrorParam(unsigned int job) const { bt_assert(job < jobs.size()); return jobs[job].errParam; }
+
+    /** when the problem finished with ACT_ASSERT this is the exception */
+    const assert_exception & getAssertException(unsigned int job) const { bt_assert(job < jobs.size()); return jobs[job].ae; }
+
+    /** the disassembler counters of the finished problem, see solveThread_c::getDisassemblerStats */
+    const disassemblerStats_c & getDisassemblerStats(unsigned int job) const { bt_assert(job < jobs.size()); return jobs[job].stats; }
+
+  private:
+
+    /** all the information for one problem */
+    struct job {
+      unsigned int problem;        ///< index of the problem within the puzzle
+      unsigned long work;          ///< estimated work, used to order the problems
+      solveThread_c * thread;      ///< the thread while it is running, 0 otherwise
+      unsigned int action;         ///< the final action of the thread
+      assembler_c::errState errState;
+      int errParam;
+      assert_exception ae;
+      disassemblerStats_c stats;
+    };
+
+    /** start the job, return false, if it could not be started */
+    bool startJob(job & j);
+
+    /** save the results of a job and free its thread */
+    void finishJob(job & j);
+
+    puzzle_c & puzzle;
+    int parameters;
+    unsigned int threads;
+
+    unsigned int solutionLimit;
+    unsigned int solutionDrop;
+    int sortMethod;
+    unsigned long frontMemory;
+    std::string frontDirectory;
+    std::string cacheDirectory;
+
+    // stop() is called from another thread than run()
+#ifndef NO_THREADING
+    boost::atomic<bool> stopPressed;
+#else
+    bool stopPressed;
+#endif
+
+    std::vector<job> jobs;
+
+    // no copying and assigning
+    solveScheduler_c(const solveScheduler_c&);
+    void operator=(const solveScheduler_c&);
+};
+
+/**
+ * Return an estimate for the work required to solve the problem.
+ * The value has no unit it is only useful to compare different problems.
+ */
+unsigned long estimateSolveWork(const problem_c & problem);
+
+#endif
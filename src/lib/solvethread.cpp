@@ -25,7 +25,9 @@
 #include "puzzle.h"
 #include "assembly.h"
 #include "disassembler_0.h"
+#include "disassembler_2.h"
 #include "solution.h"
+#include "metrics.h"
 
 void solveThread_c::run(void){
 
@@ -42,6 +44,7 @@ void solveThread_c::run(void){
       /* otherwise we have to create a new one
        */
       action = solveThread_c::ACT_PREPARATION;
+      metrics.setPhase(solveMetrics_c::PH_PREPARATION);
       assm = puzzle.getPuzzle().getGridType()->findAssembler(puzzle);
 
       errState = assm->createMatrix(parameters & PAR_KEEP_MIRROR, parameters & PAR_KEEP_ROTATIONS, parameters & PAR_COMPLETE_ROTATIONS);
@@ -50,6 +53,7 @@ void solveThread_c::run(void){
         errParam = assm->getErrorsParam();
 
         action = solveThread_c::ACT_ERROR;
+        metrics.setPhase(solveMetrics_c::PH_IDLE);
 
         delete assm;
         return;
@@ -60,6 +64,7 @@ void solveThread_c::run(void){
         if (!stopPressed)
           action = solveThread_c::ACT_REDUCE;
 
+        metrics.setPhase(solveMetrics_c::PH_REDUCE);
         assm->reduce();
       }
 
@@ -71,19 +76,44 @@ void solveThread_c::run(void){
       errState = puzzle.setAssembler(assm);
       if (errState != assembler_c::ERR_NONE) {
         action = solveThread_c::ACT_ERROR;
+        metrics.setPhase(solveMetrics_c::PH_IDLE);
         return;
       }
     }
 
     if (return_after_prep) {
       action = solveThread_c::ACT_PAUSING;
+      metrics.setPhase(solveMetrics_c::PH_IDLE);
       return;
     }
 
     if (!stopPressed) {
 
       action = solveThread_c::ACT_ASSEMBLING;
+      metrics.setPhase(solveMetrics_c::PH_ASSEMBLING);
+
+      // the assembler lives longer than this thread, so it gets the metrics only while assembling
+      assm->setMetrics(&metrics);
+
+      budget.start(assm->getIterations());
+      if (budget.limited())
+        assm->setBudget(&budget);
+
+      // the disassemblers also stop through the budget, when the files of their fronts fail
+      if (disassm) disassm->setBudget(&budget);
+      if (shortest) shortest->setBudget(&budget);
+
       assm->assemble(this);
+
+      assm->setMetrics(0);
+      assm->setBudget(0);
+      if (disassm) disassm->setBudget(0);
+      if (shortest) shortest->setBudget(0);
+
+      // the breadth first rerun analyses more positions than the depth first search
+      if (disassm && !cacheDirectory.empty())
+        (shortest ? shortest : disassm)->saveMovementCache(cacheDirectory.c_str());
+
       puzzle.addTime(time(0)-startTime);
 
       if (assm->getFinished() >= 1) {
@@ -97,10 +127,19 @@ void solveThread_c::run(void){
       puzzle.addTime(time(0)-startTime);
     }
 
+    metrics.setPhase(solveMetrics_c::PH_IDLE);
   }
 
   catch (assert_exception & a) {
 
+    if (assm) {
+      assm->setMetrics(0);
+      assm->setBudget(0);
+    }
+    if (disassm) disassm->setBudget(0);
+    if (shortest) shortest->setBudget(0);
+    metrics.setPhase(solveMetrics_c::PH_IDLE);
+
     ae = a;
     action = solveThread_c::ACT_ASSERT;
     if (puzzle.getAssembler())
@@ -116,11 +155,39 @@ sortMethod(SRT_COMPLETE_MOVES),
 solutionLimit(10),
 solutionDrop(1),
 disassm(0),
+shortest(0),
 assm(0)
 {
 
-  if (par & PAR_DISASSM)
-    disassm = new disassembler_0_c(puz);
+  if (par & PAR_DISASSM) {
+
+    if (par & PAR_ANY_DISASSM) {
+      disassm = new disassembler_2_c(puz);
+
+      // the progress is published by disassm only, the node counts of the two would get mixed up
+      if (par & PAR_SHORTEST_RERUN)
+        shortest = new disassembler_0_c(puz);
+
+    } else
+      disassm = new disassembler_0_c(puz);
+
+    disassm->setMetrics(&metrics);
+
+    if (par & PAR_CANONICAL_NODES) {
+      disassm->setCanonicalNodes(true);
+      if (shortest) shortest->setCanonicalNodes(true);
+    }
+  }
+}
+
+void solveThread_c::setMovementCacheDirectory(const char * directory) {
+
+  cacheDirectory = directory ? directory : "";
+
+  if (!cacheDirectory.empty()) {
+    if (disassm) disassm->loadMovementCache(directory);
+    if (shortest) shortest->loadMovementCache(directory);
+  }
 }
 
 solveThread_c::~solveThread_c(void) {
@@ -131,6 +198,11 @@ solveThread_c::~solveThread_c(void) {
     delete disassm;
     disassm = 0;
   }
+
+  if (shortest) {
+    delete shortest;
+    shortest = 0;
+  }
 }
 
 bool solveThread_c::assembly(assembly_c * a) {
@@ -177,9 +249,39 @@ bool solveThread_c::assembly(assembly_c * a) {
 
       // try to disassemble
       action = ACT_DISASSEMBLING;
+      metrics.setPhase(solveMetrics_c::PH_DISASSEMBLING);
+      metrics.addDisassembly();
       separation_c * s = disassm->disassemble(a);
+      if (disassm->getStats())
+        disassemblerStats.add(*disassm->getStats());
+
+      /* the assembly comes apart, now find the shortest way to do that */
+      if (s && shortest && !budget.exceeded()) {
+        delete s;
+        s = shortest->disassemble(a);
+        if (shortest->getStats())
+          disassemblerStats.add(*shortest->getStats());
+      }
+      metrics.setPhase(solveMetrics_c::PH_ASSEMBLING);
       action = ACT_ASSEMBLING;
 
+      if (budget.exceeded()) {
+
+        /* the analysis was given up, the result is meaningless. We keep
+         * the assembly without disassembly, so that it can be analysed
+         * later on, and stop the assembler
+         */
+        delete s;
+
+        puzzle.addSolution(a);
+        puzzle.incNumAssemblies();
+        metrics.setSolutionCounts(puzzle.getNumAssemblies(), puzzle.getNumSolutions());
+
+        assm->stop();
+
+        return true;
+      }
+
       // check, if we found a disassembly sequence
       if (!s) {
         // no disassembly sequence found, delete assembly
@@ -298,6 +400,7 @@ bool solveThread_c::assembly(assembly_c * a) {
   }
 
   puzzle.incNumAssemblies();
+  metrics.setSolutionCounts(puzzle.getNumAssemblies(), puzzle.getNumSolutions());
 
   // this is the case for assembly only or unsorted disassembly solutions
   // we need to thin out the list
@@ -339,6 +442,9 @@ bool solveThread_c::start(bool stop_after_prep) {
   return_after_prep = stop_after_prep;
   startTime = time(0);
 
+  // the thread is not running yet, so we may write into the metrics here
+  metrics.reset();
+
   // calculate dropMultiplicator
 
   dropMultiplicator = 1;
@@ -360,7 +466,8 @@ bool solveThread_c::start(bool stop_after_prep) {
       a = puzzle.getNumSolutions();
   }
 
-  while (a+solutionDrop > 2 * solutionLimit * solutionDrop) {
+  // without a limit all solutions are kept and the multiplicator stays 1
+  while (solutionLimit && (a+solutionDrop > 2 * solutionLimit * solutionDrop)) {
     dropMultiplicator *= 2;
     a = (a+1) / 2;
   }
@@ -23,11 +23,16 @@
 
 #include "assembler.h"
 #include "disassembler.h"
+#include "disassemblerstats.h"
 #include "bt_assert.h"
 #include "thread.h"
+#include "metrics.h"
+#include "budget.h"
 
 #include <time.h>
 
+#include <string>
+
 class problem_c;
 
 /* this class will handle the solving of one problem of the puzzle, it can also
@@ -77,6 +82,34 @@ class solveThread_c : public assembler_cb, public thread_c {
       return errParam;
     }
 
+  private:
+
+    solveMetrics_c metrics;
+
+  public:
+
+    /**
+     * the progress of the solving thread, this can be read from any
+     * thread at any time using solveMetrics_c::getSnapshot
+     */
+    const solveMetrics_c & getMetrics(void) const { return metrics; }
+
+  private:
+
+    solveBudget_c budget;
+
+  public:
+
+    /**
+     * the limits for the runs of this thread, set them before calling start.
+     * When a limit is crossed the thread pauses, the state of the assembler
+     * is kept in the problem and can be saved and continued later on
+     */
+    solveBudget_c & getBudget(void) { return budget; }
+
+    /** why the thread stopped, one of the solveBudget_c::BR_xxx values */
+    unsigned int getStopReason(void) const { return budget.getReason(); }
+
   private:
 
     time_t startTime;
@@ -100,6 +133,11 @@ class solveThread_c : public assembler_cb, public thread_c {
     static const int PAR_DISASSM =            0x10;  // do the disassembly analysis
     static const int PAR_JUST_COUNT =         0x20;  // just count the solutions, don't save them
     static const int PAR_COMPLETE_ROTATIONS = 0x40;  // do a thorough rotation check
+    static const int PAR_ANY_DISASSM =        0x80;  // any disassembly will do, it doesn't need to be the shortest
+    static const int PAR_SHORTEST_RERUN =    0x100;  // with PAR_ANY_DISASSM: search the shortest disassembly for the
+                                                     // assemblies that come apart
+    static const int PAR_CANONICAL_NODES =   0x200;  // the disassemblers treat identical pieces as exchangeable,
+                                                     // see disassembler_c::setCanonicalNodes
 
     // create all the necessary data structures to start the thread later on
     solveThread_c(problem_c & puz, int par);
@@ -139,6 +177,25 @@ class solveThread_c : public assembler_cb, public thread_c {
       solutionDrop = drop;
     }
 
+    /** the front memory for the disassemblers, see disassembler_c::setFrontMemory */
+    void setFrontMemory(unsigned long memory, const char * directory) {
+      if (disassm) disassm->setFrontMemory(memory, directory);
+      if (shortest) shortest->setFrontMemory(memory, directory);
+    }
+
+  private:
+
+    /** where the movement values are kept between runs, empty for nowhere */
+    std::string cacheDirectory;
+
+  public:
+
+    /**
+     * load the movement values for the disassemblers from directory and save
+     * them there again, when the solving stops
+     */
+    void setMovementCacheDirectory(const char * directory);
+
   private:
 
     assert_exception ae;
@@ -149,6 +206,16 @@ class solveThread_c : public assembler_cb, public thread_c {
       return ae;
     }
 
+  private:
+
+    /** the sum of the counters of all disassemblies done so far */
+    disassemblerStats_c disassemblerStats;
+
+  public:
+
+    /** the counters of all disassemblies of the thread, only read them while the thread doesn't run */
+    const disassemblerStats_c & getDisassemblerStats(void) const { return disassemblerStats; }
+
   private:
 
 
@@ -159,6 +226,9 @@ class solveThread_c : public assembler_cb, public thread_c {
 
 
   disassembler_c * disassm;
+
+  /* the breadth first disassembler for PAR_SHORTEST_RERUN, or 0 */
+  disassembler_c * shortest;
   assembler_c * assm;
 
 
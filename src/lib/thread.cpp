@@ -21,44 +21,48 @@
 
 #include "thread.h"
 
+#ifndef NO_THREADING
+#include <boost/thread.hpp>
+#endif
+
 thread_c::~thread_c(void) {
   kill();
 }
 
-void thread_c::start_thread(void)
-{
-  running = true;
-  run();
-  running = false;
-}
-
 bool thread_c::start() {
 
-  running = true;
-  bool result = false;
-
-#ifdef NO_THREADING
-  start_thread();
-  result = true;
-#else
-  thread = boost::thread(&thread_c::start_thread, this);
-  result = thread.get_id() != boost::thread::id();
-
-  if (!result)
-  {
-    running = false;
-  }
-#endif
+  token.reset();
+  executor_c::instance().submit(this);
 
-  return result;
+  return true;
 }
 
 void thread_c::kill() {
 
   stop();
 
-#ifndef NO_THREADING
-  thread.join();
+  if (pending()) {
+    // if the job is still waiting for a worker it will not be started at all
+    token.cancel();
+    executor_c::instance().wait(this);
+  }
+}
+
+unsigned int thread_c::hardwareThreads(void) {
+
+#ifdef NO_THREADING
+  return 1;
+#else
+  unsigned int res = boost::thread::hardware_concurrency();
+  return res ? res : 1;
 #endif
 }
 
+void thread_c::sleep(unsigned int ms) {
+
+#ifdef NO_THREADING
+  (void)ms;
+#else
+  boost::this_thread::sleep(boost::posix_time::milliseconds(ms));
+#endif
+}
@@ -21,25 +21,23 @@
 #ifndef __THREAD_H__
 #define __THREAD_H__
 
-#ifndef NO_THREADING
-#include <boost/thread.hpp>
-#endif
+#include "executor.h"
 
-/* this class encapsulates a single thread */
-class thread_c {
+/* this class encapsulates a single long running job. The job is a task
+ * of the library wide executor, so it gets one of the worker threads of
+ * that pool once one is free
+ */
+class thread_c : public task_c {
 
   private:
 
-#ifndef NO_THREADING
-    boost::thread thread;  // our thread
-#endif
-
-    bool running;
+    /** used to drop the job, when it is killed before it was started */
+    cancelToken_c token;
 
   public:
 
     /** create the thread data structure, but don't start the thread */
-    thread_c(void) : running(false) {}
+    thread_c(void) { setCancelToken(&token); }
 
     /** kill the thread and then delete data structure */
     virtual ~thread_c(void);
@@ -53,8 +51,14 @@ class thread_c {
     /** kill the thread */
     void kill();
 
-    /** return true, if the thread is running */
-    bool isRunning(void) { return running; }
+    /** return true, if the thread is running or waiting for a free worker */
+    bool isRunning(void) { return pending(); }
+
+    /** return the number of threads the machine can run at the same time, at least 1 */
+    static unsigned int hardwareThreads(void);
+
+    /** let the calling thread sleep for the given number of milliseconds */
+    static void sleep(unsigned int ms);
 
   protected:
 
@@ -65,8 +69,6 @@ class thread_c {
 
   private:
 
-    void start_thread(void);
-
     // no copying and assigning
     thread_c(const thread_c&);
     void operator=(const thread_c&);
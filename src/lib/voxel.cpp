@@ -89,6 +89,7 @@ voxel_c::voxel_c(unsigned int x, unsigned int y, unsigned int z, const gridType_
   bt_assert(gt);
 
   memset(space, init, voxels);
+  bitPlanes.init(sx, sy, sz, space);
 
   if (init == 0) {
     bx2 = by2 = bz2 = 0;
@@ -105,6 +106,7 @@ voxel_c::voxel_c(unsigned int x, unsigned int y, unsigned int z, const gridType_
   doRecalc = true;
 
   symmetries = symmetryInvalid();
+  changeCount = 0;
 
   BbHsCache = new int[9*gt->getSymmetries()->getNumTransformationsMirror()];
 
@@ -113,7 +115,7 @@ voxel_c::voxel_c(unsigned int x, unsigned int y, unsigned int z, const gridType_
 }
 
 voxel_c::voxel_c(const voxel_c & orig) : gt(orig.gt), sx(orig.sx), sy(orig.sy), sz(orig.sz),
-voxels(orig.voxels), hx(orig.hx), hy(orig.hy), hz(orig.hz), weight(orig.weight) {
+voxels(orig.voxels), bitPlanes(orig.bitPlanes), hx(orig.hx), hy(orig.hy), hz(orig.hz), weight(orig.weight) {
 
   space = new voxel_type[voxels];
   bt_assert(space);
@@ -130,6 +132,7 @@ voxels(orig.voxels), hx(orig.hx), hy(orig.hy), hz(orig.hz), weight(orig.weight)
   doRecalc = true;
 
   symmetries = symmetryInvalid();
+  changeCount = 0;
 
   BbHsCache = new int[9*gt->getSymmetries()->getNumTransformationsMirror()];
 
@@ -138,7 +141,7 @@ voxels(orig.voxels), hx(orig.hx), hy(orig.hy), hz(orig.hz), weight(orig.weight)
 }
 
 voxel_c::voxel_c(const voxel_c * orig) : gt(orig->gt), sx(orig->sx), sy(orig->sy), sz(orig->sz),
-voxels(orig->voxels), hx(orig->hx), hy(orig->hy), hz(orig->hz), weight(orig->weight) {
+voxels(orig->voxels), bitPlanes(orig->bitPlanes), hx(orig->hx), hy(orig->hy), hz(orig->hz), weight(orig->weight) {
 
   space = new voxel_type[voxels];
   bt_assert(space);
@@ -155,6 +158,7 @@ voxels(orig->voxels), hx(orig->hx), hy(orig->hy), hz(orig->hz), weight(orig->wei
   doRecalc = true;
 
   symmetries = symmetryInvalid();
+  changeCount = 0;
 
   BbHsCache = new int[9*gt->getSymmetries()->getNumTransformationsMirror()];
 
@@ -193,8 +197,9 @@ void voxel_c::recalcBoundingBox(void) {
           if (z > bz2) bz2 = z;
 
           empty = false;
-        } else {
+        } else if (space[index]) {
           space[index] = 0;  // clear away all colours that might be left
+          bitPlanes.set(x, y, z, 0);
         }
         index++;
       }
@@ -203,10 +208,71 @@ void voxel_c::recalcBoundingBox(void) {
     bx1 = by1 = bz1 = bx2 = by2 = bz2 = 0;
 
   /* we also clear the bounding box and hotspot cache */
+  clearBbHsCache();
+}
+
+void voxel_c::clearBbHsCache(void) {
+  changeCount++;
+
   for (unsigned int i = 0; i < gt->getSymmetries()->getNumTransformationsMirror(); i++)
     BbHsCache[9*i+0] = BbHsCache[9*i+3] = BBHSCACHE_UNINIT;
 }
 
+void voxel_c::setVoxel(unsigned int x, unsigned int y, unsigned int z, voxel_type val) {
+
+  unsigned int p = getIndex(x, y, z);
+
+  if (!doRecalc) {
+    space[p] = val;
+    bitPlanes.set(x, y, z, val);
+    return;
+  }
+
+  if ((val & 3) != VX_EMPTY) {
+
+    /* an empty space has either the box of the constructor with the lower
+     * corner above the upper one, or all coordinates 0 and an empty voxel 0
+     */
+    bool empty = (bx1 > bx2) || (by1 > by2) || (bz1 > bz2) ||
+      (bx2 == 0 && by2 == 0 && bz2 == 0 && (space[0] & 3) == VX_EMPTY);
+
+    space[p] = val;
+    bitPlanes.set(x, y, z, val);
+
+    if (empty) {
+      bx1 = bx2 = x;
+      by1 = by2 = y;
+      bz1 = bz2 = z;
+    } else {
+      if (x < bx1) bx1 = x;
+      if (x > bx2) bx2 = x;
+      if (y < by1) by1 = y;
+      if (y > by2) by2 = y;
+      if (z < bz1) bz1 = z;
+      if (z > bz2) bz2 = z;
+    }
+
+  } else {
+
+    bool wasFilled = (space[p] & 3) != VX_EMPTY;
+
+    // recalcBoundingBox would clear the colour of the empty voxel
+    space[p] = 0;
+    bitPlanes.set(x, y, z, 0);
+
+    /* only when a voxel on the border is removed the box may shrink, the box of
+     * a new empty space needs to become all 0 like the box of all empty spaces
+     */
+    if ((wasFilled && (x == bx1 || x == bx2 || y == by1 || y == by2 || z == bz1 || z == bz2)) ||
+        bx1 > bx2 || by1 > by2 || bz1 > bz2) {
+      recalcBoundingBox();
+      return;
+    }
+  }
+
+  clearBbHsCache();
+}
+
 bool voxel_c::operator ==(const voxel_c & op) const {
 
   if (sx != op.sx) return false;
@@ -226,17 +292,60 @@ bool voxel_c::identicalInBB(const voxel_c * op, bool includeColors) const {
   if (by2-by1 != op->by2-op->by1) return false;
   if (bz2-bz1 != op->bz2-op->bz1) return false;
 
-  for (unsigned int x = bx1; x <= bx2; x++)
+  const voxelPlanes_c & opp = op->bitPlanes;
+
+  /* the filled and variable planes are the state of the voxels, with colours also the
+   * coloured plane must be equal
+   */
+  if (!bitPlanes.equalBox(opp, includeColors ? voxelPlanes_c::COLOURED+1 : voxelPlanes_c::VARIABLE+1,
+                          bx1, by1, bz1, op->bx1, op->by1, op->bz1, bx2-bx1+1, by2-by1+1, bz2-bz1+1))
+    return false;
+
+  if (!includeColors)
+    return true;
+
+  /* the same voxels have colours, now the colours themselves need to be compared */
+  for (unsigned int z = bz1; z <= bz2; z++)
     for (unsigned int y = by1; y <= by2; y++)
-      for (unsigned int z = bz1; z <= bz2; z++)
-        if (includeColors) {
-          if (get(x, y, z) != op->get(x-bx1+op->bx1, y-by1+op->by1, z-bz1+op->bz1))
-            return false;
-        } else {
-          if (getState(x, y, z) != op->getState(x-bx1+op->bx1, y-by1+op->by1, z-bz1+op->bz1))
+      for (unsigned int x = bx1; x <= bx2; x += 64) {
+
+        unsigned int len = (bx2-x+1 < 64) ? bx2-x+1 : 64;
+
+        uint64_t c = bitPlanes.row(voxelPlanes_c::COLOURED, x, y, z, len);
+
+        for (unsigned int i = 0; c; i++, c >>= 1)
+          if ((c & 1) && get(x+i, y, z) != op->get(x+i-bx1+op->bx1, y-by1+op->by1, z-bz1+op->bz1))
             return false;
-        }
+      }
+
+  return true;
+}
 
+bool voxel_c::fitsInto(const voxel_c * result, int x, int y, int z, bool exact) const {
+
+  bt_assert((int)bx1+x >= 0 && (int)by1+y >= 0 && (int)bz1+z >= 0);
+  bt_assert((int)bx2+x < (int)result->sx && (int)by2+y < (int)result->sy && (int)bz2+z < (int)result->sz);
+
+  const voxelPlanes_c & rp = result->bitPlanes;
+
+  for (unsigned int pz = bz1; pz <= bz2; pz++)
+    for (unsigned int py = by1; py <= by2; py++)
+      for (unsigned int px = bx1; px <= bx2; px += 64) {
+
+        unsigned int len = (bx2-px+1 < 64) ? bx2-px+1 : 64;
+
+        uint64_t f = bitPlanes.row(voxelPlanes_c::FILLED, px, py, pz, len);
+        uint64_t rf = rp.row(voxelPlanes_c::FILLED, px+x, py+y, pz+z, len);
+        uint64_t rn = rf | rp.row(voxelPlanes_c::VARIABLE, px+x, py+y, pz+z, len);
+
+        // filled voxels on empty voxels of the result
+        if (f & ~rn)
+          return false;
+
+        // filled voxels of the result not covered
+        if (exact && (rf & ~(f | bitPlanes.row(voxelPlanes_c::VARIABLE, px, py, pz, len))))
+          return false;
+      }
 
   return true;
 }
@@ -386,6 +495,8 @@ void voxel_c::resize(unsigned int nsx, unsigned int nsy, unsigned int nsz, voxel
   sz = nsz;
   voxels = sx*sy*sz;
 
+  bitPlanes.init(sx, sy, sz, space);
+
   recalcBoundingBox();
 }
 
@@ -407,11 +518,12 @@ unsigned int voxel_c::count(voxel_type val) const {
 }
 
 unsigned int voxel_c::countState(int state) const {
-  unsigned int count = 0;
-  for (unsigned int i = 0; i < getXYZ(); i++)
-    if ((get(i) & 3) == state)
-      count ++;
-  return count;
+  switch (state) {
+    case VX_FILLED: return bitPlanes.count(voxelPlanes_c::FILLED);
+    case VX_VARIABLE: return bitPlanes.count(voxelPlanes_c::VARIABLE);
+    case VX_EMPTY: return voxels - bitPlanes.count(voxelPlanes_c::FILLED) - bitPlanes.count(voxelPlanes_c::VARIABLE);
+    default: return 0;
+  }
 }
 
 void voxel_c::translate(int dx, int dy, int dz, voxel_type filler) {
@@ -429,6 +541,8 @@ void voxel_c::translate(int dx, int dy, int dz, voxel_type filler) {
   delete [] space;
   space = s2;
 
+  bitPlanes.load(space);
+
   // initially I thought I could just shift the bounding box, but this doesn't work
   // as off piece voxels might have been shifted out making the shape smaller
   // and thus requiring a recalculation...
@@ -587,6 +701,8 @@ void voxel_c::fillHoles(char type) {
   root = tree[voxels];
   while (tree[root] >= 0) root = tree[root];
 
+  voxelEdit_c edit(*this);
+
   for (unsigned int x = 0; x < sx; x++)
     for (unsigned int y = 0; y < sy; y++)
       for (unsigned int z = 0; z < sz; z++)
@@ -618,6 +734,8 @@ void voxel_c::copy(const voxel_c * orig) {
 
   voxels = orig->voxels;
 
+  bitPlanes = orig->bitPlanes;
+
   bx1 = orig->bx1;
   bx2 = orig->bx2;
   by1 = orig->by1;
@@ -627,6 +745,8 @@ void voxel_c::copy(const voxel_c * orig) {
 
   symmetries = orig->symmetries;
 
+  clearBbHsCache();
+
   // we don't copy the name intentionally because the name is supposed to
   // be unique
   name = "";
@@ -702,6 +822,8 @@ void voxel_c::actionOnSpace(VoxelAction action, bool inside) {
   if (!getX() || !getY() ||!getZ())
     return;
 
+  voxelEdit_c edit(*this);
+
   for (unsigned int x = 0; x < getX(); x++)
     for (unsigned int y = 0; y < getY(); y++)
       for (unsigned int z = 0; z < getZ(); z++)
@@ -822,6 +944,8 @@ voxel_c::voxel_c(xmlParser_c & pars, const gridType_c * g) : gt(g), hx(0), hy(0)
     weight = atoi(szStr.c_str());
 
   space = new voxel_type[voxels];
+  memset(space, 0, voxels);
+  bitPlanes.init(sx, sy, sz, space);
 
   if (pars.next() != xmlParser_c::TEXT)
     pars.exception("voxel space requires content");
@@ -879,6 +1003,7 @@ voxel_c::voxel_c(xmlParser_c & pars, const gridType_c * g) : gt(g), hx(0), hy(0)
   }
 
   symmetries = symmetryInvalid();
+  changeCount = 0;
   BbHsCache = new int[9*gt->getSymmetries()->getNumTransformationsMirror()];
 
   skipRecalcBoundingBox(false);
@@ -890,6 +1015,8 @@ voxel_c::voxel_c(xmlParser_c & pars, const gridType_c * g) : gt(g), hx(0), hy(0)
 void voxel_c::setHotspot(int x, int y, int z) {
   hx = x; hy = y; hz = z;
 
+  changeCount++;
+
   for (unsigned int i = 0; i < gt->getSymmetries()->getNumTransformationsMirror(); i++)
     BbHsCache[9*i+0] = BBHSCACHE_UNINIT;
 }
@@ -913,6 +1040,9 @@ bool voxel_c::indexToXYZ(unsigned int index, unsigned int *x, unsigned int *y, u
   return *z < sz;
 }
 
+static int min(int a, int b) { if (a < b) return a; else return b; }
+static int max(int a, int b) { if (a > b) return a; else return b; }
+
 bool voxel_c::unionintersect(
       const voxel_c * va, int xa, int ya, int za,
       const voxel_c * vb, int xb, int yb, int zb
@@ -944,14 +1074,34 @@ bool voxel_c::unionintersect(
 
   bool result = false;
 
-  for (unsigned int x = 0; x < sx; x++)
-    for (unsigned int y = 0; y < sy; y++)
-      for (unsigned int z = 0; z < sz; z++)
-        if (va->getState2(x-xa, y-ya, z-za) == VX_FILLED &&
-            vb->getState2(x-xb, y-yb, z-zb) == VX_FILLED) {
-          set(x, y, z, VX_FILLED);
-          result = true;
-        }
+  voxelEdit_c edit(*this);
+
+  /* only the intersection of the 2 bounding boxes can contain voxels filled in both
+   * spaces, its rows are combined with an AND of the filled planes
+   */
+  int x1 = max((int)va->bx1+xa, (int)vb->bx1+xb), x2 = min((int)va->bx2+xa, (int)vb->bx2+xb);
+  int y1 = max((int)va->by1+ya, (int)vb->by1+yb), y2 = min((int)va->by2+ya, (int)vb->by2+yb);
+  int z1 = max((int)va->bz1+za, (int)vb->bz1+zb), z2 = min((int)va->bz2+za, (int)vb->bz2+zb);
+
+  if (x1 < 0) x1 = 0;
+  if (y1 < 0) y1 = 0;
+  if (z1 < 0) z1 = 0;
+
+  for (int z = z1; z <= z2; z++)
+    for (int y = y1; y <= y2; y++)
+      for (int x = x1; x <= x2; x += 64) {
+
+        unsigned int len = (x2-x+1 < 64) ? x2-x+1 : 64;
+
+        uint64_t f = va->bitPlanes.row(voxelPlanes_c::FILLED, x-xa, y-ya, z-za, len) &
+                     vb->bitPlanes.row(voxelPlanes_c::FILLED, x-xb, y-yb, z-zb, len);
+
+        for (unsigned int i = 0; f; i++, f >>= 1)
+          if (f & 1) {
+            set(x+i, y, z, VX_FILLED);
+            result = true;
+          }
+      }
 
   return result;
 }
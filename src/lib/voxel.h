@@ -25,6 +25,7 @@
 #include "symmetries.h"
 #include "gridtype.h"
 #include "types.h"
+#include "voxelplanes.h"
 
 #include <stdio.h>
 #include <string>
@@ -50,6 +51,8 @@ class Polyhedron;
  */
 class voxel_c {
 
+  friend class voxelEdit_c;
+
 protected:
 
   /**
@@ -75,6 +78,12 @@ protected:
    */
   voxel_type * space;
 
+  /**
+   * The voxels of space as bit planes.
+   * Every function that changes space must update the planes as well
+   */
+  voxelPlanes_c bitPlanes;
+
   /** \page BoundingBox Bounding Box
    *
    * A bounding box is a box that encloses the non-empty voxels within a voxel space.
@@ -158,6 +167,15 @@ protected:
    */
   int * BbHsCache;
 
+  /**
+   * Counts the changes of the shape.
+   *
+   * Every change of the voxels or the hotspot increases the value. Caches
+   * of transformed copies of the shape, like shapeCache_c, compare it to
+   * find out whether their copies are still up to date
+   */
+  unsigned int changeCount;
+
 protected:
 
   /**
@@ -175,6 +193,20 @@ protected:
    */
   void recalcBoundingBox(void);
 
+private:
+
+  /**
+   * change one voxel. When voxels are only added the bounding box is
+   * extended, only when a voxel on the border of the box is emptied the
+   * whole box is recalculated. Nothing is done with the box, when doRecalc is false
+   */
+  void setVoxel(unsigned int x, unsigned int y, unsigned int z, voxel_type val);
+
+protected:
+
+  /** clear the bounding box and hotspot cache, this also counts as a change of the shape */
+  void clearBbHsCache(void);
+
 public:
 
   /**
@@ -199,6 +231,8 @@ public:
    * and then update the box after all is finished. This can be done here
    * call this function with skipit = true at the start of such a block of
    * operations and at the end call it with skipit = false
+   *
+   * Use a voxelEdit_c to do this, it can not forget the second call
    */
   void skipRecalcBoundingBox(bool skipit) {
     if (skipit)
@@ -324,6 +358,9 @@ public:
     return space[p];
   }
 
+  /** get the voxels as bit planes for checking many voxels at once */
+  const voxelPlanes_c & getPlanes(void) const { return bitPlanes; }
+
   /**
    * returns true, if a neighbour of the given
    * voxel has the given value
@@ -348,8 +385,7 @@ public:
    * the x, y, z variant of the set function.
    */
   void set(unsigned int x, unsigned int y, unsigned int z, voxel_type val) {
-    space[getIndex(x, y, z)] = val;
-    recalcBoundingBox();
+    setVoxel(x, y, z, val);
     symmetries = symmetryInvalid();
   }
 
@@ -358,8 +394,7 @@ public:
    */
   void set(unsigned int p, voxel_type val) {
     bt_assert(p<voxels);
-    space[p] = val;
-    recalcBoundingBox();
+    setVoxel(p % sx, (p / sx) % sy, p / (sx*sy), val);
     symmetries = symmetryInvalid();
   }
 
@@ -368,6 +403,7 @@ public:
    */
   void setAll(voxel_type val) {
     memset(space, val, voxels);
+    bitPlanes.load(space);
     recalcBoundingBox();
     symmetries = symmetryInvalid();
   }
@@ -467,6 +503,17 @@ public:
    */
   unsigned char getMirrorTransform(const voxel_c * op) const;
 
+  /**
+   * Check, if this shape fits into result when moved by x, y and z.
+   *
+   * All filled voxels of this shape must be on non empty voxels of result. When
+   * exact is true, all filled voxels of result inside of the moved bounding box
+   * of this shape must also be covered by non empty voxels of this shape.
+   * The moved bounding box must be inside of the space of result. Colours are
+   * not checked.
+   */
+  bool fitsInto(const voxel_c * result, int x, int y, int z, bool exact) const;
+
   /**
    * resizes the voxelspace. preserving the lower part
    * of the data, when the new one is smaller and
@@ -672,6 +719,9 @@ public:
    */
   bool getHotspot(unsigned char trans, int * x, int * y, int * z) const;
 
+  /** the number of changes of the shape so far, see \ref changeCount */
+  unsigned int getChangeCount(void) const { return changeCount; }
+
   /** function to get the name */
   const std::string & getName(void) const { return name; }
 
@@ -766,6 +816,36 @@ private:
 
 };
 
+/**
+ * Bundles many changes of a voxel space.
+ *
+ * As long as the object exists the bounding box of the space is not updated
+ * with each changed voxel. That is done once, when the object is destroyed,
+ * so changing many voxels doesn't take time proportional to the number of
+ * voxels times the size of the space. Edits may be nested, only the
+ * outermost one updates the box
+ */
+class voxelEdit_c {
+
+  private:
+
+    voxel_c & space;
+
+    /** is this the outermost edit of the space */
+    bool outer;
+
+  public:
+
+    voxelEdit_c(voxel_c & v) : space(v), outer(v.doRecalc) { space.skipRecalcBoundingBox(true); }
+    ~voxelEdit_c(void) { if (outer) space.skipRecalcBoundingBox(false); }
+
+  private:
+
+    // no copying and assigning
+    voxelEdit_c(const voxelEdit_c&);
+    void operator=(const voxelEdit_c&);
+};
+
 /* some defines used for the flags of the faces of the generated meshes
  */
 
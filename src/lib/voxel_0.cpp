@@ -75,22 +75,29 @@ bool voxel_0_c::transform(unsigned int nr) {
   voxel_type * s = new voxel_type[nsx*nsy*nsz];
   memset(s, VX_EMPTY, nsx*nsy*nsz);
 
-  unsigned int index = 0;
+  /* the bit planes show which voxels are not 0, so the others can be skipped
+   * up to 64 at a time
+   */
   for (unsigned int z = 0; z < sz; z++)
     for (unsigned int y = 0; y < sy; y++)
-      for (unsigned int x = 0; x < sx; x++) {
-        if (space[index]) {
-          tx = rotationMatrices[nr][0]*x + rotationMatrices[nr][1]*y + rotationMatrices[nr][2]*z + shx;
-          ty = rotationMatrices[nr][3]*x + rotationMatrices[nr][4]*y + rotationMatrices[nr][5]*z + shy;
-          tz = rotationMatrices[nr][6]*x + rotationMatrices[nr][7]*y + rotationMatrices[nr][8]*z + shz;
+      for (unsigned int x0 = 0; x0 < sx; x0 += 64) {
 
-          bt_assert(tx >= 0);
-          bt_assert(ty >= 0);
-          bt_assert(tz >= 0);
+        unsigned int len = (sx-x0 < 64) ? sx-x0 : 64;
 
-          s[tx + nsx*(ty + nsy*tz)] = space[index];
-        }
-        index++;
+        uint64_t used = bitPlanes.nonEmpty(x0, y, z, len) | bitPlanes.row(voxelPlanes_c::COLOURED, x0, y, z, len);
+
+        for (unsigned int x = x0; used; x++, used >>= 1)
+          if (used & 1) {
+            tx = rotationMatrices[nr][0]*x + rotationMatrices[nr][1]*y + rotationMatrices[nr][2]*z + shx;
+            ty = rotationMatrices[nr][3]*x + rotationMatrices[nr][4]*y + rotationMatrices[nr][5]*z + shy;
+            tz = rotationMatrices[nr][6]*x + rotationMatrices[nr][7]*y + rotationMatrices[nr][8]*z + shz;
+
+            bt_assert(tx >= 0);
+            bt_assert(ty >= 0);
+            bt_assert(tz >= 0);
+
+            s[tx + nsx*(ty + nsy*tz)] = space[x + sx*(y + sy*z)];
+          }
       }
 
   delete [] space;
@@ -100,6 +107,8 @@ bool voxel_0_c::transform(unsigned int nr) {
   sy = nsy;
   sz = nsz;
 
+  bitPlanes.init(sx, sy, sz, space);
+
   // update hotspot
   int thx = rotationMatrices[nr][0]*hx + rotationMatrices[nr][1]*hy + rotationMatrices[nr][2]*hz + shx;
   int thy = rotationMatrices[nr][3]*hx + rotationMatrices[nr][4]*hy + rotationMatrices[nr][5]*hz + shy;
@@ -134,6 +143,7 @@ bool voxel_0_c::transform(unsigned int nr) {
 #undef MAX
 
   symmetries = symmetryInvalid();
+  clearBbHsCache();
 
   return true;
 }
@@ -243,6 +253,8 @@ void voxel_0_c::scale(unsigned int amount, bool grid)
 
   hx = hy = hz = 0;
 
+  bitPlanes.init(sx, sy, sz, space);
+
   recalcBoundingBox();
 }
 
@@ -294,6 +306,8 @@ bool voxel_0_c::scaleDown(unsigned char by, bool action) {
 
             voxels = sx*sy*sz;
 
+            bitPlanes.init(sx, sy, sz, space);
+
             recalcBoundingBox();
           }
 
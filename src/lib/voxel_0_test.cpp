@@ -20,6 +20,7 @@
  */
 #include "voxel_0.h"
 #include "gridtype.h"
+#include <stdlib.h>
 #include <boost/test/unit_test.hpp>
 
 BOOST_AUTO_TEST_CASE( voxel_0_test )
@@ -34,3 +35,103 @@ BOOST_AUTO_TEST_CASE( voxel_0_test )
 
 }
 
+
+/* the bounding box kept up to date with each set must be the one a complete
+ * recalculation gives, the copy is recalculated by an edit
+ */
+BOOST_AUTO_TEST_CASE( voxel_0_bounding_box_test )
+{
+  gridType_c gt(gridType_c::GT_BRICKS);
+
+  srand(2);
+
+  for (unsigned int i = 0; i < 100; i++) {
+
+    voxel_0_c v(1 + rand() % 5, 1 + rand() % 5, 1 + rand() % 5, &gt, (rand() % 2) ? voxel_c::VX_EMPTY : voxel_c::VX_FILLED);
+
+    for (unsigned int j = 0; j < 100; j++) {
+
+      switch (rand() % 4) {
+        case 0: v.setState(rand() % v.getXYZ(), voxel_c::VX_FILLED); break;
+        case 1: v.set(rand() % v.getXYZ(), voxel_c::VX_VARIABLE | (rand() % 3) << 2); break;
+        default: v.setState(rand() % v.getXYZ(), voxel_c::VX_EMPTY); break;
+      }
+
+      voxel_0_c w(&v);
+      { voxelEdit_c edit(w); }
+
+      BOOST_CHECK( v.boundX1() == w.boundX1() && v.boundX2() == w.boundX2() );
+      BOOST_CHECK( v.boundY1() == w.boundY1() && v.boundY2() == w.boundY2() );
+      BOOST_CHECK( v.boundZ1() == w.boundZ1() && v.boundZ2() == w.boundZ2() );
+      BOOST_CHECK( v == w );
+    }
+  }
+}
+
+/* the bit planes must always show the same voxels as the voxel array */
+static bool planesMatch(const voxel_c & v) {
+
+  const voxelPlanes_c & p = v.getPlanes();
+
+  for (unsigned int z = 0; z < v.getZ(); z++)
+    for (unsigned int y = 0; y < v.getY(); y++)
+      for (unsigned int x = 0; x < v.getX(); x++)
+        if (p.row(voxelPlanes_c::FILLED, x, y, z, 1) != (uint64_t)v.isFilled(x, y, z) ||
+            p.row(voxelPlanes_c::VARIABLE, x, y, z, 1) != (uint64_t)v.isVariable(x, y, z) ||
+            p.row(voxelPlanes_c::COLOURED, x, y, z, 1) != (uint64_t)(v.getColor(x, y, z) != 0))
+          return false;
+
+  return true;
+}
+
+BOOST_AUTO_TEST_CASE( voxel_0_planes_test )
+{
+  gridType_c gt(gridType_c::GT_BRICKS);
+
+  srand(3);
+
+  for (unsigned int i = 0; i < 50; i++) {
+
+    // some shapes are wider than one word of the planes
+    voxel_0_c v(1 + rand() % 70, 1 + rand() % 4, 1 + rand() % 4, &gt);
+
+    for (unsigned int j = 0; j < 200; j++) {
+
+      switch (rand() % 8) {
+        case 0: v.transform(rand() % 24); break;
+        case 1: v.resize(v.getX() + rand() % 3, v.getY(), v.getZ() + 1 - rand() % 2, voxel_c::VX_EMPTY); break;
+        case 2: v.translate(rand() % 3 - 1, rand() % 3 - 1, 0, voxel_c::VX_EMPTY); break;
+        case 3: v.set(rand() % v.getXYZ(), voxel_c::VX_VARIABLE | (rand() % 3) << 2); break;
+        case 4: v.setState(rand() % v.getXYZ(), voxel_c::VX_EMPTY); break;
+        default: v.setState(rand() % v.getXYZ(), voxel_c::VX_FILLED); break;
+      }
+
+      BOOST_CHECK( planesMatch(v) );
+    }
+
+    unsigned int filled = 0;
+    for (unsigned int j = 0; j < v.getXYZ(); j++)
+      if (v.isFilled(j))
+        filled++;
+
+    BOOST_CHECK( v.countState(voxel_c::VX_FILLED) == filled );
+
+    // a copy moved within a bigger space is identical and fits exactly into the original
+    voxel_0_c w(&v);
+    w.resize(w.getX() + 70, w.getY() + 1, w.getZ(), voxel_c::VX_EMPTY);
+    w.translate(65, 1, 0, voxel_c::VX_EMPTY);
+
+    BOOST_CHECK( planesMatch(w) );
+    BOOST_CHECK( v.identicalInBB(&w) && w.identicalInBB(&v) );
+    BOOST_CHECK( v.fitsInto(&w, 65, 1, 0, true) );
+
+    // removing a filled voxel of the copy breaks both
+    for (unsigned int j = 0; j < w.getXYZ(); j++)
+      if (w.isFilled(j)) {
+        w.setState(j, voxel_c::VX_EMPTY);
+
+        BOOST_CHECK( !v.identicalInBB(&w) );
+        break;
+      }
+  }
+}
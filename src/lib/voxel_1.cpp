@@ -139,6 +139,10 @@ bool voxel_1_c::transform(unsigned int nr) {
   voxel_type *s = new voxel_type[voxelsn];
   memset(s, VX_EMPTY, voxelsn);
 
+  // the loop only reads the old voxels, so the planes can already get the new size
+  // and be filled with the new voxels
+  bitPlanes.init(nsx, nsy, nsz);
+
   index = 0;
   for (unsigned int z = 0; z < sz; z++)
     for (unsigned int y = 0; y < sy; y++)
@@ -169,6 +173,7 @@ bool voxel_1_c::transform(unsigned int nr) {
           int zn = (int)(zpn+(zpn<0?-0.5:0.5));
 
           s[(xn-minx) + nsx*((yn-miny) + nsy*(zn-minz))] = space[index];
+          bitPlanes.set(xn-minx, yn-miny, zn-minz, space[index]);
         }
         index++;
       }
@@ -208,6 +213,7 @@ bool voxel_1_c::transform(unsigned int nr) {
   recalcBoundingBox();
 
   symmetries = symmetryInvalid();
+  clearBbHsCache();
 
   return true;
 }
@@ -370,6 +376,8 @@ void voxel_1_c::scale(unsigned int amount, bool grid)
 
   voxels = sx*sy*sz;
 
+  bitPlanes.init(sx, sy, sz, space);
+
   recalcBoundingBox();
 }
 
@@ -153,6 +153,10 @@ bool voxel_2_c::transform(unsigned int nr) {
   voxel_type *s = new voxel_type[voxelsn];
   memset(s, VX_EMPTY, voxelsn);
 
+  // the loop only reads the old voxels, so the planes can already get the new size
+  // and be filled with the new voxels
+  bitPlanes.init(nsx, nsy, nsz);
+
   index = 0;
   for (unsigned int z = 0; z < sz; z++)
     for (unsigned int y = 0; y < sy; y++)
@@ -185,6 +189,7 @@ bool voxel_2_c::transform(unsigned int nr) {
             int zn = (int)(zpn+(zpn<0?-0.5:0.5));
 
             s[(xn-minx) + nsx*((yn-miny) + nsy*(zn-minz))] = space[index];
+            bitPlanes.set(xn-minx, yn-miny, zn-minz, space[index]);
           }
         }
         index++;
@@ -229,6 +234,7 @@ bool voxel_2_c::transform(unsigned int nr) {
   recalcBoundingBox();
 
   symmetries = symmetryInvalid();
+  clearBbHsCache();
 
   return true;
 }
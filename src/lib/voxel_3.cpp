@@ -445,6 +445,8 @@ void voxel_3_c::scale(unsigned int amount, bool grid) {
 
   voxels = sx*sy*sz;
 
+  bitPlanes.init(sx, sy, sz, space);
+
   recalcBoundingBox();
 }
 
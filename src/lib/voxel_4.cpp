@@ -292,6 +292,8 @@ void voxel_4_c::scale(unsigned int amount, bool /*grid*/) {
 
   voxels = sx*sy*sz;
 
+  bitPlanes.init(sx, sy, sz, space);
+
   recalcBoundingBox();
 
 }
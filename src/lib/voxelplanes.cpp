@@ -0,0 +1,152 @@
+/* BurrTools
+ *
+ * BurrTools is the legal property of its developers, whose
+ * names are listed in the COPYRIGHT file, which is included
+ * within the source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+#include "voxelplanes.h"
+
+#include "voxel.h"
+
+void voxelPlanes_c::init(unsigned int x, unsigned int y, unsigned int z, const voxel_type * space) {
+
+  sx = x;
+  sy = y;
+  sz = z;
+
+  words = (sx + 63) / 64;
+  planeSize = words * sy * sz;
+
+  if (space) {
+    bits.resize(NUM_PLANES * planeSize);
+    load(space);
+  } else {
+    bits.assign(NUM_PLANES * planeSize, 0);
+  }
+}
+
+/* the bits 0 of the 8 bytes of v as one byte, bit i comes from byte i */
+static uint64_t gather(uint64_t v) {
+  return ((v & 0x0101010101010101ULL) * 0x0102040810204080ULL) >> 56;
+}
+
+void voxelPlanes_c::load(const voxel_type * space) {
+
+  uint64_t * f = planeSize ? &bits[0] : 0;
+  uint64_t * v = f + planeSize;
+  uint64_t * c = v + planeSize;
+
+  /* the words are assembled in local variables, so each one is written only once */
+  for (unsigned int r = 0; r < sy*sz; r++)
+    for (unsigned int w = 0; w < words; w++) {
+
+      uint64_t fw = 0, vw = 0, cw = 0;
+      unsigned int end = (sx - 64*w < 64) ? sx - 64*w : 64;
+      unsigned int i = 0;
+
+      /* 8 voxels are handled together, with one byte per voxel, the state
+       * bits of filled voxels are 01, after an xor with 10 both bits are set,
+       * the same works for variable voxels with 01, the colour is tested by
+       * adding 0x7f to the colour bits, which sets bit 7 for all colours but 0
+       */
+      for (; i + 8 <= end; i += 8, space += 8) {
+
+        uint64_t chunk = (uint64_t)space[0]       | (uint64_t)space[1] <<  8 |
+                         (uint64_t)space[2] << 16 | (uint64_t)space[3] << 24 |
+                         (uint64_t)space[4] << 32 | (uint64_t)space[5] << 40 |
+                         (uint64_t)space[6] << 48 | (uint64_t)space[7] << 56;
+
+        if (!chunk) continue;
+
+        uint64_t st = chunk & 0x0303030303030303ULL;
+        uint64_t fs = st ^ 0x0202020202020202ULL;
+        uint64_t vs = st ^ 0x0101010101010101ULL;
+
+        fw |= gather(fs & (fs >> 1)) << i;
+        vw |= gather(vs & (vs >> 1)) << i;
+        cw |= gather((((chunk >> 2) & 0x3f3f3f3f3f3f3f3fULL) + 0x7f7f7f7f7f7f7f7fULL) >> 7) << i;
+      }
+
+      for (; i < end; i++, space++) {
+
+        uint64_t bit = (uint64_t)1 << i;
+
+        switch (*space & 3) {
+          case voxel_c::VX_FILLED: fw |= bit; break;
+          case voxel_c::VX_VARIABLE: vw |= bit; break;
+        }
+
+        if (*space >> 2) cw |= bit;
+      }
+
+      *f++ = fw;
+      *v++ = vw;
+      *c++ = cw;
+    }
+}
+
+unsigned int voxelPlanes_c::count(unsigned int p) const {
+
+  bt_assert(p < NUM_PLANES);
+
+  unsigned int cnt = 0;
+
+  for (unsigned int i = p*planeSize; i < (p+1)*planeSize; i++) {
+
+    uint64_t s = bits[i];
+
+    s -= ((s >> 1) & 0x5555555555555555ll);
+    s = (((s >> 2) & 0x3333333333333333ll) + (s & 0x3333333333333333ll));
+    s = (((s >> 4) + s) & 0x0f0f0f0f0f0f0f0fll);
+    s += (s >> 8);
+    s += (s >> 16);
+    s += (s >> 32);
+
+    cnt += (unsigned int)(s & 0x7f);
+  }
+
+  return cnt;
+}
+
+bool voxelPlanes_c::equalBox(const voxelPlanes_c & op, unsigned int num,
+                             unsigned int x, unsigned int y, unsigned int z,
+                             unsigned int ox, unsigned int oy, unsigned int oz,
+                             unsigned int xs, unsigned int ys, unsigned int zs) const {
+
+  bt_assert(x+xs <= sx && y+ys <= sy && z+zs <= sz);
+  bt_assert(ox+xs <= op.sx && oy+ys <= op.sy && oz+zs <= op.sz);
+
+  bt_assert(num <= NUM_PLANES);
+
+  for (unsigned int p = 0; p < num; p++)
+    for (unsigned int dz = 0; dz < zs; dz++)
+      for (unsigned int dy = 0; dy < ys; dy++) {
+
+        const uint64_t * a = rowStart(p, x, y+dy, z+dz);
+        const uint64_t * b = op.rowStart(p, ox, oy+dy, oz+dz);
+
+        for (unsigned int dx = 0; dx < xs; dx += 64, a++, b++) {
+
+          unsigned int len = (xs - dx < 64) ? xs - dx : 64;
+
+          if (extract(a, x & 63, len) != extract(b, ox & 63, len))
+            return false;
+        }
+      }
+
+  return true;
+}
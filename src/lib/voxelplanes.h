@@ -0,0 +1,131 @@
+/* BurrTools
+ *
+ * BurrTools is the legal property of its developers, whose
+ * names are listed in the COPYRIGHT file, which is included
+ * within the source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+#ifndef __VOXELPLANES_H__
+#define __VOXELPLANES_H__
+
+#include "types.h"
+#include "bt_assert.h"
+
+#include <vector>
+
+/**
+ * The voxels of a voxel space as bit planes.
+ *
+ * There are 3 planes with one bit per voxel: the filled voxels, the variable
+ * voxels and the voxels that have a colour. Each plane consists of rows along
+ * the x axis, a row takes as many 64 bit words as required, the unused bits of the
+ * last word of a row are always 0.
+ *
+ * With the planes up to 64 voxels can be checked with one operation. voxel_c keeps
+ * its planes in sync with the voxels, so they can always be used.
+ */
+class voxelPlanes_c {
+
+  public:
+
+    /** the available planes */
+    enum {
+      FILLED,     ///< the voxels in state VX_FILLED
+      VARIABLE,   ///< the voxels in state VX_VARIABLE
+      COLOURED,   ///< the voxels with a colour other than 0
+      NUM_PLANES
+    };
+
+  private:
+
+    unsigned int sx, sy, sz;   ///< the size of the space
+    unsigned int words;        ///< the number of words of one row
+    unsigned int planeSize;    ///< the number of words of one plane
+
+    /** all planes, one after the other */
+    std::vector<uint64_t> bits;
+
+    const uint64_t * rowStart(unsigned int p, unsigned int x, unsigned int y, unsigned int z) const {
+      return &bits[p*planeSize + (y + sy*z)*words + x/64];
+    }
+
+    /** len bits starting at bit s of the word w, continuing into the following word */
+    static uint64_t extract(const uint64_t * w, unsigned int s, unsigned int len) {
+
+      uint64_t r = w[0] >> s;
+      if (s + len > 64) r |= w[1] << (64 - s);
+
+      return (len < 64) ? r & (((uint64_t)1 << len) - 1) : r;
+    }
+
+  public:
+
+    voxelPlanes_c(void) : sx(0), sy(0), sz(0), words(0), planeSize(0) {}
+
+    /**
+     * Change the size of the planes to x, y, z and set the bits from the given voxels.
+     * Without voxels all bits are cleared
+     */
+    void init(unsigned int x, unsigned int y, unsigned int z, const voxel_type * space = 0);
+
+    /** set all bits from the given voxels, the array must have the size of the planes */
+    void load(const voxel_type * space);
+
+    /** update the bits of one voxel to the given value */
+    void set(unsigned int x, unsigned int y, unsigned int z, voxel_type val) {
+
+      bt_assert(x < sx && y < sy && z < sz);
+
+      uint64_t * w = &bits[(y + sy*z)*words + x/64];
+      unsigned int s = x & 63;
+      uint64_t bit = (uint64_t)1 << s;
+
+      // the lower 2 bits of a voxel are the state, 1 is VX_FILLED and 2 is VX_VARIABLE
+      w[0]           = (w[0] & ~bit)           | (uint64_t)((val & 3) == 1) << s;
+      w[planeSize]   = (w[planeSize] & ~bit)   | (uint64_t)((val & 3) == 2) << s;
+      w[2*planeSize] = (w[2*planeSize] & ~bit) | (uint64_t)(val > 3) << s;
+    }
+
+    /**
+     * Return the bits of plane p for the voxels x to x+len-1 of the row at y and z.
+     * Bit 0 is the voxel at x. len must be between 1 and 64 and the voxels must be
+     * inside of the space.
+     */
+    uint64_t row(unsigned int p, unsigned int x, unsigned int y, unsigned int z, unsigned int len) const {
+      return extract(rowStart(p, x, y, z), x & 63, len);
+    }
+
+    /** the bits of the filled and the variable plane combined */
+    uint64_t nonEmpty(unsigned int x, unsigned int y, unsigned int z, unsigned int len) const {
+      return row(FILLED, x, y, z, len) | row(VARIABLE, x, y, z, len);
+    }
+
+    /** the number of set bits in plane p */
+    unsigned int count(unsigned int p) const;
+
+    /**
+     * Compare the box with the lower corner at x, y, z and the size xs, ys, zs
+     * with the box of the same size at ox, oy, oz in op. The first num planes
+     * are compared in the order of the enumeration. Both boxes must be inside
+     * of their spaces.
+     */
+    bool equalBox(const voxelPlanes_c & op, unsigned int num,
+                  unsigned int x, unsigned int y, unsigned int z,
+                  unsigned int ox, unsigned int oy, unsigned int oz,
+                  unsigned int xs, unsigned int ys, unsigned int zs) const;
+};
+
+#endif
@@ -0,0 +1,144 @@
+/* BurrTools
+ *
+ * BurrTools is the legal property of its developers, whose
+ * names are listed in the COPYRIGHT file, which is included
+ * within the source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+#include "voxelrows.h"
+
+#include "voxel.h"
+
+voxelRows_c::voxelRows_c(const voxel_c * shape) :
+  x1(shape->boundX1()), y1(shape->boundY1()), z1(shape->boundZ1()),
+  ys(shape->boundY2()-shape->boundY1()+1), zs(shape->boundZ2()-shape->boundZ1()+1),
+  wide(shape->boundX2()-shape->boundX1()+1 > 64)
+{
+  if (wide) return;
+
+  filledRows.resize(ys*zs);
+  nonEmptyRows.resize(ys*zs);
+
+  const voxelPlanes_c & planes = shape->getPlanes();
+  unsigned int xs = shape->boundX2()-shape->boundX1()+1;
+
+  for (int z = 0; z < zs; z++)
+    for (int y = 0; y < ys; y++) {
+      filledRows[z*ys+y] = planes.row(voxelPlanes_c::FILLED, x1, y+y1, z+z1, xs);
+      nonEmptyRows[z*ys+y] = planes.nonEmpty(x1, y+y1, z+z1, xs);
+    }
+}
+
+static int min(int a, int b) { if (a < b) return a; else return b; }
+static int max(int a, int b) { if (a > b) return a; else return b; }
+
+rowFrame_c::rowFrame_c(const voxel_c * sh1, const voxelRows_c & r1, bool nonEmpty,
+                       const voxel_c * sh2, const voxelRows_c & r2, int dx, int dy, int dz) : a(0), b(0)
+{
+  x0 = min(sh1->boundX1(), sh2->boundX1() + dx);
+  y0 = min(sh1->boundY1(), sh2->boundY1() + dy);
+  z0 = min(sh1->boundZ1(), sh2->boundZ1() + dz);
+
+  xs = max(sh1->boundX2(), sh2->boundX2() + dx) - x0 + 1;
+  ys = max(sh1->boundY2(), sh2->boundY2() + dy) - y0 + 1;
+  zs = max(sh1->boundZ2(), sh2->boundZ2() + dz) - z0 + 1;
+
+  wide = !r1.fits() || !r2.fits() || xs > 64;
+
+  if (wide) return;
+
+  ab[0] = sh1->boundX1() - x0;      ab[3] = sh1->boundX2() - x0;
+  ab[1] = sh1->boundY1() - y0;      ab[4] = sh1->boundY2() - y0;
+  ab[2] = sh1->boundZ1() - z0;      ab[5] = sh1->boundZ2() - z0;
+  bb[0] = sh2->boundX1() + dx - x0; bb[3] = sh2->boundX2() + dx - x0;
+  bb[1] = sh2->boundY1() + dy - y0; bb[4] = sh2->boundY2() + dy - y0;
+  bb[2] = sh2->boundZ1() + dz - z0; bb[5] = sh2->boundZ2() + dz - z0;
+
+  if (ys*zs <= bufferRows) {
+    a = buffer;
+  } else {
+    big.resize(2*ys*zs);
+    a = &big[0];
+  }
+  b = a + ys*zs;
+
+  /* only the rows inside of the bounding boxes are ever used, so
+   * the others are left uninitialised
+   */
+  for (int z = ab[2]; z <= ab[5]; z++)
+    for (int y = ab[1]; y <= ab[4]; y++)
+      a[z*ys+y] = (nonEmpty ? r1.nonEmpty(y+y0, z+z0) : r1.filled(y+y0, z+z0)) << ab[0];
+
+  for (int z = bb[2]; z <= bb[5]; z++)
+    for (int y = bb[1]; y <= bb[4]; y++)
+      b[z*ys+y] = r2.filled(y+y0-dy, z+z0-dz) << bb[0];
+}
+
+void rowFrame_c::removeOverlap(void) {
+
+  for (int z = max(ab[2], bb[2]); z <= min(ab[5], bb[5]); z++)
+    for (int y = max(ab[1], bb[1]); y <= min(ab[4], bb[4]); y++)
+      b[z*ys+y] &= ~a[z*ys+y];
+}
+
+bool rowFrame_c::overlap(int tx, int ty, int tz, int parity) const {
+
+  bt_assert(!wide);
+
+  /* the moved bounding box of the first shape must intersect the box of the 2nd shape,
+   * only the rows inside of the intersection need to be checked
+   */
+  if (ab[0]+tx > bb[3] || ab[3]+tx < bb[0]) return false;
+
+  int ylo = max(ab[1], bb[1]-ty), yhi = min(ab[4], bb[4]-ty);
+  int zlo = max(ab[2], bb[2]-tz), zhi = min(ab[5], bb[5]-tz);
+
+  if (ylo > yhi || zlo > zhi) return false;
+
+  /* the masks for the voxels of the requested parity in even and odd rows,
+   * bit i is at x0+i
+   */
+  uint64_t mask[2];
+
+  if (parity < 0) {
+    mask[0] = mask[1] = ~(uint64_t)0;
+  } else {
+    mask[0] = ((parity - x0) & 1) ? 0xAAAAAAAAAAAAAAAAULL : 0x5555555555555555ULL;
+    mask[1] = ~mask[0];
+  }
+
+  for (int z = zlo; z <= zhi; z++) {
+
+    const uint64_t * ra = a + z*ys;
+    const uint64_t * rb = b + (z+tz)*ys + ty;
+
+    /* the whole plane is combined before checking, without the branch the
+     * compiler can work on several rows at once
+     */
+    uint64_t hit = 0;
+
+    if (tx >= 0)
+      for (int y = ylo; y <= yhi; y++)
+        hit |= ((ra[y] & mask[(y+y0) & 1]) << tx) & rb[y];
+    else
+      for (int y = ylo; y <= yhi; y++)
+        hit |= ((ra[y] & mask[(y+y0) & 1]) >> -tx) & rb[y];
+
+    if (hit) return true;
+  }
+
+  return false;
+}
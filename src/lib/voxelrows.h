@@ -0,0 +1,138 @@
+/* BurrTools
+ *
+ * BurrTools is the legal property of its developers, whose
+ * names are listed in the COPYRIGHT file, which is included
+ * within the source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+#ifndef __VOXELROWS_H__
+#define __VOXELROWS_H__
+
+#include "types.h"
+
+#include <vector>
+
+class voxel_c;
+
+/**
+ * The voxels of a shape as bit rows along the x axis.
+ *
+ * For each y and z coordinate inside the bounding box of the shape there is
+ * one 64 bit word, bit i is set when the voxel at x = boundX1 + i is set. There are
+ * 2 sets of rows, one for the filled voxels and one for all non empty voxels.
+ * They are cut out of the bit planes of the shape.
+ *
+ * Shapes that are more than 64 voxels wide can not be represented, fits returns
+ * false for those.
+ *
+ * The rows are used by the movement caches to check many voxels with one
+ * operation. The shape must not be changed as long as the rows are used.
+ */
+class voxelRows_c {
+
+  private:
+
+    int x1, y1, z1;   ///< the lower corner of the bounding box of the shape
+    int ys, zs;       ///< the size of the bounding box in y and z direction
+    bool wide;        ///< true, when the shape is too wide for 64 bit rows
+
+    std::vector<uint64_t> filledRows;   ///< the rows of filled voxels
+    std::vector<uint64_t> nonEmptyRows; ///< the rows of all non empty voxels
+
+  public:
+
+    voxelRows_c(const voxel_c * shape);
+
+    /** true, when the shape could be represented in rows */
+    bool fits(void) const { return !wide; }
+
+    /** the row of filled voxels at the given position, 0 outside of the bounding box */
+    uint64_t filled(int y, int z) const {
+      y -= y1; z -= z1;
+      return (y >= 0 && y < ys && z >= 0 && z < zs) ? filledRows[z*ys+y] : 0;
+    }
+
+    /** the row of non empty voxels at the given position, 0 outside of the bounding box */
+    uint64_t nonEmpty(int y, int z) const {
+      y -= y1; z -= z1;
+      return (y >= 0 && y < ys && z >= 0 && z < zs) ? nonEmptyRows[z*ys+y] : 0;
+    }
+};
+
+/**
+ * The rows of 2 shapes placed relative to one another in a common frame, that is the
+ * union of the bounding boxes of the 2 shapes.
+ *
+ * The first shape is the one that moves, the frame allows to check, if the first shape
+ * touches the second shape, when it is moved by a certain vector. The check works on
+ * whole rows at a time, so a lot faster than checking voxel by voxel.
+ */
+class rowFrame_c {
+
+  private:
+
+    int x0, y0, z0;        ///< the lower corner of the frame in the coordinates of the first shape
+    int xs, ys, zs;        ///< the size of the frame
+    bool wide;             ///< true, when the frame doesn't fit into 64 bit rows
+
+    int ab[6];             ///< the bounding box of the first shape within the frame, lower corner first
+    int bb[6];             ///< the bounding box of the 2nd shape within the frame
+
+    /** most frames are small, those use the buffer, bigger ones the vector */
+    enum { bufferRows = 256 };
+
+    uint64_t buffer[2*bufferRows];
+    std::vector<uint64_t> big;
+
+    uint64_t * a; ///< the rows of the first shape
+    uint64_t * b; ///< the rows of the second shape
+
+  public:
+
+    /**
+     * create the frame, the 2nd shape is at position dx, dy, dz relative to the first shape.
+     * When nonEmpty is true, all non empty voxels of the first shape are taken, otherwise only the
+     * filled voxels. The filled voxels of the 2nd shape are taken
+     */
+    rowFrame_c(const voxel_c * sh1, const voxelRows_c & r1, bool nonEmpty,
+               const voxel_c * sh2, const voxelRows_c & r2, int dx, int dy, int dz);
+
+    /** true, when both shapes fit into the 64 bit rows of the frame */
+    bool fits(void) const { return !wide; }
+
+    /** the size of the frame */
+    int sizeX(void) const { return xs; }
+    int sizeY(void) const { return ys; }
+    int sizeZ(void) const { return zs; }
+
+    /** remove voxels from the 2nd shape that are also used by the first shape */
+    void removeOverlap(void);
+
+    /**
+     * check, if the first shape overlaps the 2nd shape, when it is moved by tx, ty and tz.
+     * When parity is 0 or 1, only the voxels of the first shape with (x+y)%2 == parity
+     * are checked, -1 checks all voxels
+     */
+    bool overlap(int tx, int ty, int tz, int parity = -1) const;
+
+  private:
+
+    // no copying and assigning
+    rowFrame_c(const rowFrame_c&);
+    void operator=(const rowFrame_c&);
+};
+
+#endif
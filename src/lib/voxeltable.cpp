@@ -22,6 +22,7 @@
 
 #include "voxel.h"
 #include "puzzle.h"
+#include "shapecache.h"
 
 voxelTable_c::voxelTable_c(void)
 {
@@ -32,6 +33,8 @@ voxelTable_c::voxelTable_c(void)
     hashTable[i] = 0;
 
   tableEntries = 0;
+
+  transformed = 0;
 }
 
 voxelTable_c::~voxelTable_c(void) {
@@ -47,6 +50,8 @@ voxelTable_c::~voxelTable_c(void) {
   }
 
   delete [] hashTable;
+
+  delete transformed;
 }
 
 static unsigned long calcHashValue(const voxel_c * v)
@@ -108,9 +113,8 @@ bool voxelTable_c::getSpace(const voxel_c *v, unsigned int *index, unsigned char
   {
     if (n->hash == hash && ((params & PAR_MIRROR) || (n->transformation < v->getGridType()->getSymmetries()->getNumTransformations())))
     {
-      voxel_c * v2 = v->getGridType()->getVoxel(findSpace(n->index));
-      bool found = v2->transform(n->transformation) && v->identicalInBB(v2, false);
-      delete v2;
+      const voxel_c * v2 = findTransformedSpace(n->index, n->transformation);
+      bool found = v2 && v->identicalInBB(v2, false);
 
       if (found)
       {
@@ -166,8 +170,8 @@ void voxelTable_c::addSpace(unsigned int index, unsigned int params)
     if (symm->isTransformationUnique(sym, trans)) {
       // add all transformations of the voxel space to the table, that are actually different
 
-      voxel_c * v2 = v->getGridType()->getVoxel(v);
-      if (v2->transform(trans))
+      const voxel_c * v2 = findTransformedSpace(index, trans);
+      if (v2)
       {
         unsigned long hash = (params & PAR_COLOUR) ? calcColourHashValue(v2) : calcHashValue(v2);
 
@@ -179,11 +183,28 @@ void voxelTable_c::addSpace(unsigned int index, unsigned int params)
         hashTable[hash % tableSize] = n;
         tableEntries++;
       }
-
-      delete v2;
     }
   }
 }
 
+const voxel_c * voxelTable_c::findTransformedSpace(unsigned int index, unsigned char trans) const {
+
+  const voxel_c * v = findSpace(index);
+
+  delete transformed;
+  transformed = v->getGridType()->getVoxel(v);
+
+  if (!transformed->transform(trans)) {
+    delete transformed;
+    transformed = 0;
+  }
+
+  return transformed;
+}
+
 const voxel_c * voxelTablePuzzle_c::findSpace(unsigned int index) const { return puzzle->getShape(index); }
 
+const voxel_c * voxelTablePuzzle_c::findTransformedSpace(unsigned int index, unsigned char trans) const {
+  return puzzle->getShapeCache().getShape(index, trans);
+}
+
@@ -60,6 +60,9 @@ class voxelTable_c {
     unsigned long tableSize;        //< size of the hash table
     unsigned long tableEntries;     //< number of entries in hash table
 
+    /** the last copy made by the default findTransformedSpace */
+    mutable voxel_c * transformed;
+
   public:
 
     voxelTable_c(void);
@@ -116,6 +119,16 @@ class voxelTable_c {
      */
     virtual const voxel_c * findSpace(unsigned int index) const = 0;
 
+    /**
+     * return the voxel space of the given index transformed by trans, or 0 when the
+     * space can not be transformed like that. The returned space is only used until the
+     * next call.
+     *
+     * The default transforms a copy of the space returned by findSpace, provide
+     * this function when you have the transformed spaces already
+     */
+    virtual const voxel_c * findTransformedSpace(unsigned int index, unsigned char trans) const;
+
   private:
 
     // no copying and assigning
@@ -137,6 +150,7 @@ class voxelTablePuzzle_c : public voxelTable_c {
   protected:
 
     const voxel_c * findSpace(unsigned int index) const;
+    const voxel_c * findTransformedSpace(unsigned int index, unsigned char trans) const;
 
   private:
 
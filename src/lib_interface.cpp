@@ -33,6 +33,8 @@
 #include "lib/problem.h"
 #include "lib/puzzle.h"
 #include "lib/solvethread.h"
+#include "lib/solvescheduler.h"
+#include "lib/executor.h"
 #include "tools/xml.h"
 
 #include "lib_interface.h"
@@ -133,12 +135,14 @@ extern "C"
     // --------------------------------
     
     bool solve(puzzle_c *p)
+    {
+        return solveWithThreads(p, 0);
+    }
+
+    bool solveWithThreads(puzzle_c *p, unsigned int threads)
     {
         int par = solveThread_c::PAR_REDUCE;
         bool restart = false;
-        int filenumber = 0;
-        int firstProblem = 0;
-        int lastProblem = p->getNumberOfProblems();
 
         restart = true;
         par |= solveThread_c::PAR_DISASSM;
@@ -146,27 +150,81 @@ extern "C"
         for (unsigned int i = 0; i < p->getNumberOfShapes(); i++)
             p->getShape(i)->initHotspot();
 
+        // has only an effect, when the worker pool of the library has not yet been used
+        executor_c::setSize(threads);
 
-        for (int pr = firstProblem ; pr < lastProblem ; pr++) {
+        solveScheduler_c sched(*p, par, threads);
+
+        for (unsigned int pr = 0; pr < p->getNumberOfProblems(); pr++) {
 
             if (restart)
                 p->getProblem(pr)->removeAllSolutions();
 
-            solveThread_c assmThread(*p->getProblem(pr), par);
+            sched.addProblem(pr);
+        }
+
+        sched.run();
 
-            // Initialize for new solution attempt
-            assmThread.start(false);
+        for (unsigned int j = 0; j < sched.getNumberOfJobs(); j++) {
 
-            if (assmThread.currentAction() == solveThread_c::ACT_ERROR) {
+            if (sched.getFinalAction(j) == solveThread_c::ACT_ASSERT) {
                 std::cout << "Exception in Solver\n";
-                std::cout << " file      : " << assmThread.getAssertException().file;
-                std::cout << " function  : " << assmThread.getAssertException().function;
-                std::cout << " line      : " << assmThread.getAssertException().line;
-                std::cout << " expression: " << assmThread.getAssertException().expr;
+                std::cout << " file      : " << sched.getAssertException(j).file;
+                std::cout << " function  : " << sched.getAssertException(j).function;
+                std::cout << " line      : " << sched.getAssertException(j).line;
+                std::cout << " expression: " << sched.getAssertException(j).expr;
                 return false;
             }
+
+            if (sched.getFinalAction(j) == solveThread_c::ACT_ERROR)
+                return false;
         }
 
         return true;
     }
+
+    solveThread_c * startSolve(puzzle_c *p, unsigned int problem)
+    {
+        for (unsigned int i = 0; i < p->getNumberOfShapes(); i++)
+            p->getShape(i)->initHotspot();
+
+        solveThread_c * t = new solveThread_c(*p->getProblem(problem),
+                                              solveThread_c::PAR_REDUCE | solveThread_c::PAR_DISASSM);
+
+        if (!t->start()) {
+            delete t;
+            return 0;
+        }
+
+        return t;
+    }
+
+    void getSolveMetrics(solveThread_c *t, solveMetrics_t *m)
+    {
+        solveMetrics_c::snapshot s;
+        t->getMetrics().getSnapshot(s);
+
+        m->time = s.time;
+        m->iterations = s.iterations;
+        m->assemblies = s.assemblies;
+        m->solutions = s.solutions;
+        m->disassemblies = s.disassemblies;
+        m->interlocked = s.interlocked;
+        m->nodes = s.nodes;
+        m->queueDepth = s.queueDepth;
+        m->memory = s.memory;
+        m->finished = s.finished;
+        m->phase = s.phase;
+        for (unsigned int i = 0; i < solveMetrics_c::PH_NUM; i++)
+            m->phaseTime[i] = s.phaseTime[i];
+    }
+
+    bool solveStopped(solveThread_c *t) { return !t->isRunning(); }
+    void stopSolve(solveThread_c *t) { t->stop(); }
+
+    void freeSolve(solveThread_c **t)
+    {
+        delete *t;
+        *t = 0;
+    }
 };
@@ -27,6 +27,7 @@ extern "C" {
     typedef struct solution_c solution_c;
     typedef struct problem_c problem_c;
     typedef struct puzzle_c puzzle_c;
+    typedef struct solveThread_c solveThread_c;
     typedef unsigned char bool;
 #endif
 
@@ -130,6 +131,35 @@ extern "C" {
     
     bool solve(puzzle_c *pz);
 
+    // solve all problems of the puzzle, up to threads problems at the same time, 0 means one per processor
+    bool solveWithThreads(puzzle_c *pz, unsigned int threads);
+
+    // progress of a solve running in the background, see solveMetrics_c for the meaning of the fields
+    typedef struct {
+        unsigned long long time;            // microseconds since the start
+        unsigned long long iterations;
+        unsigned long long assemblies;
+        unsigned long long solutions;
+        unsigned long long disassemblies;
+        unsigned long long interlocked;     // disassemblies rejected because nothing could move
+        unsigned long long nodes;
+        unsigned long long queueDepth;
+        unsigned long long memory;          // bytes
+        unsigned long long finished;        // millionths of the search space
+        unsigned int phase;                 // 0 preparation, 1 reduce, 2 assemble, 3 disassemble, 4 idle
+        unsigned long long phaseTime[5];    // microseconds spent in each phase
+    } solveMetrics_t;
+
+    // start solving one problem in the background, returns 0 if the thread could not be started
+    solveThread_c * startSolve(puzzle_c *pz, unsigned int problem);
+    // get the current progress, this is cheap and can be called as often as required
+    void getSolveMetrics(solveThread_c *t, solveMetrics_t *m);
+    // returns true, once the solver has stopped for whatever reason
+    bool solveStopped(solveThread_c *t);
+    void stopSolve(solveThread_c *t);
+    // wait for the solver to stop and free it
+    void freeSolve(solveThread_c **t);
+
 
 #ifdef __cplusplus
 }